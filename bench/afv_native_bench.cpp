@@ -0,0 +1,1135 @@
+/* afv_native_bench
+ *
+ * Runs a radio simulation against synthetic traffic, as fast as it will go, to measure the
+ * cost of the receive mix.
+ *
+ * N frequencies are tuned (every third one on the speaker) and M callsigns talk on them without
+ * a break, each sending one pre-encoded Opus packet per frame through rxVoicePacket() just like
+ * the voice server would.  Every fourth callsign is also heard on the next frequency up.  The
+ * headset and speaker devices are then pulled directly - there's no audio hardware involved.
+ *
+ * usage: afv_native_bench [--frequencies N] [--callsigns M] [--frames F] [--warmup F]
+ *                         [--dsp-threads T] [--ingress-thread] [--resources DIR] [--verbose]
+ *                         [--noise-bed per-radio|shared|both] [--max-decoders D]
+ *                         [--sim atc|pilot|both] [--render-budget US]
+ *                         [--dsp-rate 48k|16k|both] [--quantum Q] [--decode-threads T]
+ *
+ * --sim picks the simulation: an ATCRadioSimulation with a radio per frequency (the default),
+ * or a pilot RadioSimulation with N radios and split audio channels.
+ *
+ * --ingress-thread delivers the packets from a second thread, in lockstep with the render, so
+ * that the render has to contend for the stream lock the way it does in the client.  Without
+ * --resources the effects are played from synthetic noise.  --noise-bed both runs the
+ * benchmark once with each noise bed mode and compares them.  --max-decoders sets the decoder
+ * budget, so that callsigns beyond it are turned away or evict the furthest stream.
+ *
+ * The render governor is off unless --render-budget is given, so that it can't trade effects
+ * away in the middle of a measurement.  Given a budget, it may cap the decoders as well.
+ * Overruns are reported against the budget either way.
+ *
+ * --dsp-rate picks the rate the radios decode and render at.  With 16k, the report also
+ * compares the spectrum of each radio filter preset at both rates, through the full decode,
+ * filter, compressor and (at 16k) upsampling chain, and what a radio costs at each.
+ *
+ * --decode-threads runs the benchmark once decoding on the audio thread and once with T decode
+ * workers, and compares what the audio callback costs each way (20 callsigns, the default, is
+ * a busy position).  The render waits for the workers to catch up between frames, as they
+ * would have the rest of the frame to in real time.
+ *
+ * --quantum renders in quanta of Q samples rather than whole frames, with the devices pulled
+ * in periods of the same length.  The report also measures the output latency at 960, 480 and
+ * 240 samples: how long after a packet arrives its first sample is played, with the headset
+ * pulled like a double-buffered device would pull it.
+ *
+ * The report ends by comparing the cost of working out every stream's crackle coefficients
+ * each frame against reading the ones worked out as the packets arrived (try --callsigns 50),
+ * and by playing transmissions through a jitter buffer on a simulated network with increasing
+ * amounts of jitter, to show how quickly they start and how far behind they settle, and how
+ * many lost frames could be recovered from the next packet's FEC rather than concealed.  Last is
+ * the cost of a stream's decoder and jitter buffer coming and going, made afresh or taken from
+ * the pool.  --max-decoders below --callsigns churns the pool in the main benchmark too.
+ * Finally, each encoder profile encodes the same talk, with pauses while the PTT is held, to
+ * show what it costs to encode a frame and how many packets and bytes go upstream.
+ *
+ * Allocation counts are only available if the benchmark was built with
+ * AFV_NATIVE_TRACK_ALLOCATIONS.
+ */
+#include "afv-native/Log.h"
+#include "afv-native/afv/ATCRadioSimulation.h"
+#include "afv-native/afv/EffectResources.h"
+#include "afv-native/afv/JitterBuffer.h"
+#include "afv-native/afv/RadioSimulation.h"
+#include "afv-native/afv/VoiceCompressionSink.h"
+#include "afv-native/afv/VoiceSourcePool.h"
+#include "afv-native/audio/ISampleStorage.h"
+#include "afv-native/audio/PolyphaseUpsampler.h"
+#include "afv-native/audio/SimpleCompressorEffect.h"
+#include "afv-native/audio/VHFFilterSource.h"
+#include "afv-native/audio/audio_params.h"
+#include "afv-native/audio/kernels.h"
+#include "afv-native/util/AllocationTracker.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <event2/event.h>
+#include <memory>
+#include <opus/opus.h>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace afv_native;
+
+namespace {
+    const unsigned int baseFrequencyHz   = 118000000;
+    const unsigned int channelSpacingHz  = 25000;
+    const size_t       talkPacketCount   = 50; // one second of speech, looped
+    const uint32_t     ingressLeadFrames = 2;
+
+    struct Options {
+        unsigned int frequencies    = 10;
+        unsigned int callsigns      = 20;
+        long         frames         = 5000;
+        long         warmup         = 250;
+        unsigned int dspThreads     = 0;
+        unsigned int decodeThreads  = 0;
+        unsigned int maxDecoders    = 0;
+        /** the render governor's budget in microseconds, 0 to leave the governor off */
+        unsigned int renderBudgetUs = 0;
+        bool         ingressThread  = false;
+        bool         verbose        = false;
+        std::string  resources;
+        /** the noise bed modes to run: per-radio, shared, or both */
+        bool perRadioNoiseBed = true;
+        bool sharedNoiseBed   = false;
+        /** the simulations to run: atc, pilot, or both */
+        bool atcSim   = true;
+        bool pilotSim = false;
+        /** the receive DSP rates to run at: 48k, 16k, or both */
+        bool fullRateDsp    = true;
+        bool reducedRateDsp = false;
+        /** the render quantum, and so the device period, in samples */
+        size_t quantum = audio::frameSizeSamples;
+    };
+
+    /** SyntheticStorage is a looping effect made of noise, for when the real effects aren't
+     * available. */
+    class SyntheticStorage: public audio::ISampleStorage {
+      public:
+        SyntheticStorage(size_t lengthInSamples, float level, unsigned int seed):
+            mSamples(new audio::SampleType[lengthInSamples]), mLength(lengthInSamples) {
+            std::mt19937                          rng(seed);
+            std::uniform_real_distribution<float> dist(-level, level);
+            for (size_t i = 0; i < mLength; i++) {
+                mSamples[i] = dist(rng);
+            }
+        }
+
+        audio::SampleType *data() const override {
+            return mSamples.get();
+        }
+
+        size_t lengthInSamples() const override {
+            return mLength;
+        }
+
+      private:
+        std::unique_ptr<audio::SampleType[]> mSamples;
+        size_t                               mLength;
+    };
+
+    std::shared_ptr<afv::EffectResources> load_resources(const std::string &path) {
+        auto         resources = std::make_shared<afv::EffectResources>(path);
+        unsigned int seed      = 1;
+        auto fill = [&seed](std::shared_ptr<audio::ISampleStorage> &storage, size_t length) {
+            if (!storage) {
+                storage = std::make_shared<SyntheticStorage>(length, 0.5f, seed);
+            }
+            seed++;
+        };
+        fill(resources->mClick, audio::sampleRateHz / 20);
+        fill(resources->mCrackle, audio::sampleRateHz);
+        fill(resources->mAcBus, audio::sampleRateHz);
+        fill(resources->mVhfWhiteNoise, audio::sampleRateHz);
+        fill(resources->mHfWhiteNoise, audio::sampleRateHz);
+        return resources;
+    }
+
+    /** synth_talk fills pcm with frame of something speech-like: two tones, an envelope and a
+     * little noise.  Each callsign gets its own pitch. */
+    void synth_talk(unsigned int callsign, size_t frame, std::mt19937 &rng, std::vector<audio::SampleType> &pcm) {
+        std::uniform_real_distribution<float> noise(-0.02f, 0.02f);
+        const double                          pitch = 110.0 + 15.0 * (callsign % 8);
+        for (size_t i = 0; i < pcm.size(); i++) {
+            const double t        = static_cast<double>(frame * audio::frameSizeSamples + i) / audio::sampleRateHz;
+            const double envelope = 0.5 + 0.5 * std::sin(2.0 * M_PI * 3.0 * t);
+            pcm[i] = static_cast<float>(envelope * (0.3 * std::sin(2.0 * M_PI * pitch * t) +
+                                                    0.1 * std::sin(2.0 * M_PI * 2.7 * pitch * t))) +
+                     noise(rng);
+        }
+    }
+
+    /** encode_talk encodes a second of synth_talk() the same way VoiceCompressionSink does by
+     * default. */
+    bool encode_talk(unsigned int callsign, std::vector<std::vector<unsigned char>> &packetsOut) {
+        int  opusStatus = 0;
+        auto encoder    = opus_encoder_create(audio::sampleRateHz, 1, OPUS_APPLICATION_VOIP, &opusStatus);
+        if (opusStatus != OPUS_OK) {
+            std::fprintf(stderr, "unable to create the Opus encoder: %s\n", opus_strerror(opusStatus));
+            return false;
+        }
+        opus_encoder_ctl(encoder, OPUS_SET_BITRATE(audio::encoderBitrate));
+
+        std::mt19937                   rng(1000 + callsign);
+        std::vector<audio::SampleType> pcm(audio::frameSizeSamples);
+        std::vector<unsigned char>     encoded(afv::VoiceCompressionSink::maxFrameBytes);
+
+        packetsOut.clear();
+        for (size_t packet = 0; packet < talkPacketCount; packet++) {
+            synth_talk(callsign, packet, rng, pcm);
+            const auto len = opus_encode_float(encoder, pcm.data(), audio::frameSizeSamples, encoded.data(),
+                                               static_cast<opus_int32>(encoded.size()));
+            if (len < 0) {
+                std::fprintf(stderr, "unable to encode: %s\n", opus_strerror(len));
+                opus_encoder_destroy(encoder);
+                return false;
+            }
+            packetsOut.emplace_back(encoded.begin(), encoded.begin() + len);
+        }
+        opus_encoder_destroy(encoder);
+        return true;
+    }
+
+    /** Talker is a synthetic callsign, with the packet it sends each frame. */
+    struct Talker {
+        afv::dto::AudioRxOnTransceivers         dto;
+        std::vector<std::vector<unsigned char>> packets;
+    };
+
+    bool make_talkers(const Options &opts, std::vector<Talker> &talkersOut) {
+        talkersOut.resize(opts.callsigns);
+        for (unsigned int c = 0; c < opts.callsigns; c++) {
+            auto &talker = talkersOut[c];
+            char  callsign[16];
+            std::snprintf(callsign, sizeof(callsign), "BENCH%03u", c);
+            talker.dto.Callsign        = callsign;
+            talker.dto.SequenceCounter = 0;
+            talker.dto.LastPacket      = false;
+
+            afv::dto::RxTransceiver trans;
+            trans.ID            = static_cast<uint16_t>(c);
+            trans.Frequency     = baseFrequencyHz + (c % opts.frequencies) * channelSpacingHz;
+            trans.DistanceRatio = 0.1f + 0.9f * static_cast<float>(c % 10) / 10.0f;
+            talker.dto.Transceivers.push_back(trans);
+            if (c % 4 == 3 && opts.frequencies > 1) {
+                trans.Frequency     = baseFrequencyHz + ((c + 1) % opts.frequencies) * channelSpacingHz;
+                trans.DistanceRatio = 0.5f;
+                talker.dto.Transceivers.push_back(trans);
+            }
+            if (!encode_talk(c, talker.packets)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename SimT>
+    void send_frame(SimT &sim, std::vector<Talker> &talkers, uint32_t frame) {
+        for (auto &talker: talkers) {
+            talker.dto.SequenceCounter = frame;
+            talker.dto.Audio           = talker.packets[frame % talker.packets.size()];
+            sim.rxVoicePacket(talker.dto);
+        }
+    }
+
+    double percentile(const std::vector<double> &sorted, double p) {
+        if (sorted.empty()) {
+            return 0.0;
+        }
+        size_t index = static_cast<size_t>(std::ceil(p * sorted.size()));
+        index        = std::min(std::max<size_t>(index, 1), sorted.size()) - 1;
+        return sorted[index];
+    }
+
+    bool parse_options(int argc, char **argv, Options &opts) {
+        for (int i = 1; i < argc; i++) {
+            const bool hasValue = i + 1 < argc;
+            if (std::strcmp(argv[i], "--frequencies") == 0 && hasValue) {
+                opts.frequencies = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+            } else if (std::strcmp(argv[i], "--callsigns") == 0 && hasValue) {
+                opts.callsigns = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+            } else if (std::strcmp(argv[i], "--frames") == 0 && hasValue) {
+                opts.frames = std::strtol(argv[++i], nullptr, 10);
+            } else if (std::strcmp(argv[i], "--warmup") == 0 && hasValue) {
+                opts.warmup = std::strtol(argv[++i], nullptr, 10);
+            } else if (std::strcmp(argv[i], "--dsp-threads") == 0 && hasValue) {
+                opts.dspThreads = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+            } else if (std::strcmp(argv[i], "--decode-threads") == 0 && hasValue) {
+                opts.decodeThreads = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+            } else if (std::strcmp(argv[i], "--max-decoders") == 0 && hasValue) {
+                opts.maxDecoders = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+            } else if (std::strcmp(argv[i], "--render-budget") == 0 && hasValue) {
+                opts.renderBudgetUs = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+            } else if (std::strcmp(argv[i], "--quantum") == 0 && hasValue) {
+                opts.quantum = std::strtoul(argv[++i], nullptr, 10);
+                if (!afv::ATCRadioSimulation::validRenderQuantum(opts.quantum)) {
+                    return false;
+                }
+            } else if (std::strcmp(argv[i], "--resources") == 0 && hasValue) {
+                opts.resources = argv[++i];
+            } else if (std::strcmp(argv[i], "--ingress-thread") == 0) {
+                opts.ingressThread = true;
+            } else if (std::strcmp(argv[i], "--verbose") == 0) {
+                opts.verbose = true;
+            } else if (std::strcmp(argv[i], "--noise-bed") == 0 && hasValue) {
+                const char *mode      = argv[++i];
+                opts.perRadioNoiseBed = std::strcmp(mode, "per-radio") == 0 || std::strcmp(mode, "both") == 0;
+                opts.sharedNoiseBed   = std::strcmp(mode, "shared") == 0 || std::strcmp(mode, "both") == 0;
+                if (!opts.perRadioNoiseBed && !opts.sharedNoiseBed) {
+                    return false;
+                }
+            } else if (std::strcmp(argv[i], "--sim") == 0 && hasValue) {
+                const char *sim = argv[++i];
+                opts.atcSim     = std::strcmp(sim, "atc") == 0 || std::strcmp(sim, "both") == 0;
+                opts.pilotSim   = std::strcmp(sim, "pilot") == 0 || std::strcmp(sim, "both") == 0;
+                if (!opts.atcSim && !opts.pilotSim) {
+                    return false;
+                }
+            } else if (std::strcmp(argv[i], "--dsp-rate") == 0 && hasValue) {
+                const char *rate    = argv[++i];
+                opts.fullRateDsp    = std::strcmp(rate, "48k") == 0 || std::strcmp(rate, "both") == 0;
+                opts.reducedRateDsp = std::strcmp(rate, "16k") == 0 || std::strcmp(rate, "both") == 0;
+                if (!opts.fullRateDsp && !opts.reducedRateDsp) {
+                    return false;
+                }
+            } else {
+                return false;
+            }
+        }
+        opts.frequencies = std::max(opts.frequencies, 1u);
+        opts.frames      = std::max(opts.frames, 1L);
+        opts.warmup      = std::max(opts.warmup, 0L);
+        return true;
+    }
+
+    /** make_simulation creates a simulation of type SimT with the benchmark's frequencies
+     * tuned, and describes it in nameOut. */
+    template <typename SimT>
+    std::shared_ptr<SimT> make_simulation(struct event_base *evBase, const Options &opts, const char *&nameOut);
+
+    template <>
+    std::shared_ptr<afv::ATCRadioSimulation> make_simulation(struct event_base *evBase, const Options &opts, const char *&nameOut) {
+        auto sim = std::make_shared<afv::ATCRadioSimulation>(evBase, load_resources(opts.resources), nullptr);
+        for (unsigned int f = 0; f < opts.frequencies; f++) {
+            const unsigned int freq = baseFrequencyHz + f * channelSpacingHz;
+            sim->addFrequency(freq, f % 3 != 2, "BENCH_CTR");
+            sim->setRx(freq, true);
+        }
+        nameOut = "atc";
+        return sim;
+    }
+
+    template <>
+    std::shared_ptr<afv::RadioSimulation> make_simulation(struct event_base *evBase, const Options &opts, const char *&nameOut) {
+        auto sim = std::make_shared<afv::RadioSimulation>(evBase, load_resources(opts.resources), nullptr, opts.frequencies);
+        for (unsigned int f = 0; f < opts.frequencies; f++) {
+            sim->setFrequency(f, baseFrequencyHz + f * channelSpacingHz);
+            sim->setOnHeadset(f, f % 3 != 2);
+        }
+        sim->setSplitAudioChannels(true);
+        nameOut = "pilot";
+        return sim;
+    }
+
+    /** run_bench runs the benchmark once against a fresh simulation, prints its report and
+     * returns the mean render time per frame. */
+    template <typename SimT>
+    double run_bench(const Options &opts, std::vector<Talker> &talkers, bool sharedNoiseBed, bool reducedRate) {
+        struct event_base *evBase = event_base_new();
+        util::ChainedCallback<void(ClientEventType, void *, void *)> eventCallback;
+        const char *simName = nullptr;
+        auto        sim     = make_simulation<SimT>(evBase, opts, simName);
+        sim->setupDevices(&eventCallback);
+        if (opts.dspThreads > 0) {
+            sim->setDspThreads(opts.dspThreads);
+        }
+        if (opts.decodeThreads > 0) {
+            sim->setDecodeThreads(opts.decodeThreads);
+        }
+        sim->setSharedNoiseBed(sharedNoiseBed);
+        sim->setReducedRateDsp(reducedRate);
+        sim->setRenderQuantum(opts.quantum);
+        sim->setMaxDecoders(opts.maxDecoders);
+        if (opts.renderBudgetUs > 0) {
+            sim->setRenderBudget(opts.renderBudgetUs);
+        }
+        sim->setRenderGovernorDecoderCap(opts.renderBudgetUs > 0);
+        sim->setRenderGovernor(opts.renderBudgetUs > 0);
+
+        auto headset = sim->headsetDevice();
+        auto speaker = sim->speakerDevice();
+        std::vector<audio::SampleType> headsetFrame(audio::frameSizeSamples * 2);
+        std::vector<audio::SampleType> speakerFrame(audio::frameSizeSamples * 2);
+
+        const long          totalFrames = opts.warmup + opts.frames;
+        std::vector<double> renderNs;
+        renderNs.reserve(opts.frames);
+        double   ingressNs          = 0.0;
+        uint64_t renderAllocations  = 0;
+        uint64_t ingressAllocations = 0;
+        uint64_t lockWaitStart      = 0;
+        uint64_t violationsStart    = 0;
+        uint64_t idleTicksStart     = 0;
+        uint64_t ticksStart         = 0;
+        uint64_t decodeNsStart      = 0;
+
+        // with an ingress thread, frame n is sent once the render has caught up to within
+        // ingressLeadFrames of it, and the render doesn't pull frame n until it has arrived.
+        std::atomic<uint32_t> framesSent {0};
+        std::atomic<uint32_t> framesRendered {0};
+        std::thread           ingress;
+        if (opts.ingressThread) {
+            ingress = std::thread([&] {
+                for (uint32_t frame = 0; frame < static_cast<uint32_t>(totalFrames); frame++) {
+                    while (frame > framesRendered.load(std::memory_order_acquire) + ingressLeadFrames) {
+                        std::this_thread::yield();
+                    }
+                    send_frame(*sim, talkers, frame);
+                    framesSent.store(frame + 1, std::memory_order_release);
+                }
+            });
+        }
+
+        const auto runStart = std::chrono::steady_clock::now();
+        for (long frame = 0; frame < totalFrames; frame++) {
+            const bool measuring = frame >= opts.warmup;
+            if (frame == opts.warmup) {
+                lockWaitStart   = sim->RenderLockWaitNs.load();
+                idleTicksStart  = sim->IdleRenderTicks.load();
+                ticksStart      = sim->RenderTicks.load();
+                decodeNsStart   = sim->DecodeWorkerNs.load();
+                violationsStart = util::allocationViolations();
+            }
+
+            if (opts.ingressThread) {
+                while (framesSent.load(std::memory_order_acquire) <= static_cast<uint32_t>(frame)) {
+                    std::this_thread::yield();
+                }
+            } else {
+                const uint64_t allocsBefore = util::threadAllocationCount();
+                const auto     start        = std::chrono::steady_clock::now();
+                send_frame(*sim, talkers, static_cast<uint32_t>(frame));
+                const auto end = std::chrono::steady_clock::now();
+                if (measuring) {
+                    ingressNs += std::chrono::duration<double, std::nano>(end - start).count();
+                    ingressAllocations += util::threadAllocationCount() - allocsBefore;
+                }
+            }
+
+            const uint64_t allocsBefore = util::threadAllocationCount();
+            const auto     start        = std::chrono::steady_clock::now();
+            for (size_t done = 0; done < audio::frameSizeSamples; done += opts.quantum) {
+                headset->getAudioSamples(headsetFrame.data(), opts.quantum);
+                speaker->getAudioSamples(speakerFrame.data(), opts.quantum);
+            }
+            const auto end = std::chrono::steady_clock::now();
+            if (measuring) {
+                renderNs.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+                renderAllocations += util::threadAllocationCount() - allocsBefore;
+            }
+            // in real time the workers would have the rest of the frame to decode the next one.
+            sim->waitForDecodeWorkers();
+            framesRendered.store(static_cast<uint32_t>(frame + 1), std::memory_order_release);
+
+            // let the render events and timers through, as the client's event loop would.
+            event_base_loop(evBase, EVLOOP_NONBLOCK);
+        }
+        const auto runEnd = std::chrono::steady_clock::now();
+        if (ingress.joinable()) {
+            ingress.join();
+        }
+        const uint64_t lockWaitNs = sim->RenderLockWaitNs.load() - lockWaitStart;
+        const uint64_t violations = util::allocationViolations() - violationsStart;
+        const uint64_t idleTicks  = sim->IdleRenderTicks.load() - idleTicksStart;
+        const uint64_t ticks      = sim->RenderTicks.load() - ticksStart;
+        const uint64_t decodeNs   = sim->DecodeWorkerNs.load() - decodeNsStart;
+
+        std::vector<double> sorted(renderNs);
+        std::sort(sorted.begin(), sorted.end());
+        double totalRenderNs = 0.0;
+        for (double ns: renderNs) {
+            totalRenderNs += ns;
+        }
+        const double meanNs     = totalRenderNs / renderNs.size();
+        const double framePerNs = audio::frameLengthMs * 1e6;
+
+        std::printf("afv_native_bench: %s, %u frequencies, %u callsigns, %ld frames (+%ld warmup), %u dsp thread(s), %u decode thread(s), %s kernels, %s noise bed, %d Hz dsp, %zu sample quantum%s\n",
+                    simName, opts.frequencies, opts.callsigns, opts.frames, opts.warmup, opts.dspThreads, opts.decodeThreads,
+                    audio::kernels::isaName(audio::kernels::activeIsa()), sharedNoiseBed ? "shared" : "per-radio",
+                    reducedRate ? audio::reducedSampleRateHz : audio::sampleRateHz, opts.quantum,
+                    opts.ingressThread ? ", threaded ingress" : "");
+        std::printf("active streams:          %u\n", sim->IncomingAudioStreams.load());
+        std::printf("render ns/frame:         mean %.0f  p50 %.0f  p90 %.0f  p99 %.0f  p99.9 %.0f  max %.0f\n",
+                    meanNs, percentile(sorted, 0.50), percentile(sorted, 0.90), percentile(sorted, 0.99),
+                    percentile(sorted, 0.999), sorted.back());
+        std::printf("realtime factor:         %.1fx (%d ms frames)\n", framePerNs / meanNs, audio::frameLengthMs);
+        if (!opts.ingressThread) {
+            std::printf("ingress ns/frame:        %.0f (%u packets)\n", ingressNs / opts.frames, opts.callsigns);
+        }
+        if (opts.maxDecoders > 0) {
+            std::printf("decoder budget:          %u (%llu evictions, %llu rejected streams)\n", opts.maxDecoders,
+                        static_cast<unsigned long long>(sim->DecoderEvictions.load()),
+                        static_cast<unsigned long long>(sim->DecoderRejections.load()));
+        }
+        if (opts.decodeThreads > 0) {
+            std::printf("decode workers:          %.0f ns/frame decoding off the audio thread\n",
+                        static_cast<double>(decodeNs) / opts.frames);
+        }
+        const auto &sourcePool = sim->getSourcePool();
+        std::printf("decoder pool:            %llu of %llu acquires reused, peak %zu in use\n",
+                    static_cast<unsigned long long>(sourcePool.Hits.load()),
+                    static_cast<unsigned long long>(sourcePool.Acquires.load()), sourcePool.getPeakInUse());
+        std::printf("render overruns:         %llu over %u us (governor %s, tier %u, %llu tier changes)\n",
+                    static_cast<unsigned long long>(sim->getRenderOverruns()), sim->getRenderBudget(),
+                    sim->getRenderGovernor() ? "on" : "off", static_cast<unsigned int>(sim->getRenderTier()),
+                    static_cast<unsigned long long>(sim->getRenderTierChanges()));
+        std::printf("idle render ticks:       %llu of %llu\n", static_cast<unsigned long long>(idleTicks),
+                    static_cast<unsigned long long>(ticks));
+        std::printf("render lock wait:        %.0f ns/frame, %.3f ms total\n",
+                    static_cast<double>(lockWaitNs) / opts.frames, lockWaitNs / 1e6);
+        if (util::allocationTrackingEnabled()) {
+            std::printf("render allocations:      %.2f/frame (%llu render scope violations)\n",
+                        static_cast<double>(renderAllocations) / opts.frames, static_cast<unsigned long long>(violations));
+            if (!opts.ingressThread) {
+                std::printf("ingress allocations:     %.2f/frame\n", static_cast<double>(ingressAllocations) / opts.frames);
+            }
+        } else {
+            std::printf("allocations:             not tracked (build with AFV_NATIVE_TRACK_ALLOCATIONS)\n");
+        }
+        std::printf("wall time:               %.1f ms\n",
+                    std::chrono::duration<double, std::milli>(runEnd - runStart).count());
+
+        headset.reset();
+        speaker.reset();
+        sim.reset();
+        event_base_free(evBase);
+        return meanNs;
+    }
+
+    /** report_crackle_cost times working out the crackle factor of every stream on every
+     * frequency it's heard on each frame, the way the render used to, against just reading the
+     * factors worked out at ingress. */
+    void report_crackle_cost(const Options &opts, const std::vector<Talker> &talkers) {
+        std::vector<afv::StreamContribution> contributions;
+        for (const auto &talker: talkers) {
+            for (const auto &trans: talker.dto.Transceivers) {
+                contributions.push_back({nullptr, trans.DistanceRatio,
+                                         afv::StreamContribution::crackleFactorFor(trans.DistanceRatio)});
+            }
+        }
+
+        volatile float sink = 0.0f;
+        auto           time = [&opts](auto &&frame) {
+            const auto start = std::chrono::steady_clock::now();
+            for (long i = 0; i < opts.frames; i++) {
+                frame();
+            }
+            const auto end = std::chrono::steady_clock::now();
+            return std::chrono::duration<double, std::nano>(end - start).count() / opts.frames;
+        };
+        const double perFrameNs = time([&] {
+            float sum = 0.0f;
+            for (const auto &contribution: contributions) {
+                sum += afv::StreamContribution::crackleFactorFor(contribution.distanceRatio);
+            }
+            sink = sum;
+        });
+        const double precomputedNs = time([&] {
+            float sum = 0.0f;
+            for (const auto &contribution: contributions) {
+                sum += contribution.crackleFactor;
+            }
+            sink = sum;
+        });
+        (void) sink;
+
+        std::printf("\ncrackle coefficients:    %.0f ns/frame worked out per frame, %.0f ns/frame precomputed (%zu stream contributions)\n",
+                    perFrameNs, precomputedNs, contributions.size());
+    }
+
+    /** RateChain is a single radio's receive chain - decoder, radio filter and compressor - at
+     * one sample rate, upsampled to the full rate if it's not already there. */
+    class RateChain {
+      public:
+        RateChain(HardwareType hardware, int sampleRate):
+            mSampleRate(sampleRate), mFrameSamples(sampleRate * audio::frameLengthMs / 1000), mDecoder(nullptr), mFilter(hardware, sampleRate), mCompressor(sampleRate), mUpsampler(audio::sampleRateHz / sampleRate), mFrame(audio::frameSizeSamples) {
+            int opusStatus = 0;
+            mDecoder       = opus_decoder_create(sampleRate, 1, &opusStatus);
+        }
+
+        ~RateChain() {
+            if (mDecoder != nullptr) {
+                opus_decoder_destroy(mDecoder);
+            }
+        }
+
+        /** radio runs a packet through everything the radio does, leaving the result in
+         * frame(). */
+        void radio(const std::vector<unsigned char> &packet) {
+            opus_decode_float(mDecoder, packet.data(), static_cast<opus_int32>(packet.size()), mFrame.data(), mFrameSamples, 0);
+            mFilter.transformFrame(mFrame.data(), mFrame.data());
+            mCompressor.transformFrame(mFrame.data(), mFrame.data());
+        }
+
+        /** output upsamples frame() into out, a full rate frame. */
+        void output(audio::SampleType *out) {
+            if (mSampleRate == audio::sampleRateHz) {
+                std::copy(mFrame.begin(), mFrame.end(), out);
+            } else {
+                mUpsampler.process(out, mFrame.data(), mFrameSamples);
+            }
+        }
+
+      private:
+        int                            mSampleRate;
+        int                            mFrameSamples;
+        OpusDecoder                   *mDecoder;
+        audio::VHFFilterSource         mFilter;
+        audio::SimpleCompressorEffect  mCompressor;
+        audio::PolyphaseUpsampler      mUpsampler;
+        std::vector<audio::SampleType> mFrame;
+    };
+
+    /** band_power returns the power of signal at freqHz, through a Hann window, by Goertzel. */
+    double band_power(const audio::SampleType *signal, size_t length, double freqHz) {
+        const double coeff = 2.0 * std::cos(2.0 * M_PI * freqHz / audio::sampleRateHz);
+        double       s1 = 0.0, s2 = 0.0;
+        for (size_t n = 0; n < length; n++) {
+            const double window = 0.5 - 0.5 * std::cos(2.0 * M_PI * n / (length - 1));
+            const double s0     = signal[n] * window + coeff * s1 - s2;
+            s2                  = s1;
+            s1                  = s0;
+        }
+        return s1 * s1 + s2 * s2 - coeff * s1 * s2;
+    }
+
+    /** report_reduced_rate_spectrum runs the first talker through each radio filter preset at
+     * both rates, and compares the averaged spectra across the voice band.  It also reports how
+     * much of the reduced rate output ends up above its Nyquist frequency (imaging the
+     * upsampler didn't catch), and what one radio costs per frame at each rate. */
+    void report_reduced_rate_spectrum(const Options &opts, const std::vector<Talker> &talkers) {
+        if (talkers.empty()) {
+            return;
+        }
+        const auto &packets   = talkers.front().packets;
+        const struct {
+            HardwareType hardware;
+            const char  *name;
+        } presets[] = {
+            {HardwareType::Schmid_ED_137B, "Schmid ED-137B"},
+            {HardwareType::Rockwell_Collins_2100, "Rockwell Collins 2100"},
+            {HardwareType::Garex_220, "Garex 220"},
+        };
+        // 50 Hz steps across the voice band, and beyond the reduced Nyquist for the images.
+        const double bandLowHz = 300.0, bandHighHz = 3400.0, stepHz = 50.0;
+        const double imageLowHz = audio::reducedSampleRateHz / 2.0, imageHighHz = 20000.0, imageStepHz = 250.0;
+
+        std::printf("\n%d Hz receive DSP spectrum, %.0f-%.0f Hz (%zu frames of %s):\n", audio::reducedSampleRateHz,
+                    bandLowHz, bandHighHz, packets.size(), talkers.front().dto.Callsign.c_str());
+        for (const auto &preset: presets) {
+            RateChain full(preset.hardware, audio::sampleRateHz);
+            RateChain reduced(preset.hardware, audio::reducedSampleRateHz);
+
+            std::vector<audio::SampleType> fullOut(audio::frameSizeSamples), reducedOut(audio::frameSizeSamples);
+            std::vector<double>            fullPower, reducedPower, fullImage, reducedImage;
+            for (double f = bandLowHz; f <= bandHighHz; f += stepHz) {
+                fullPower.push_back(0.0);
+                reducedPower.push_back(0.0);
+            }
+            for (double f = imageLowHz; f <= imageHighHz; f += imageStepHz) {
+                fullImage.push_back(0.0);
+                reducedImage.push_back(0.0);
+            }
+            for (const auto &packet: packets) {
+                full.radio(packet);
+                full.output(fullOut.data());
+                reduced.radio(packet);
+                reduced.output(reducedOut.data());
+                size_t bin = 0;
+                for (double f = bandLowHz; f <= bandHighHz; f += stepHz, bin++) {
+                    fullPower[bin] += band_power(fullOut.data(), fullOut.size(), f);
+                    reducedPower[bin] += band_power(reducedOut.data(), reducedOut.size(), f);
+                }
+                bin = 0;
+                for (double f = imageLowHz; f <= imageHighHz; f += imageStepHz, bin++) {
+                    fullImage[bin] += band_power(fullOut.data(), fullOut.size(), f);
+                    reducedImage[bin] += band_power(reducedOut.data(), reducedOut.size(), f);
+                }
+            }
+
+            // the difference is in the spectrum's shape, so leave out any overall level
+            // difference first.
+            double fullTotal = 0.0, reducedTotal = 0.0;
+            for (size_t bin = 0; bin < fullPower.size(); bin++) {
+                fullTotal += fullPower[bin];
+                reducedTotal += reducedPower[bin];
+            }
+            const double levelDb = 10.0 * std::log10(reducedTotal / fullTotal);
+            double       sumDiff = 0.0, maxDiff = 0.0, maxDiffHz = bandLowHz;
+            for (size_t bin = 0; bin < fullPower.size(); bin++) {
+                const double diff = std::fabs(10.0 * std::log10(reducedPower[bin] / fullPower[bin]) - levelDb);
+                sumDiff += diff;
+                if (diff > maxDiff) {
+                    maxDiff   = diff;
+                    maxDiffHz = bandLowHz + bin * stepHz;
+                }
+            }
+            double fullImageTotal = 0.0, reducedImageTotal = 0.0;
+            for (size_t bin = 0; bin < fullImage.size(); bin++) {
+                fullImageTotal += fullImage[bin];
+                reducedImageTotal += reducedImage[bin];
+            }
+            std::printf("  %-22s mean %.2f dB, max %.2f dB at %.0f Hz, level %+.2f dB; above %.0f Hz %.1f dB (%.1f dB at %d Hz)\n",
+                        preset.name, sumDiff / fullPower.size(), maxDiff, maxDiffHz, levelDb, imageLowHz,
+                        10.0 * std::log10(reducedImageTotal / reducedTotal), 10.0 * std::log10(fullImageTotal / fullTotal),
+                        audio::sampleRateHz);
+        }
+
+        // a radio's share of the render, without the upsampling, which is per bus.
+        auto timeRadio = [&opts, &packets](int sampleRate) {
+            RateChain  chain(HardwareType::Schmid_ED_137B, sampleRate);
+            const auto start = std::chrono::steady_clock::now();
+            for (long i = 0; i < opts.frames; i++) {
+                chain.radio(packets[i % packets.size()]);
+            }
+            const auto end = std::chrono::steady_clock::now();
+            return std::chrono::duration<double, std::nano>(end - start).count() / opts.frames;
+        };
+        const double fullNs    = timeRadio(audio::sampleRateHz);
+        const double reducedNs = timeRadio(audio::reducedSampleRateHz);
+        std::printf("radio ns/frame:          %.0f at %d Hz, %.0f at %d Hz (%.2fx)\n", fullNs, audio::sampleRateHz,
+                    reducedNs, audio::reducedSampleRateHz, fullNs / reducedNs);
+    }
+
+    /** LatencyResult is the spread of the latencies measured by measure_output_latency(), in
+     * milliseconds. */
+    struct LatencyResult {
+        double meanMs = 0.0;
+        double minMs  = 0.0;
+        double maxMs  = 0.0;
+    };
+
+    /** measure_output_latency times how long the first packet of a transmission takes to be
+     * heard, with the render in quanta of quantum samples and the headset pulled in periods
+     * of the same length.
+     *
+     * Time is counted in samples of a simulated device: each callback fills a period that's
+     * played out during the period after it, and sees the packets that arrived before it
+     * started.  Each trial starts a fresh callsign at a different point of the frame, and the
+     * latency runs from the first packet's arrival until its first audible sample is played.
+     * That includes the codec's own delay, but not how long the render takes, which the rest
+     * of the report covers.  The radio's effects are off, so that there's only the voice.
+     */
+    LatencyResult measure_output_latency(const Options &opts, const std::vector<Talker> &talkers, size_t quantum) {
+        const size_t   trials        = 24;
+        const size_t   burstPackets  = 5;
+        const size_t   quietPeriods  = 20 * audio::frameSizeSamples / quantum;
+        const size_t   maxPeriods    = 20 * quietPeriods;
+        const float    threshold     = 1e-3f;
+        const unsigned frequency     = baseFrequencyHz;
+
+        struct event_base *evBase = event_base_new();
+        util::ChainedCallback<void(ClientEventType, void *, void *)> eventCallback;
+        auto sim = std::make_shared<afv::ATCRadioSimulation>(evBase, load_resources(opts.resources), nullptr);
+        sim->addFrequency(frequency, true, "BENCH_CTR");
+        sim->setRx(frequency, true);
+        sim->setEnableOutputEffects(false);
+        sim->setRenderQuantum(quantum);
+        sim->setupDevices(&eventCallback);
+        auto headset = sim->headsetDevice();
+
+        std::vector<audio::SampleType> period(quantum * 2);
+        std::vector<double>            latencies;
+        uint64_t                       deviceTime = 0;
+        const auto                    &packets    = talkers.front().packets;
+        for (size_t trial = 0; trial < trials; trial++) {
+            afv::dto::AudioRxOnTransceivers dto = talkers.front().dto;
+            char                            callsign[16];
+            std::snprintf(callsign, sizeof(callsign), "LAT%03zu", trial);
+            dto.Callsign                  = callsign;
+            dto.Transceivers.resize(1);
+            dto.Transceivers[0].Frequency = frequency;
+
+            const uint64_t arrival = deviceTime + trial * audio::frameSizeSamples / trials;
+            size_t         sent    = 0;
+            bool           heard   = false;
+            size_t         quiet   = 0;
+            for (size_t periods = 0; (!heard || sent < burstPackets || quiet < quietPeriods) && periods < maxPeriods; periods++) {
+                while (sent < burstPackets && arrival + sent * audio::frameSizeSamples <= deviceTime) {
+                    dto.SequenceCounter = static_cast<uint32_t>(sent);
+                    dto.LastPacket      = sent + 1 == burstPackets;
+                    dto.Audio           = packets[sent % packets.size()];
+                    sim->rxVoicePacket(dto);
+                    sent++;
+                }
+                headset->getAudioSamples(period.data(), quantum);
+                bool audible = false;
+                for (size_t i = 0; i < quantum; i++) {
+                    if (std::fabs(period[i * 2]) > threshold) {
+                        if (!heard && sent > 0) {
+                            // played out during the next period.
+                            const uint64_t playedAt = deviceTime + quantum + i;
+                            latencies.push_back(static_cast<double>(playedAt - arrival) * 1000.0 / audio::sampleRateHz);
+                            heard = true;
+                        }
+                        audible = true;
+                    }
+                }
+                quiet = audible ? 0 : quiet + 1;
+                deviceTime += quantum;
+                event_base_loop(evBase, EVLOOP_NONBLOCK);
+            }
+        }
+
+        headset.reset();
+        sim.reset();
+        event_base_free(evBase);
+
+        LatencyResult result;
+        if (latencies.empty()) {
+            return result;
+        }
+        result.minMs = *std::min_element(latencies.begin(), latencies.end());
+        result.maxMs = *std::max_element(latencies.begin(), latencies.end());
+        for (double ms: latencies) {
+            result.meanMs += ms;
+        }
+        result.meanMs /= latencies.size();
+        return result;
+    }
+
+    /** report_output_latency measures the output latency at each of the useful render
+     * quanta. */
+    void report_output_latency(const Options &opts, const std::vector<Talker> &talkers) {
+        if (talkers.empty()) {
+            return;
+        }
+        std::printf("\noutput latency, first packet to first sample played:\n");
+        for (size_t quantum: {static_cast<size_t>(audio::frameSizeSamples), static_cast<size_t>(audio::frameSizeSamples / 2), static_cast<size_t>(audio::minRenderQuantumSamples)}) {
+            const auto latency = measure_output_latency(opts, talkers, quantum);
+            std::printf("  %3zu sample quantum:    mean %.2f ms  min %.2f ms  max %.2f ms\n", quantum, latency.meanMs,
+                        latency.minMs, latency.maxMs);
+        }
+    }
+
+    /** JitterResult is what measure_jitter_buffer() saw for one network condition. */
+    struct JitterResult {
+        uint64_t     played       = 0;
+        uint64_t     late         = 0;
+        uint64_t     lost         = 0;
+        uint64_t     concealed    = 0;
+        uint64_t     recovered    = 0;
+        uint64_t     discarded    = 0;
+        unsigned int targetFrames = 0;
+        /** mean time from a transmission's first packet arriving to it starting to play */
+        double startMs = 0.0;
+        /** mean time a packet was held before being played */
+        double delayMs = 0.0;
+    };
+
+    /** measure_jitter_buffer plays transmissions through a JitterBuffer on a simulated clock.
+     * Every packet takes 40 ms to arrive, plus up to jitterMs more, and lossRate of them never
+     * do.  Each packet carries its sequence number, so its playout can be timed. */
+    JitterResult measure_jitter_buffer(int jitterMs, double lossRate) {
+        const size_t           transmissions    = 3;
+        const size_t           transmissionSize = 100;
+        const int64_t          networkDelayMs   = 40;
+        const int64_t          breakMs          = 1000;
+        const uint32_t         firstSequence    = 1000;
+        const util::monotime_t playPhaseMs      = 7;
+
+        struct Arrival {
+            util::monotime_t at;
+            uint32_t         sequence;
+            bool             last;
+        };
+        std::mt19937                            rng(static_cast<unsigned int>(jitterMs) + 1);
+        std::uniform_int_distribution<int>      jitter(0, std::max(jitterMs, 0));
+        std::uniform_real_distribution<double>  chance(0.0, 1.0);
+        std::vector<Arrival>                    arrivals;
+        std::vector<util::monotime_t>           arrivedAt(transmissions * transmissionSize, -1);
+        std::vector<util::monotime_t>           firstArrival(transmissions, -1);
+        util::monotime_t                        sentAt = 0;
+        for (size_t t = 0; t < transmissions; t++) {
+            for (size_t i = 0; i < transmissionSize; i++) {
+                if (chance(rng) < lossRate) {
+                    continue;
+                }
+                const auto sequence = static_cast<uint32_t>(firstSequence + t * transmissionSize + i);
+                arrivals.push_back({sentAt + static_cast<util::monotime_t>(i) * audio::frameLengthMs + networkDelayMs + jitter(rng), sequence, i + 1 == transmissionSize});
+            }
+            sentAt += transmissionSize * audio::frameLengthMs + breakMs;
+        }
+        std::stable_sort(arrivals.begin(), arrivals.end(), [](const Arrival &a, const Arrival &b) {
+            return a.at < b.at;
+        });
+
+        afv::JitterBuffer jb(afv::frameTimeOut);
+        JitterResult      result;
+        unsigned char     packet[afv::JitterBuffer::maxPacketBytes];
+        size_t            length  = 0;
+        size_t            next    = 0;
+        size_t            started = 0;
+        std::vector<bool> playing(transmissions, false);
+        for (util::monotime_t now = playPhaseMs; now < sentAt; now += audio::frameLengthMs) {
+            for (; next < arrivals.size() && arrivals[next].at <= now; next++) {
+                const auto  &arrival = arrivals[next];
+                const size_t index   = arrival.sequence - firstSequence;
+                arrivedAt[index]     = arrival.at;
+                if (firstArrival[index / transmissionSize] < 0) {
+                    firstArrival[index / transmissionSize] = arrival.at;
+                }
+                jb.put(arrival.sequence, reinterpret_cast<const unsigned char *>(&arrival.sequence), sizeof(arrival.sequence), arrival.last, arrival.at);
+            }
+            if (jb.get(packet, length) != afv::JitterBuffer::Result::Packet) {
+                continue;
+            }
+            uint32_t sequence;
+            std::memcpy(&sequence, packet, sizeof(sequence));
+            const size_t index = sequence - firstSequence;
+            result.played++;
+            result.delayMs += static_cast<double>(now - arrivedAt[index]);
+            if (!playing[index / transmissionSize]) {
+                playing[index / transmissionSize] = true;
+                result.startMs += static_cast<double>(now - firstArrival[index / transmissionSize]);
+                started++;
+            }
+        }
+        result.late         = jb.Late.load();
+        result.lost         = jb.Lost.load();
+        result.concealed    = jb.Concealed.load();
+        result.recovered    = jb.Recovered.load();
+        result.discarded    = jb.Discarded.load();
+        result.targetFrames = jb.getTargetDelayFrames();
+        result.startMs /= std::max<size_t>(started, 1);
+        result.delayMs /= std::max<uint64_t>(result.played, 1);
+        return result;
+    }
+
+    /** report_jitter_buffer runs measure_jitter_buffer() over a range of network
+     * conditions. */
+    void report_jitter_buffer() {
+        std::printf("\njitter buffer, 3 transmissions of 2 s over a 40 ms network:\n");
+        std::printf("  jitter  loss   start ms  held ms  target  played  late  lost  recovered  concealed  discarded\n");
+        for (double lossRate: {0.0, 0.02}) {
+            for (int jitterMs: {0, 20, 60, 120}) {
+                const auto r = measure_jitter_buffer(jitterMs, lossRate);
+                std::printf("  %4d ms  %3.0f%%  %8.1f  %7.1f  %6u  %6llu  %4llu  %4llu  %9llu  %9llu  %9llu\n", jitterMs, lossRate * 100.0,
+                            r.startMs, r.delayMs, r.targetFrames, static_cast<unsigned long long>(r.played),
+                            static_cast<unsigned long long>(r.late), static_cast<unsigned long long>(r.lost),
+                            static_cast<unsigned long long>(r.recovered), static_cast<unsigned long long>(r.concealed),
+                            static_cast<unsigned long long>(r.discarded));
+            }
+        }
+    }
+
+    /** report_source_pool times a stream's source coming and going: created and destroyed
+     * each time, against taken from a VoiceSourcePool and released back into it. */
+    void report_source_pool() {
+        const size_t churn = 2000;
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < churn; i++) {
+            auto source = std::make_shared<afv::RemoteVoiceSource>(audio::sampleRateHz);
+        }
+        const double freshNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / churn;
+
+        afv::VoiceSourcePool pool;
+        pool.reserve(1);
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < churn; i++) {
+            auto source = pool.acquire(audio::sampleRateHz);
+            pool.release(std::move(source));
+        }
+        const double pooledNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / churn;
+
+        std::printf("\nstream source churn:     fresh %.0f ns, pooled %.0f ns (%.1fx), %llu of %llu acquires reused\n",
+                    freshNs, pooledNs, freshNs / pooledNs, static_cast<unsigned long long>(pool.Hits.load()),
+                    static_cast<unsigned long long>(pool.Acquires.load()));
+    }
+
+    /** CountingFrameSink counts what a VoiceCompressionSink would send, and lets DTX skip
+     * whatever it likes, as if the PTT were held throughout. */
+    class CountingFrameSink: public afv::ICompressedFrameSink {
+      public:
+        void processCompressedFrame(const std::vector<unsigned char> &compressedData) override {
+            packets++;
+            bytes += compressedData.size();
+        }
+
+        bool skipCompressedFrame() override {
+            skipped++;
+            return true;
+        }
+
+        uint64_t packets = 0;
+        uint64_t bytes   = 0;
+        uint64_t skipped = 0;
+    };
+
+    /** report_encoder_profiles encodes 10 s of talk, two seconds on and a second off, with
+     * each encoder profile, and reports the encode time and what would go upstream. */
+    void report_encoder_profiles() {
+        const size_t talkFrames  = 2000 / audio::frameLengthMs;
+        const size_t pauseFrames = 1000 / audio::frameLengthMs;
+        const size_t frames      = 10000 / audio::frameLengthMs;
+
+        // render the input up front, so that only the encoding is timed.
+        std::mt19937                                rng(1);
+        std::uniform_real_distribution<float>       hiss(-0.0005f, 0.0005f);
+        std::vector<std::vector<audio::SampleType>> input(frames, std::vector<audio::SampleType>(audio::frameSizeSamples));
+        for (size_t frame = 0; frame < frames; frame++) {
+            if (frame % (talkFrames + pauseFrames) < talkFrames) {
+                synth_talk(0, frame, rng, input[frame]);
+            } else {
+                for (auto &sample: input[frame]) {
+                    sample = hiss(rng);
+                }
+            }
+        }
+
+        auto radioDtx = afv::EncoderProfile::radio();
+        radioDtx.dtx  = true;
+        const struct {
+            const char         *name;
+            afv::EncoderProfile profile;
+        } profiles[] = {
+            {"standard", afv::EncoderProfile::standard()},
+            {"low cpu", afv::EncoderProfile::lowCpu()},
+            {"radio", afv::EncoderProfile::radio()},
+            {"radio + dtx", radioDtx},
+        };
+
+        std::printf("\nencoder profiles, %zu frames of talk with a 1 s pause every 2 s:\n", frames);
+        std::printf("  profile       us/frame  packets  skipped  bytes/packet     kbps\n");
+        for (const auto &p: profiles) {
+            CountingFrameSink         counter;
+            afv::VoiceCompressionSink sink(counter);
+            sink.setProfile(p.profile);
+            const auto start = std::chrono::steady_clock::now();
+            for (const auto &pcm: input) {
+                sink.putAudioFrame(pcm.data());
+            }
+            const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+            std::printf("  %-12s  %8.1f  %7llu  %7llu  %12.1f  %7.1f\n", p.name, us, static_cast<unsigned long long>(counter.packets),
+                        static_cast<unsigned long long>(counter.skipped),
+                        static_cast<double>(counter.bytes) / static_cast<double>(std::max<uint64_t>(counter.packets, 1)),
+                        static_cast<double>(counter.bytes) * 8.0 / (frames * audio::frameLengthMs));
+        }
+    }
+
+    /** run_decode_modes benchmarks SimT decoding on the audio thread, and then with the decode
+     * workers if any were asked for.  Returns the mean render time decoding on the audio
+     * thread. */
+    template <typename SimT>
+    double run_decode_modes(const Options &opts, std::vector<Talker> &talkers, bool sharedNoiseBed, bool reducedRate) {
+        Options inlineOpts       = opts;
+        inlineOpts.decodeThreads = 0;
+        const double inlineNs    = run_bench<SimT>(inlineOpts, talkers, sharedNoiseBed, reducedRate);
+        if (opts.decodeThreads > 0) {
+            std::printf("\n");
+            const double workersNs = run_bench<SimT>(opts, talkers, sharedNoiseBed, reducedRate);
+            std::printf("\ndecode workers:          render callback %.2fx the speed of decoding inline (%.0f vs %.0f ns/frame, %u streams)\n",
+                        inlineNs / workersNs, workersNs, inlineNs, opts.callsigns);
+        }
+        return inlineNs;
+    }
+
+    /** run_noise_beds benchmarks SimT in each of the selected noise bed modes, and returns the
+     * mean render time of the first. */
+    template <typename SimT>
+    double run_noise_beds(const Options &opts, std::vector<Talker> &talkers, bool reducedRate) {
+        double perRadioNs = 0.0;
+        double sharedNs   = 0.0;
+        if (opts.perRadioNoiseBed) {
+            perRadioNs = run_decode_modes<SimT>(opts, talkers, false, reducedRate);
+        }
+        if (opts.sharedNoiseBed) {
+            if (opts.perRadioNoiseBed) {
+                std::printf("\n");
+            }
+            sharedNs = run_decode_modes<SimT>(opts, talkers, true, reducedRate);
+        }
+        if (opts.perRadioNoiseBed && opts.sharedNoiseBed) {
+            std::printf("\nshared noise bed:        %.2fx the speed of per-radio (%.0f vs %.0f ns/frame)\n",
+                        perRadioNs / sharedNs, sharedNs, perRadioNs);
+        }
+        return opts.perRadioNoiseBed ? perRadioNs : sharedNs;
+    }
+
+    /** run_simulation benchmarks SimT at each of the selected DSP rates. */
+    template <typename SimT>
+    void run_simulation(const Options &opts, std::vector<Talker> &talkers) {
+        double fullRateNs    = 0.0;
+        double reducedRateNs = 0.0;
+        if (opts.fullRateDsp) {
+            fullRateNs = run_noise_beds<SimT>(opts, talkers, false);
+        }
+        if (opts.reducedRateDsp) {
+            if (opts.fullRateDsp) {
+                std::printf("\n");
+            }
+            reducedRateNs = run_noise_beds<SimT>(opts, talkers, true);
+        }
+        if (opts.fullRateDsp && opts.reducedRateDsp) {
+            std::printf("\n%d Hz receive DSP:     %.2fx the speed of %d Hz (%.0f vs %.0f ns/frame)\n",
+                        audio::reducedSampleRateHz, fullRateNs / reducedRateNs, audio::sampleRateHz, reducedRateNs, fullRateNs);
+        }
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    Options opts;
+    if (!parse_options(argc, argv, opts)) {
+        std::fprintf(stderr,
+                     "usage: %s [--frequencies N] [--callsigns M] [--frames F] [--warmup F]\n"
+                     "          [--dsp-threads T] [--ingress-thread] [--resources DIR] [--verbose]\n"
+                     "          [--noise-bed per-radio|shared|both] [--max-decoders D]\n"
+                     "          [--sim atc|pilot|both] [--render-budget US]\n"
+                     "          [--dsp-rate 48k|16k|both] [--quantum Q] [--decode-threads T]\n",
+                     argv[0]);
+        return 2;
+    }
+    if (!opts.verbose) {
+        setLogger([](std::string, std::string, int, std::string) {});
+    }
+
+    std::vector<Talker> talkers;
+    if (!make_talkers(opts, talkers)) {
+        return 1;
+    }
+
+    if (opts.atcSim) {
+        run_simulation<afv::ATCRadioSimulation>(opts, talkers);
+    }
+    if (opts.pilotSim) {
+        if (opts.atcSim) {
+            std::printf("\n");
+        }
+        run_simulation<afv::RadioSimulation>(opts, talkers);
+    }
+    report_crackle_cost(opts, talkers);
+    report_output_latency(opts, talkers);
+    report_jitter_buffer();
+    report_source_pool();
+    report_encoder_profiles();
+    if (opts.reducedRateDsp) {
+        report_reduced_rate_spectrum(opts, talkers);
+    }
+    return 0;
+}
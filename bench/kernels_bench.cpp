@@ -0,0 +1,248 @@
+/* kernels_bench
+ *
+ * Checks every SIMD audio kernel the machine supports against the scalar reference, then times
+ * them all on frame-sized buffers.
+ *
+ * usage: afv_native_kernels_bench [--check] [--iterations N]
+ *
+ * Exits non-zero if any kernel disagrees with the scalar reference.
+ */
+#include "afv-native/audio/audio_params.h"
+#include "afv-native/audio/kernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace afv_native::audio;
+
+namespace {
+    const kernels::Isa allIsas[] = {kernels::Isa::Scalar, kernels::Isa::SSE2, kernels::Isa::AVX2, kernels::Isa::NEON};
+
+    /* Inputs run a little past full scale so the clamping kernels have something to do. */
+    struct Inputs {
+        std::vector<SampleType> a;
+        std::vector<SampleType> b;
+        std::vector<SampleType> stereo;
+
+        explicit Inputs(size_t numSamples): a(numSamples), b(numSamples), stereo(numSamples * 2) {
+            std::mt19937                          rng(1234);
+            std::uniform_real_distribution<float> dist(-1.5f, 1.5f);
+            for (auto &s: a) {
+                s = dist(rng);
+            }
+            for (auto &s: b) {
+                s = dist(rng);
+            }
+            for (auto &s: stereo) {
+                s = dist(rng);
+            }
+        }
+    };
+
+    /* run() applies the kernel to fresh copies of the inputs and returns everything it
+     * produced, for the accuracy check.  step() applies it once to a frame in place, for timing -
+     * the output is fed straight back in, so the gains are kept close to unity. */
+    struct Kernel {
+        const char *name;
+        std::vector<float> (*run)(const Inputs &in, size_t n);
+        float (*step)(float *dst, const Inputs &in);
+    };
+
+    std::vector<Kernel> make_kernels() {
+        return {
+            {"mix",
+             [](const Inputs &in, size_t n) -> std::vector<float> {
+                 std::vector<float> dst(in.a);
+                 kernels::mix(dst.data(), in.b.data(), 0.7f, n);
+                 return dst;
+             },
+             [](float *dst, const Inputs &in) {
+                 kernels::mix(dst, in.a.data(), 1e-6f);
+                 return 0.0f;
+             }},
+            {"scale",
+             [](const Inputs &in, size_t n) -> std::vector<float> {
+                 std::vector<float> dst(in.a);
+                 kernels::scale(dst.data(), 0.7f, n);
+                 return dst;
+             },
+             [](float *dst, const Inputs &in) {
+                 (void) in;
+                 kernels::scale(dst, 0.999999f);
+                 return 0.0f;
+             }},
+            {"clamp",
+             [](const Inputs &in, size_t n) -> std::vector<float> {
+                 std::vector<float> dst(in.a);
+                 kernels::clamp(dst.data(), n);
+                 return dst;
+             },
+             [](float *dst, const Inputs &in) {
+                 (void) in;
+                 kernels::clamp(dst);
+                 return 0.0f;
+             }},
+            {"mixClamp",
+             [](const Inputs &in, size_t n) -> std::vector<float> {
+                 std::vector<float> dst(in.a);
+                 kernels::mixClamp(dst.data(), in.b.data(), 0.7f, n);
+                 return dst;
+             },
+             [](float *dst, const Inputs &in) {
+                 kernels::mixClamp(dst, in.a.data(), 1e-6f);
+                 return 0.0f;
+             }},
+            {"scaleClamp",
+             [](const Inputs &in, size_t n) -> std::vector<float> {
+                 std::vector<float> dst(in.a.size());
+                 kernels::scaleClamp(dst.data(), in.a.data(), 1.3f, n);
+                 return dst;
+             },
+             [](float *dst, const Inputs &in) {
+                 kernels::scaleClamp(dst, in.a.data(), 1.3f);
+                 return 0.0f;
+             }},
+            {"levels",
+             [](const Inputs &in, size_t n) -> std::vector<float> {
+                 const kernels::Levels l = kernels::levels(in.a.data(), n);
+                 return std::vector<float> {l.peak, l.rms};
+             },
+             [](float *dst, const Inputs &in) {
+                 (void) dst;
+                 return kernels::levels(in.a.data()).rms;
+             }},
+            {"interleave",
+             [](const Inputs &in, size_t n) -> std::vector<float> {
+                 std::vector<float> dst(in.stereo.size());
+                 kernels::interleave(in.a.data(), in.b.data(), dst.data(), n);
+                 return dst;
+             },
+             [](float *dst, const Inputs &in) {
+                 kernels::interleave(in.a.data(), in.b.data(), dst);
+                 return 0.0f;
+             }},
+            {"mixMonoToStereo",
+             [](const Inputs &in, size_t n) -> std::vector<float> {
+                 std::vector<float> dst(in.stereo);
+                 kernels::mixMonoToStereo(dst.data(), in.a.data(), 0.7f, 0.3f, n);
+                 return dst;
+             },
+             [](float *dst, const Inputs &in) {
+                 kernels::mixMonoToStereo(dst, in.a.data(), 1e-6f, 1e-6f);
+                 return 0.0f;
+             }},
+        };
+    }
+
+    bool check_accuracy(const std::vector<Kernel> &kernelList) {
+        // the odd length makes sure the scalar tails are exercised too.
+        const size_t lengths[] = {frameSizeSamples, frameSizeSamples - 3, 5};
+        const Inputs in(frameSizeSamples);
+        bool         ok = true;
+
+        for (const auto &kernel: kernelList) {
+            for (size_t n: lengths) {
+                kernels::selectIsa(kernels::Isa::Scalar);
+                const std::vector<float> reference = kernel.run(in, n);
+
+                for (auto isa: allIsas) {
+                    if (isa == kernels::Isa::Scalar || !kernels::selectIsa(isa)) {
+                        continue;
+                    }
+                    const std::vector<float> result = kernel.run(in, n);
+                    double                   maxErr = 0.0;
+                    for (size_t i = 0; i < reference.size(); i++) {
+                        const double err = std::fabs(static_cast<double>(result[i]) - reference[i]) /
+                                           std::max(1.0, std::fabs(static_cast<double>(reference[i])));
+                        maxErr = std::max(maxErr, err);
+                    }
+                    // everything but levels() should match exactly; allow for a reordered sum
+                    // and for the compiler contracting the scalar reference into FMAs.
+                    if (maxErr > 1e-5) {
+                        std::printf("FAIL %-16s %-5s n=%-4zu max relative error %g\n", kernel.name,
+                                    kernels::isaName(isa), n, maxErr);
+                        ok = false;
+                    }
+                }
+            }
+        }
+        return ok;
+    }
+
+    void run_benchmarks(const std::vector<Kernel> &kernelList, long iterations) {
+        const Inputs in(frameSizeSamples);
+        float        sink = 0.0f;
+
+        std::printf("%-16s", "kernel");
+        for (auto isa: allIsas) {
+            if (kernels::isaSupported(isa)) {
+                std::printf(" %14s", kernels::isaName(isa));
+            }
+        }
+        std::printf("   (ns per %d sample frame)\n", frameSizeSamples);
+
+        for (const auto &kernel: kernelList) {
+            std::printf("%-16s", kernel.name);
+            double scalarNs = 0.0;
+            for (auto isa: allIsas) {
+                if (!kernels::selectIsa(isa)) {
+                    continue;
+                }
+                std::vector<float> dst(in.stereo);
+                const auto         start = std::chrono::steady_clock::now();
+                for (long i = 0; i < iterations; i++) {
+                    sink += kernel.step(dst.data(), in);
+                }
+                const auto   end = std::chrono::steady_clock::now();
+                const double ns  = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+                sink += dst[iterations % dst.size()];
+                if (isa == kernels::Isa::Scalar) {
+                    scalarNs = ns;
+                    std::printf(" %14.1f", ns);
+                } else {
+                    std::printf(" %8.1f (%.1fx)", ns, scalarNs / ns);
+                }
+            }
+            std::printf("\n");
+        }
+        // print the sink so none of the work above can be optimised away.
+        std::printf("(checksum %g)\n", sink);
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    long iterations = 200000;
+    bool checkOnly  = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--check") == 0) {
+            checkOnly = true;
+        } else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::strtol(argv[++i], nullptr, 10);
+        } else {
+            std::fprintf(stderr, "usage: %s [--check] [--iterations N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (iterations <= 0) {
+        iterations = 1;
+    }
+
+    const kernels::Isa bestIsa = kernels::activeIsa();
+    std::printf("best kernels for this CPU: %s\n", kernels::isaName(bestIsa));
+
+    const auto kernelList = make_kernels();
+    const bool ok         = check_accuracy(kernelList);
+    std::printf("accuracy check against the scalar reference: %s\n", ok ? "passed" : "FAILED");
+
+    if (!checkOnly) {
+        run_benchmarks(kernelList, iterations);
+    }
+    kernels::selectIsa(bestIsa);
+    return ok ? 0 : 1;
+}
@@ -31,11 +31,12 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-#ifndef AFV_NATIVE_RADIOSIMULATION_H
-#define AFV_NATIVE_RADIOSIMULATION_H
+#ifndef AFV_NATIVE_ATCRADIOSIMULATION_H
+#define AFV_NATIVE_ATCRADIOSIMULATION_H
 
 #include "afv-native/Log.h"
 #include "afv-native/afv/EffectResources.h"
+#include "afv-native/afv/RadioRenderCore.h"
 #include "afv-native/afv/RemoteVoiceSource.h"
 #include "afv-native/afv/RollingAverage.h"
 #include "afv-native/afv/VoiceCompressionSink.h"
@@ -44,10 +45,11 @@
 #include "afv-native/afv/dto/Transceiver.h"
 #include "afv-native/afv/dto/voice_server/AudioRxOnTransceivers.h"
 #include "afv-native/afv/dto/voice_server/AudioTxOnTransceivers.h"
+#include "afv-native/audio/FrameRing.h"
+#include "afv-native/audio/FrameSlab.h"
 #include "afv-native/audio/ISampleSink.h"
 #include "afv-native/audio/ISampleSource.h"
 #include "afv-native/audio/ITick.h"
-#include "afv-native/audio/OutputDeviceState.h"
 #include "afv-native/audio/PinkNoiseGenerator.h"
 #include "afv-native/audio/SimpleCompressorEffect.h"
 #include "afv-native/audio/SineToneSource.h"
@@ -57,11 +59,17 @@
 #include "afv-native/event.h"
 #include "afv-native/event/EventCallbackTimer.h"
 #include "afv-native/hardwareType.h"
+#include "afv-native/util/BoundedQueue.h"
 #include "afv-native/util/ChainedCallback.h"
+#include "afv-native/util/RcuCell.h"
+#include "afv-native/util/TimerWheel.h"
+#include "afv-native/util/WorkStealingPool.h"
 #include "afv-native/util/other.h"
 #include "afv-native/utility.h"
+#include <array>
 #include <atomic>
 #include <cmath>
+#include <deque>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -76,6 +84,8 @@ namespace afv_native { namespace afv {
       public:
         AtcOutputAudioDevice(std::weak_ptr<ATCRadioSimulation> radio, bool onHeadset);
         audio::SourceStatus getAudioFrame(audio::SampleType *bufferOut) override;
+        audio::SourceStatus getAudioSamples(audio::SampleType *bufferOut, size_t numSamples) override;
+        bool                partialFrames() const override;
 
       private:
         std::weak_ptr<ATCRadioSimulation> mRadio;
@@ -84,22 +94,17 @@ namespace afv_native { namespace afv {
 
     /** RadioState is the internal state object for each radio within a ATCRadioSimulation.
      *
-     * It tracks the current playback position of the mixing effects, the channel frequency and gain.
+     * It holds the channel configuration and bookkeeping - the cold side of a radio - and
+     * lives in the simulation's AtcRadioTable, guarded by the radio state lock.  The render path
+     * never sees it directly: it works from the RenderRadioConfig snapshots published from it,
+     * plus the shared RadioDsp.
      */
     class AtcRadioState {
       public:
-        unsigned int                                 Frequency;
-        float                                        Gain = 1.0;
-        std::shared_ptr<audio::RecordedSampleSource> Click;
-        std::shared_ptr<audio::RecordedSampleSource> Crackle;
-        std::shared_ptr<audio::RecordedSampleSource> AcBus;
-        std::shared_ptr<audio::RecordedSampleSource> VhfWhiteNoise;
-        std::shared_ptr<audio::RecordedSampleSource> HfWhiteNoise;
-        std::shared_ptr<audio::SineToneSource>       BlockTone;
-        audio::SimpleCompressorEffect                simpleCompressorEffect;
-        std::shared_ptr<audio::VHFFilterSource>      vhfFilter;
-        int                                          mLastRxCount;
-        bool                                         mBypassEffects    = false;
+        unsigned int                 Frequency;
+        float                        Gain = 1.0;
+        std::shared_ptr<RadioDsp>    dsp;
+        bool                         mBypassEffects    = false;
         bool                                         mHfSquelch        = false;
         bool                                         onHeadset         = true;
         bool                                         tx                = false;
@@ -114,18 +119,50 @@ namespace afv_native { namespace afv {
 
         std::string              lastTransmitCallsign      = "";
         std::vector<std::string> liveTransmittingCallsigns = {};
-        time_t                   lastVoiceTime;
+        /** voiceTimeout is armed while voice is being received, and ends reception if the
+         * packets stop without a last packet.  Keyed by Frequency. */
+        util::TimerWheel<unsigned int>::Timer voiceTimeout;
     };
 
-    /** CallsignMeta is the per-packetstream metadata stored within the ATCRadioSimulation object.
+    /** AtcRadioTable holds the AtcRadioStates of a simulation in dense, reusable slots.
      *
-     * It's used to hold the RemoteVoiceSource object for that callsign+channel combination,
-     * and the list of transceivers that this packet stream relates to.
+     * The frequency -> slot index is kept separately, and looking a radio up never creates one -
+     * only add() does.  Slots never move, so a radio's state stays put until it's removed.
+     *
+     * @note the table is guarded by the simulation's radio state lock.
      */
-    struct AtcCallsignMeta {
-        std::shared_ptr<RemoteVoiceSource> source;
-        std::vector<dto::RxTransceiver>    transceivers;
-        AtcCallsignMeta();
+    class AtcRadioTable {
+      public:
+        /** find returns the radio on freq, or nullptr if there isn't one. */
+        AtcRadioState       *find(unsigned int freq);
+        const AtcRadioState *find(unsigned int freq) const;
+
+        /** add returns a freshly reset radio for freq, replacing any radio already on it. */
+        AtcRadioState &add(unsigned int freq);
+
+        /** remove frees freq's slot.  Returns false if there was no radio on freq. */
+        bool remove(unsigned int freq);
+        void clear();
+
+        size_t size() const {
+            return mSlotByFrequency.size();
+        }
+
+        /** forEach calls fn(state) for every radio, in slot order. */
+        template <typename F>
+        void forEach(F &&fn) {
+            for (size_t slot = 0; slot < mSlots.size(); slot++) {
+                if (mInUse[slot]) {
+                    fn(mSlots[slot]);
+                }
+            }
+        }
+
+      private:
+        std::deque<AtcRadioState>                  mSlots;
+        std::vector<bool>                          mInUse;
+        std::vector<uint32_t>                      mFreeSlots;
+        std::unordered_map<unsigned int, uint32_t> mSlotByFrequency;
     };
 
     enum class AtcRadioSimulationState {
@@ -143,7 +180,7 @@ namespace afv_native { namespace afv {
      * methods) and instead provides the Ptt functions to control the conversion of said input into
      * voice packets.
      */
-    class ATCRadioSimulation: public std::enable_shared_from_this<ATCRadioSimulation>, public audio::ISampleSink, public ICompressedFrameSink {
+    class ATCRadioSimulation: public std::enable_shared_from_this<ATCRadioSimulation>, public RadioRenderCore<AtcRenderPolicy>, public audio::ISampleSink, public ICompressedFrameSink {
       public:
         ATCRadioSimulation(struct event_base *evBase, std::shared_ptr<EffectResources> resources, cryptodto::UDPChannel *channel);
         virtual ~ATCRadioSimulation();
@@ -212,6 +249,36 @@ namespace afv_native { namespace afv {
         void setEnableOutputEffects(bool enableEffects);
         void setEnableHfSquelch(bool enableHfSquelch);
 
+        /** setReducedRateDsp decodes and renders every radio at reducedSampleRateHz, only
+         * upsampling each output bus back up to the full rate.  The voice band is well within
+         * that, and each radio costs about a third as much.
+         *
+         * Switching drops the incoming streams, which pick up again with their next packet.
+         */
+        void setReducedRateDsp(bool reduced);
+
+        /** setRenderQuantum renders the receive mix quantum samples at a time, rather than a
+         * whole 20ms frame at a time, so that an output device with a shorter period doesn't
+         * have to wait for a whole frame to be mixed.  It has to be a whole fraction of a frame
+         * of at least minRenderQuantumSamples - 240 and 480 are the useful ones.
+         *
+         * Each stream still decodes a whole frame at a time, and is then mixed a quantum of it
+         * per render.  A shorter quantum costs a little more per frame in overhead.
+         *
+         * @return false if the quantum isn't valid.
+         */
+        bool setRenderQuantum(size_t quantum);
+
+        /** setFecPacketLoss has the voice encoder add in-band FEC for a network losing percent
+         * of its packets, so that receivers can rebuild a lost frame from the packet after it.
+         * 0 (the default) turns FEC off, and a negative percent follows
+         * getMeasuredPacketLoss(), which is only measured while it's asked for.
+         */
+        void setFecPacketLoss(int percent);
+
+        /** setEncoderProfile switches the voice encoder to profile, from the next frame. */
+        void setEncoderProfile(const EncoderProfile &profile);
+
         void setupDevices(util::ChainedCallback<void(ClientEventType, void *, void *)> *eventCallback);
 
         void setOnHeadset(unsigned int radio, bool onHeadset);
@@ -221,9 +288,9 @@ namespace afv_native { namespace afv {
 
         void putAudioFrame(const audio::SampleType *bufferIn) override;
         audio::SourceStatus getAudioFrame(audio::SampleType *bufferOut, bool onHeadset);
-
-        /** Contains the number of IncomingAudioStreams known to the simulation stack */
-        std::atomic<uint32_t> IncomingAudioStreams;
+        /** getAudioSamples fetches the next numSamples samples of the headset or speaker mix,
+         * which needn't be a whole frame. */
+        audio::SourceStatus getAudioSamples(audio::SampleType *bufferOut, size_t numSamples, bool onHeadset);
 
         void setTick(std::shared_ptr<audio::ITick> tick);
 
@@ -238,18 +305,11 @@ namespace afv_native { namespace afv {
         }
 
       protected:
-        /** maintenanceTimerIntervalMs is the internal in milliseconds between periodic cleanups
-         * of the inbound audio frame objects.
-         *
-         * This maintenance occurs in the main execution thread as not to hold the audio playback
-         * thread unnecessarily, particularly as it may involve alloc/free operations.
-         *
-         * The current constant of 30s should be frequent enough to prevent massive memory issues,
-         * without causing performance issues.
-         */
-        static const int maintenanceTimerIntervalMs = 30 * 1000; /* every 30s */
-        static const int voiceTimeoutIntervalMs     = 2 * 1000;
-        static const int voiceTimeoutIntervalS      = 2;
+        /** The voice timeouts share the stream expiry's resolution, expiryTickMs. */
+        static const int voiceTimeoutIntervalMs = 2 * 1000;
+        /** renderEventIntervalMs is how often the events raised by the audio render are
+         * dispatched to the client callbacks. */
+        static const int renderEventIntervalMs = 10;
 
         util::ChainedCallback<void(ClientEventType, void *, void *)> *ClientEventCallback;
 
@@ -262,15 +322,12 @@ namespace afv_native { namespace afv {
         double                           mClientAltitudeMSLM = 100;
         double                           mClientAltitudeGLM  = 100;
 
-        std::mutex mStreamMapLock;
-        std::unordered_map<std::string, struct AtcCallsignMeta> mHeadsetIncomingStreams;
-        std::unordered_map<std::string, struct AtcCallsignMeta> mSpeakerIncomingStreams;
-
         std::mutex                            mRadioStateLock;
-        std::atomic<bool>                     mPtt;
+        /** mVoiceTimeouts holds each radio's voiceTimeout.  Guarded by mRadioStateLock. */
+        util::TimerWheel<unsigned int>        mVoiceTimeouts;
         bool                                  mLastFramePtt;
         std::atomic<uint32_t>                 mTxSequence;
-        std::map<unsigned int, AtcRadioState> mRadioState;
+        AtcRadioTable                         mRadios;
         std::shared_ptr<audio::ITick>         mTick;
 
         bool mDefaultEnableHfSquelch = false;
@@ -279,53 +336,43 @@ namespace afv_native { namespace afv {
         std::shared_ptr<AtcOutputAudioDevice> mHeadsetDevice;
         std::shared_ptr<AtcOutputAudioDevice> mSpeakerDevice;
 
-        std::shared_ptr<OutputDeviceState> mHeadsetState;
-        std::shared_ptr<OutputDeviceState> mSpeakerState;
-
         float mMicVolume = 1.0f;
 
         unsigned int mLastReceivedRadio;
 
         std::shared_ptr<VoiceCompressionSink>     mVoiceSink;
         std::shared_ptr<audio::SpeexPreprocessor> mVoiceFilter;
+        /** mFecPacketLoss is the setFecPacketLoss() setting. */
+        std::atomic<int> mFecPacketLoss {0};
 
         event::EventCallbackTimer mMaintenanceTimer;
         event::EventCallbackTimer mVoiceTimeoutTimer;
+        event::EventCallbackTimer mRenderEventTimer;
+        uint64_t                  mReportedDroppedRenderEvents = 0;
         RollingAverage<double>    mVuMeter;
 
-        void resetRadioFx(unsigned int radio, bool except_click = false);
-
-        void set_radio_effects(unsigned int rxIter);
+        /** publish_radio_config rebuilds the render snapshot from mRadios.
+         *
+         * @note must be called with mRadioStateLock held.
+         */
+        void publish_radio_config();
 
-        bool mix_effect(std::shared_ptr<audio::ISampleSource> effect, float gain, std::shared_ptr<OutputDeviceState> state);
+        /** handle_rx_transition updates the bookkeeping and notifies the client when a radio
+         * starts or stops receiving voice.  Runs on the event loop.
+         */
+        void handle_rx_transition(unsigned int freq, bool rxBegin);
 
-        void processCompressedFrame(std::vector<unsigned char> compressedData) override;
+        void processCompressedFrame(const std::vector<unsigned char> &compressedData) override;
+        bool skipCompressedFrame() override;
 
         static void dtoHandler(const std::string &dtoName, const unsigned char *bufIn, size_t bufLen, void *user_data);
         void instDtoHandler(const std::string &dtoName, const unsigned char *bufIn, size_t bufLen);
 
         void maintainIncomingStreams();
         void maintainVoiceTimeout();
-
-      private:
-        bool _process_radio(const std::map<void *, audio::SampleType[audio::frameSizeSamples]> &sampleCache, unsigned int rxIter, bool onHeadset);
-
-        void interleave(audio::SampleType *leftChannel, audio::SampleType *rightChannel, audio::SampleType *outputBuffer, size_t numSamples);
-
-        /** mix_buffers is a utility function that mixes two buffers of audio together. The src_dst
-         * buffer is assumed to be the final output buffer and is modified by the mixing in place.
-         * src2 is read-only and will be scaled by the provided linear gain.
-         *
-         * @note as this mixer has some really fundamental assumptions about buffer alignment which
-         * are required as it uses SSE2 intrinsics to perform the mixing.  These requirements are
-         * met inside elsewhere inside this class.
-         *
-         * @param src_dst pointer to the source and destination buffer.
-         * @param src2 pointer to the origin of the samples to mix in.
-         * @param src2_gain linear gain to apply to src2.
-         */
-        static void mix_buffers(audio::SampleType *RESTRICT src_dst, const audio::SampleType *RESTRICT src2, float src2_gain = 1.0);
+        void dispatchRenderEvents();
     };
+
 }} // namespace afv_native::afv
 
-#endif // AFV_NATIVE_RADIOSIMULATION_H
+#endif // AFV_NATIVE_ATCRADIOSIMULATION_H
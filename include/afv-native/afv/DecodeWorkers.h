@@ -0,0 +1,80 @@
+#pragma once
+#include "afv-native/afv/RemoteVoiceSource.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace afv_native { namespace afv {
+    /** DecodeWorkers takes the Opus decode off the audio thread.
+     *
+     * Each registered source is given to one of the worker threads, which keeps the next frame
+     * decoded into the source's PCM ring (see RemoteVoiceSource::decodeAhead()).  The render
+     * then only copies the frame out, and calls wake() once it has, so the worker decodes the
+     * one after.  A source is always decoded by the same thread, which stands in for the
+     * render as its jitter buffer's consumer.
+     *
+     * Decoding a frame ahead of the render means a stream plays a frame later than it would
+     * decoded inline.
+     */
+    class DecodeWorkers {
+      public:
+        /** @param framesDecoded is counted up by each frame the workers decode.
+         * @param decodeNs is counted up by the time the workers spend decoding. */
+        DecodeWorkers(unsigned int threads, std::atomic<uint64_t> &framesDecoded, std::atomic<uint64_t> &decodeNs);
+        ~DecodeWorkers();
+
+        DecodeWorkers(const DecodeWorkers &)            = delete;
+        DecodeWorkers &operator=(const DecodeWorkers &) = delete;
+
+        /** add starts decoding source ahead. */
+        void add(std::shared_ptr<RemoteVoiceSource> source);
+
+        /** remove stops decoding source.  A worker may still be part way through a frame of
+         * it, so its last reference may be the worker's. */
+        void remove(const RemoteVoiceSource *source);
+
+        /** clear stops decoding every source. */
+        void clear();
+
+        /** wake has the workers top up every source's ring.  It never blocks, so it can be
+         * called from the render. */
+        void wake();
+
+        /** stop joins the threads.  Nothing is decoded after it returns, and the sources'
+         * jitter buffers can be consumed by somebody else. */
+        void stop();
+
+        /** waitIdle waits for the workers to finish topping up after the last wake(). */
+        void waitIdle() const;
+
+        unsigned int getThreadCount() const;
+
+      private:
+        struct Entry {
+            std::shared_ptr<RemoteVoiceSource> source;
+            unsigned int                       worker;
+        };
+
+        void worker_main(unsigned int worker);
+
+        std::atomic<uint64_t> &mFramesDecoded;
+        std::atomic<uint64_t> &mDecodeNs;
+
+        std::mutex         mSourcesLock;
+        std::vector<Entry> mSources;
+        unsigned int       mNextWorker;
+
+        std::mutex              mWakeLock;
+        std::condition_variable mWakeReady;
+        bool                    mStopping;
+        std::atomic<uint64_t>   mWakes;
+        /** mPasses holds, for each thread, the wake() its last pass started after. */
+        std::unique_ptr<std::atomic<uint64_t>[]> mPasses;
+
+        std::vector<std::thread> mThreads;
+    };
+}} // namespace afv_native::afv
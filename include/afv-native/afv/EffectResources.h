@@ -48,6 +48,10 @@ namespace afv_native { namespace afv {
         std::shared_ptr<audio::ISampleStorage> mHfWhiteNoise;
 
         explicit EffectResources(const std::string &basePath);
+
+        /** creates a copy of source with every effect decimated by factor, for rendering at a
+         * reduced sample rate.  Effects missing from source are missing from the copy too. */
+        EffectResources(const EffectResources &source, unsigned int factor);
     };
 }} // namespace afv_native::afv
 
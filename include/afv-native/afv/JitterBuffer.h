@@ -0,0 +1,182 @@
+#pragma once
+#include "afv-native/audio/audio_params.h"
+#include "afv-native/util/monotime.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace afv_native { namespace afv {
+    /** JitterBuffer puts a stream's voice packets back in SequenceCounter order and hands them
+     * out a frame at a time, playing far enough behind the sender to ride out the variation in
+     * their arrival times.
+     *
+     * put() is called from a single producer (the network thread) and get() from a single
+     * consumer (the audio thread).  Neither locks or touches the heap: packets are copied into
+     * a fixed ring of slots indexed by sequence number, and each slot is handed between the two
+     * by an atomic stamp.
+     *
+     * A transmission starts playing once its first packet has been held for the target delay,
+     * which is no time at all until the stream has shown some jitter.  The target is the worst
+     * lateness of any packet against the earliest in its transmission, decaying away slowly, in
+     * whole frames.  If the buffer runs dry in the middle of a transmission, the frame is
+     * concealed and playout holds where it is, which adds a frame to the delay.  If it gets
+     * more than maxExcessFrames behind the target, packets are discarded to catch it up.
+     *
+     * A frame whose packet is missing while the one after it is already here is handed out for
+     * recovery from that packet's in-band FEC, rather than being concealed.
+     *
+     * A sender using DTX sends the first frame of silence and then skips those after it, bar a
+     * keep-alive now and then.  The frames missing after a DTX packet (one of dtxPacketBytes or
+     * less) are taken to be skipped rather than lost: they aren't counted as Lost, and playout
+     * keeps time through them, concealing each, instead of holding for them.
+     */
+    class JitterBuffer {
+      public:
+        static const size_t slotCount = 32;
+        /** the largest packet Opus will produce for a single frame */
+        static const size_t       maxPacketBytes  = 1275;
+        static const unsigned int maxTargetFrames = 10;
+        static const unsigned int maxExcessFrames = 2;
+        /** a packet this size or smaller is a DTX frame - the sender may skip the frames
+         * after it */
+        static const size_t dtxPacketBytes = 2;
+
+        enum class Result {
+            /** the next packet was copied out */
+            Packet,
+            /** the next packet is lost, but the one after it was copied out so the frame can be
+             * recovered from its in-band FEC.  That packet is still played next. */
+            Recover,
+            /** the next packet is late or lost, and the frame should be concealed */
+            Conceal,
+            /** a transmission is being buffered, and the frame should be silent */
+            Waiting,
+            /** there's no transmission being played */
+            Idle,
+        };
+
+        /** @param timeoutFrames how many frames in a row may be concealed, with nothing else
+         *      arriving, before the transmission is given up on. */
+        explicit JitterBuffer(unsigned int timeoutFrames, int frameLengthMs = audio::frameLengthMs);
+
+        JitterBuffer(const JitterBuffer &)            = delete;
+        JitterBuffer &operator=(const JitterBuffer &) = delete;
+
+        /** put stores a packet that arrived at arrivalMs (on the monotime clock).  Producer
+         * only.
+         *
+         * Packets that are too late to be played are counted and dropped, as are packets longer
+         * than maxPacketBytes.  A packet far enough behind everything else that it can't just be
+         * late means the sender has started counting again, and playout restarts from it.
+         */
+        void put(uint32_t sequence, const unsigned char *data, size_t length, bool lastPacket, util::monotime_t arrivalMs);
+
+        /** get takes the next frame's packet.  Consumer only.
+         *
+         * @param packetOut must hold maxPacketBytes, and is filled in if the result is Packet.
+         * @param lengthOut is set to the packet's length if the result is Packet.
+         */
+        Result get(unsigned char *packetOut, size_t &lengthOut);
+
+        /** reset drops everything buffered and stops playing, but keeps the delay the stream
+         * has adapted to.  Consumer only. */
+        void reset();
+
+        /** clear returns the buffer to how it was constructed, counters and all, ready for a
+         * different stream.  Neither side may be using it. */
+        void clear();
+
+        /** getTargetDelayFrames returns how many frames a transmission is currently held for
+         * before it starts playing. */
+        unsigned int getTargetDelayFrames() const;
+
+        /** Contains the number of packets stored to be played */
+        std::atomic<uint64_t> Received;
+
+        /** Contains the number of packets that arrived after they were due to be played */
+        std::atomic<uint64_t> Late;
+
+        /** Contains the number of packets skipped over in the sequence that haven't turned up
+         * since (a packet that turns up late is only counted as late, and the frames a DTX
+         * sender skipped aren't counted at all) */
+        std::atomic<uint64_t> Lost;
+
+        /** Contains the number of frames that had to be concealed because their packet wasn't
+         * there in time, and neither was the next one to recover it from */
+        std::atomic<uint64_t> Concealed;
+
+        /** Contains the number of frames handed out for recovery from the next packet's FEC */
+        std::atomic<uint64_t> Recovered;
+
+        /** Contains the number of packets discarded to bring the delay back down to the
+         * target */
+        std::atomic<uint64_t> Discarded;
+
+      private:
+        enum class State {
+            Idle,
+            Waiting,
+            Playing,
+        };
+
+        /** Slot holds a packet.  Its stamp is the packet's sequence + 1, 0 if the slot is empty,
+         * or busyStamp while one side is copying in or out of it. */
+        struct Slot {
+            std::atomic<uint64_t> stamp;
+            size_t                length;
+            unsigned char         data[maxPacketBytes];
+        };
+
+        static const uint64_t busyStamp = ~static_cast<uint64_t>(0);
+
+        /** take copies packet sequence out of its slot, if it's there. */
+        bool take(uint64_t sequence, unsigned char *packetOut, size_t &lengthOut);
+
+        /** peek copies packet sequence out of its slot, if it's there, and leaves it there. */
+        bool peek(uint64_t sequence, unsigned char *packetOut, size_t &lengthOut);
+
+        /** first_buffered returns the earliest packet in the ring from mNext on, up to (but not
+         * including) head. */
+        uint64_t first_buffered(uint64_t head) const;
+
+        void advance();
+        void stop();
+
+        const unsigned int mTimeoutFrames;
+        const int          mFrameLengthMs;
+
+        Slot mSlots[slotCount];
+
+        /** the newest sequence received + 1, or 0 for none.  Written by the producer. */
+        std::atomic<uint64_t> mHead;
+        /** the sequence of the last packet of a transmission + 1, or 0 for none.  Written by the
+         * producer. */
+        std::atomic<uint64_t> mEnd;
+        /** the next sequence to be played; anything before it is late.  Written by the
+         * consumer. */
+        std::atomic<uint64_t> mPlayed;
+        /** set by the producer when the sequence has started again, and cleared by the consumer
+         * once it has too */
+        std::atomic<bool>         mRestart;
+        std::atomic<unsigned int> mTargetFrames;
+
+        // producer side only
+        uint64_t         mNewest;
+        uint64_t         mTransmissionFirst;
+        int64_t          mMinTransitMs;
+        double           mPeakExcessMs;
+        util::monotime_t mLastArrivalMs;
+        bool             mLastWasFinal;
+        /** the newest packet was a DTX frame */
+        bool mNewestWasDtx;
+
+        // consumer side only
+        State        mState;
+        uint64_t     mNext;
+        uint64_t     mPlayingFrom;
+        unsigned int mWaitedFrames;
+        unsigned int mStalledFrames;
+        /** the last packet played was a DTX frame */
+        bool mPlayedDtx;
+    };
+}} // namespace afv_native::afv
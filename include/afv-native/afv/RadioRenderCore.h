@@ -0,0 +1,766 @@
+#pragma once
+#include "afv-native/afv/DecodeWorkers.h"
+#include "afv-native/afv/EffectResources.h"
+#include "afv-native/afv/RemoteVoiceSource.h"
+#include "afv-native/afv/RenderGovernor.h"
+#include "afv-native/afv/VoiceSourcePool.h"
+#include "afv-native/afv/dto/voice_server/AudioRxOnTransceivers.h"
+#include "afv-native/audio/FrameRing.h"
+#include "afv-native/audio/FrameSlab.h"
+#include "afv-native/audio/ISampleSource.h"
+#include "afv-native/audio/PolyphaseUpsampler.h"
+#include "afv-native/audio/RecordedSampleSource.h"
+#include "afv-native/audio/SimpleCompressorEffect.h"
+#include "afv-native/audio/SineToneSource.h"
+#include "afv-native/audio/VHFFilterSource.h"
+#include "afv-native/hardwareType.h"
+#include "afv-native/util/BoundedQueue.h"
+#include "afv-native/util/RcuCell.h"
+#include "afv-native/util/TimerWheel.h"
+#include "afv-native/util/WorkStealingPool.h"
+#include "afv-native/util/monotime.h"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace afv_native { namespace afv {
+    /** NoiseBed lists the looped background effects that can be shared by the radios on a
+     * bus. */
+    enum NoiseBed : uint8_t {
+        NoiseCrackle = 0,
+        NoiseHfWhiteNoise,
+        NoiseVhfWhiteNoise,
+        NoiseAcBus,
+        NoiseCount,
+    };
+
+    /** EffectVoice is an effect preallocated for the life of a radio.
+     *
+     * Instead of creating the effect when it's needed and freeing it when it stops, the render
+     * starts and stops the voice, which rewinds the effect in place.
+     */
+    template <typename EffectT>
+    class EffectVoice {
+      public:
+        template <typename... Args>
+        explicit EffectVoice(Args &&...args): effect(std::forward<Args>(args)...) {
+        }
+
+        void start() {
+            effect.reset();
+            active = true;
+        }
+
+        void stop() {
+            active = false;
+        }
+
+        EffectT effect;
+        bool    active = false;
+    };
+
+    /** RadioDsp is the mutable signal-processing state of a single radio.
+     *
+     * It owns the radio's effect voices (and their playback positions) and filter state, and is
+     * owned by the audio render - the control side only ever creates a fresh one, it never
+     * touches an existing one.  Everything is allocated up front so the render can start and
+     * stop reception without going near the heap.
+     *
+     * A radio renders at sampleRate, which is either the normal rate or reducedSampleRateHz,
+     * and resources must already be at that rate.  Each render produces frameSamples samples -
+     * quantum, the render quantum at that rate, or a whole frame if quantum is 0.
+     */
+    class RadioDsp {
+      public:
+        RadioDsp(const EffectResources &resources, HardwareType hardware, int sampleRate = audio::sampleRateHz, size_t quantum = 0);
+
+        RadioDsp(const RadioDsp &)            = delete;
+        RadioDsp &operator=(const RadioDsp &) = delete;
+
+        const int    sampleRate;
+        const size_t frameSamples;
+
+        EffectVoice<audio::RecordedSampleSource> Click;
+        EffectVoice<audio::RecordedSampleSource> Crackle;
+        EffectVoice<audio::RecordedSampleSource> AcBus;
+        EffectVoice<audio::RecordedSampleSource> VhfWhiteNoise;
+        EffectVoice<audio::RecordedSampleSource> HfWhiteNoise;
+        EffectVoice<audio::SineToneSource>       BlockTone;
+        audio::SimpleCompressorEffect            simpleCompressorEffect;
+        EffectVoice<audio::VHFFilterSource>      vhfFilter;
+        /** number of streams mixed on the last render, also read by the control side */
+        std::atomic<int> mLastRxCount{0};
+        /** the frequency the radio was last rendered on.  Retuning stops everything but the
+         * click, which is then heard as the squelch closes. */
+        unsigned int frequency = 0;
+
+        /** The radio's own work buffers, so radios can be rendered in parallel.  channelBuffer
+         * holds the rendered frame until it's mixed into the output bus, which only happens if
+         * mixToBus is set. */
+        audio::SampleType channelBuffer[audio::frameSizeSamples];
+        audio::SampleType fetchBuffer[audio::frameSizeSamples];
+        bool              mixToBus = false;
+        /** With a shared noise bed, the gain the radio wants each noise bed mixed at on the
+         * last render, indexed by NoiseBed.  All zero otherwise. */
+        float noiseGains[NoiseCount] = {};
+        /** idle is set once the radio has nothing left to play - no streams and no click -
+         * after which it's skipped until a stream turns up on it again.  skipped is set if the
+         * last render did just that. */
+        bool idle    = true;
+        bool skipped = false;
+    };
+
+    /** OutputBus identifies the mixes produced by each render tick.  How many channels each
+     * one has is up to the render policy. */
+    enum OutputBus : uint8_t {
+        BusHeadset = 0,
+        BusSpeaker,
+        BusCount,
+    };
+
+    /** RenderRadioConfig is the render path's read-only view of a single radio - its hot side.
+     *
+     * These are published as a whole RenderConfigSnapshot whenever the control side changes
+     * anything the render depends on, so rendering never has to take the radio state lock.
+     * They're kept small so the render's scan over every radio stays within a few cache lines.
+     */
+    struct RenderRadioConfig {
+        RadioDsp    *dsp; // owned by the snapshot's dspOwners
+        unsigned int Frequency;
+        float        Gain;
+        /** the radio's gain on each channel of a stereo bus.  A mono bus only uses leftGain. */
+        float        leftGain;
+        float        rightGain;
+        OutputBus    bus;
+        bool         bypassEffects;
+        bool         hfSquelch;
+        bool         tx;
+    };
+
+    struct RenderConfigSnapshot {
+        std::vector<RenderRadioConfig> radios;
+        /** frequencies of the receiving radios, sorted, for ranking streams against the
+         * decoder budget */
+        std::vector<unsigned int> rxFrequencies;
+        /** keeps every radio's dsp alive for as long as the snapshot is in use */
+        std::vector<std::shared_ptr<RadioDsp>> dspOwners;
+        /** IDs of all transceivers on transmitting radios, for the voice transmit path */
+        std::vector<uint16_t> txTransceiverIDs;
+    };
+
+    /** RenderBus is one output mix, and the ring its audio device reads it from.
+     *
+     * Each slot of the ring holds one render quantum, up to a whole frame.  The device reads
+     * through the oldest of them with a cursor, so it can ask for any number of samples at a
+     * time.  readChunk, readOffset and readLength are that cursor, and only ever touched by
+     * the bus's device.
+     *
+     * A bus is only rendered ahead of its device by the quantum it's read next.  The device
+     * sets wasRead whenever it reads, and a tick run for the other bus only renders this one
+     * if it has been read since the last tick - so a device that isn't running doesn't have
+     * its ring filled up with audio it would play late once it starts.  lastReadMs is when the
+     * device last read, so that a device that has been away (stopped, or restarted) throws
+     * away whatever was left in the ring.
+     *
+     * With a shared noise bed, the bus also plays each noise bed once for all of its radios,
+     * as loud as their separate beds would have been together.  noiseGains sums the squares of
+     * the gains they asked for, per channel, as the radios are mixed down; each bed is played
+     * at its square root, and the sums are cleared once the beds have been mixed in.
+     *
+     * Radios rendering at the reduced rate are mixed into reducedFrame instead, one plane per
+     * channel, which is then upsampled into the bus's frame once for all of them.  reducedLive
+     * is set if any were mixed this tick.
+     */
+    struct RenderBus {
+        /** how far ahead of its device a bus may be rendered, in frames */
+        static const size_t ringFrames = 4;
+        /** a device that hasn't read for this long has stopped, and what's left in the ring is
+         * stale */
+        static const util::monotime_t restartGapMs = ringFrames * audio::frameLengthMs;
+
+        RenderBus(unsigned int channels, const EffectResources &resources);
+
+        const unsigned int channels;
+        audio::FrameRing   ring;
+
+        audio::SampleType readChunk[audio::frameSizeSamples * 2];
+        size_t            readOffset = 0;
+        size_t            readLength = 0;
+        util::monotime_t  lastReadMs = 0;
+        std::atomic<bool> wasRead {false};
+
+        std::array<EffectVoice<audio::RecordedSampleSource>, NoiseCount> noise;
+        float             noiseGains[NoiseCount][2] = {};
+        audio::SampleType noiseBuffer[audio::frameSizeSamples];
+
+        std::array<audio::PolyphaseUpsampler, 2> upsamplers;
+        audio::SampleType                        reducedFrame[2][audio::reducedFrameSizeSamples];
+        audio::SampleType                        upsampleBuffer[audio::frameSizeSamples];
+        bool                                     reducedLive = false;
+    };
+
+    /** DecodedFrame is the shared decode stage for a single packet stream.
+     *
+     * Each stream decodes a frame into its slot of the render's frame slab, and every bus
+     * mixes from it.  The render ticks then work through the frame a quantum at a time, with
+     * cursor marking where this tick's quantum starts; the next frame is decoded once the
+     * cursor wraps back round to 0.  live is set for the streams that have audio to mix this
+     * tick.  sampleRate is the rate the stream decodes at - only radios at the same rate mix
+     * it.
+     */
+    struct DecodedFrame {
+        size_t              slot       = audio::FrameSlab::InvalidSlot;
+        size_t              cursor     = 0;
+        audio::SourceStatus status     = audio::SourceStatus::Closed;
+        int                 sampleRate = audio::sampleRateHz;
+        bool                live       = false;
+    };
+
+    /** RenderStream is the per-packetstream metadata held by the render.
+     *
+     * It's used to hold the RemoteVoiceSource object (from the render's VoiceSourcePool) for
+     * that callsign+channel combination, the frequencies this packet stream is indexed under
+     * and the decoded frame shared by both output buses.  The expiry timer, keyed by callsign,
+     * is pushed back by every packet.  bestDistanceRatio is the best DistanceRatio of the last
+     * packet, across all of its transceivers.
+     */
+    struct RenderStream {
+        std::shared_ptr<RemoteVoiceSource>   source;
+        std::vector<unsigned int>            frequencies;
+        float                                bestDistanceRatio = 0.0f;
+        DecodedFrame                         decoded;
+        util::TimerWheel<std::string>::Timer expiry;
+        /** the jitter buffer's Received and Lost counters when the packet loss was last
+         * measured */
+        uint64_t lossReceived = 0;
+        uint64_t lossLost     = 0;
+        explicit RenderStream(std::shared_ptr<RemoteVoiceSource> source);
+    };
+
+    /** StreamJitterStats is a snapshot of an incoming stream's jitter buffer counters, see
+     * JitterBuffer.
+     */
+    struct StreamJitterStats {
+        std::string  callsign;
+        uint64_t     late          = 0;
+        uint64_t     lost          = 0;
+        uint64_t     concealed     = 0;
+        uint64_t     recovered     = 0;
+        uint64_t     discarded     = 0;
+        unsigned int targetDelayMs = 0;
+    };
+
+    /** StreamContribution is an entry in the frequency index - a stream heard on the
+     * frequency, the DistanceRatio of its closest transceiver on it, and the crackle that
+     * distance works out to.  The crackle factor is worked out as packets arrive, so the render
+     * only has to apply it.
+     */
+    struct StreamContribution {
+        RenderStream *stream;
+        float         distanceRatio;
+        float         crackleFactor;
+
+        /** crackleFactorFor returns how much crackle a transmission heard at distanceRatio has,
+         * from 0 up to 0.2 at the edge of range. */
+        static float crackleFactorFor(float distanceRatio);
+
+        /** setDistanceRatio updates distanceRatio, and crackleFactor if it changed. */
+        void setDistanceRatio(float ratio);
+    };
+
+    /** StreamRank orders streams for the decoder budget: streams heard on a receiving radio
+     * come first, and then the closest - the one with the best DistanceRatio.
+     */
+    struct StreamRank {
+        bool  rx            = false;
+        float distanceRatio = 0.0f;
+
+        bool operator<(const StreamRank &other) const {
+            if (rx != other.rx) {
+                return !rx;
+            }
+            return distanceRatio < other.distanceRatio;
+        }
+    };
+
+    /** RenderEvent is a notification raised by the audio render.
+     *
+     * The render can't call back into the host or log itself, so these are queued and
+     * dispatched from the event loop instead.
+     */
+    struct RenderEvent {
+        enum Type : uint8_t {
+            FrequencyRxBegin,
+            FrequencyRxEnd,
+        };
+        Type         type;
+        unsigned int frequency;
+    };
+
+    /** AtcRenderPolicy renders for ATCRadioSimulation: radios are keyed by frequency and each
+     * goes to either the stereo headset or the mono speaker.  Reception starting and stopping is
+     * raised as render events, and a radio being transmitted on is only muted, so it still
+     * knows whether it's receiving once the PTT is released.
+     */
+    struct AtcRenderPolicy {
+        static const bool rxEvents                = true;
+        static const bool holdRxWhileTransmitting = true;
+
+        static const char *logName() {
+            return "ATCRadioSimulation";
+        }
+
+        static unsigned int busChannels(OutputBus bus) {
+            return bus == BusHeadset ? 2 : 1;
+        }
+    };
+
+    /** PilotRenderPolicy renders for RadioSimulation: radios are indexed, and both buses are
+     * stereo so that the first two radios can be split across the channels.  Nothing listens
+     * for render events, and the radio being transmitted on is reset outright.
+     */
+    struct PilotRenderPolicy {
+        static const bool rxEvents                = false;
+        static const bool holdRxWhileTransmitting = false;
+
+        static const char *logName() {
+            return "RadioSimulation";
+        }
+
+        static unsigned int busChannels(OutputBus) {
+            return 2;
+        }
+    };
+
+    /** RadioRenderCore is the receive side shared by the radio simulations: the incoming
+     * streams, their decoders and the frequency index, each radio's effects, and the render
+     * tick that mixes them all into the output buses.
+     *
+     * The simulation keeps its radios however suits it, and publishes them to the render as a
+     * RenderConfigSnapshot; everything that differs between simulations within the render
+     * itself comes from Policy.  Streams and the render state are guarded by mStreamMapLock.
+     *
+     * @tparam Policy AtcRenderPolicy or PilotRenderPolicy.
+     */
+    template <typename Policy>
+    class RadioRenderCore {
+      public:
+        explicit RadioRenderCore(const EffectResources &resources);
+
+        RadioRenderCore(const RadioRenderCore &)            = delete;
+        RadioRenderCore &operator=(const RadioRenderCore &) = delete;
+
+        /** setDspThreads renders the radios on a pool of worker threads, on top of the audio
+         * thread itself.  0 threads (the default) renders everything on the audio thread.
+         *
+         * Radios are always mixed into the output in the same order, so the output is
+         * bit-identical whatever the thread count.  Deterministic mode also turns off work
+         * stealing, so each radio is always rendered by the same thread.
+         */
+        void setDspThreads(unsigned int threads, bool deterministic = false);
+
+        /** setDecodeThreads decodes the incoming streams on this many worker threads, so
+         * that the render only has to copy each stream's frame out.  0 (the default) decodes
+         * on the audio thread, as the render needs each frame.
+         *
+         * The workers decode each frame while the render is still playing the last one, so
+         * streams play a frame later than when they're decoded on the audio thread.
+         */
+        void         setDecodeThreads(unsigned int threads);
+        unsigned int getDecodeThreads();
+
+        /** waitForDecodeWorkers waits for the decode workers to catch up with the last render
+         * tick, if there are any.  For measuring the render faster than real time. */
+        void waitForDecodeWorkers();
+
+        /** setSharedNoiseBed plays the crackle, white noise and AC bus beds once per output bus,
+         * instead of mixing a copy into every radio.  Each bed is played at the power sum of
+         * the radios' noise gains, so it's as loud as the radios' own (uncorrelated) beds would
+         * have been together.
+         *
+         * It's much cheaper with many radios receiving at once, but every radio on the bus then
+         * hears the same noise.  Leave it off (the default) for each radio to get its own.
+         */
+        void setSharedNoiseBed(bool shared);
+        bool getSharedNoiseBed();
+
+        /** setMaxDecoders caps the number of incoming streams decoded at once.  0 (the
+         * default) leaves it unlimited.
+         *
+         * With the cap reached, a new stream only gets a decoder if it outranks the lowest
+         * ranked stream, which is evicted to make room.  Streams heard on a receiving radio
+         * rank above those that aren't, and then by their best DistanceRatio.  Lowering the cap
+         * evicts the lowest ranked streams straight away.
+         */
+        void   setMaxDecoders(size_t maxDecoders);
+        size_t getMaxDecoders();
+
+        /** getReducedRateDsp returns true if the radios decode and render at
+         * reducedSampleRateHz, see the simulation's setReducedRateDsp(). */
+        bool getReducedRateDsp() const;
+
+        /** getRenderQuantum returns the number of samples each render tick produces, see the
+         * simulation's setRenderQuantum(). */
+        size_t getRenderQuantum() const;
+
+        /** validRenderQuantum returns true if the render can run in quanta of quantum
+         * samples: at least minRenderQuantumSamples, a whole fraction of a frame, and a whole
+         * number of samples at the reduced rate. */
+        static bool validRenderQuantum(size_t quantum);
+
+        /** setRenderGovernor turns the CPU governor on or off (the default).
+         *
+         * While it's on, render ticks that run short of CPU give up effects in the order of
+         * RenderTier, and get them back once there's headroom again.  TierCappedDecoders is
+         * only used if setRenderGovernorDecoderCap() allows it.
+         */
+        void setRenderGovernor(bool enabled);
+        bool getRenderGovernor() const;
+
+        /** setRenderGovernorDecoderCap lets the governor decode fewer streams as its last
+         * resort.  At TierCappedDecoders, the streams are cut back to three quarters of what
+         * they were (but no fewer than governorMinDecoders) until the tier recovers, on top of
+         * any setMaxDecoders() cap.  Off by default, as the streams evicted aren't heard. */
+        void setRenderGovernorDecoderCap(bool capDecoders);
+        bool getRenderGovernorDecoderCap() const;
+
+        /** setRenderBudget sets how long, in microseconds, a render tick may take before the
+         * governor counts it as an overrun.  The default is half a frame.
+         *
+         * The budget is for a whole frame's worth of rendering: with a shorter render quantum,
+         * each tick is measured as if it had rendered a frame at the same rate. */
+        void         setRenderBudget(unsigned int budgetUs);
+        unsigned int getRenderBudget() const;
+
+        /** Returns the tier the governor is currently rendering at */
+        RenderTier getRenderTier() const;
+
+        /** Returns the number of render ticks that overran the render budget */
+        uint64_t getRenderOverruns() const;
+
+        /** Returns the number of times the governor has changed tier */
+        uint64_t getRenderTierChanges() const;
+
+        /** Contains the number of IncomingAudioStreams known to the simulation stack */
+        std::atomic<uint32_t> IncomingAudioStreams;
+
+        /** Contains the number of render ticks run, each producing a quantum for every bus */
+        std::atomic<uint64_t> RenderTicks;
+
+        /** Contains the number of bus quanta skipped because the bus's ring was full - ie, its
+         * device had fallen behind.  A bus whose device isn't reading isn't counted. */
+        std::atomic<uint64_t> BusFramesDropped;
+
+        /** Contains the total time, in nanoseconds, render ticks have spent waiting for the
+         * stream lock */
+        std::atomic<uint64_t> RenderLockWaitNs;
+
+        /** Contains the number of render ticks that found nothing being received and every
+         * radio idle, and so only had to output silence */
+        std::atomic<uint64_t> IdleRenderTicks;
+
+        /** Contains the total time, in nanoseconds, spent rendering idle and active ticks */
+        std::atomic<uint64_t> IdleRenderNs;
+        std::atomic<uint64_t> ActiveRenderNs;
+
+        /** Contains the number of times an idle radio was left out of an active tick */
+        std::atomic<uint64_t> IdleRadioRenders;
+
+        /** Contains the number of streams evicted to make room for a higher ranked one under
+         * the decoder budget */
+        std::atomic<uint64_t> DecoderEvictions;
+
+        /** Contains the number of streams refused a decoder because every one was taken by a
+         * higher ranked stream.  Each stream is only counted once until it expires. */
+        std::atomic<uint64_t> DecoderRejections;
+
+        /** Contains the number of frames decoded by the decode workers, and the time, in
+         * nanoseconds, they took to decode them */
+        std::atomic<uint64_t> DecodeWorkerFrames;
+        std::atomic<uint64_t> DecodeWorkerNs;
+
+        /** Returns the number of render events dropped because the event queue was full */
+        uint64_t getDroppedRenderEvents() const;
+
+        /** getStreamJitterStats replaces statsOut with the jitter buffer counters of each
+         * incoming stream.  A stream's counters go with it when it expires. */
+        void getStreamJitterStats(std::vector<StreamJitterStats> &statsOut);
+
+        /** getSourcePool returns the pool the streams' decoders and jitter buffers come from,
+         * for its hit rate and occupancy. */
+        const VoiceSourcePool &getSourcePool() const;
+
+        /** getMeasuredPacketLoss returns the percentage of packets lost across all of the
+         * incoming streams, averaged over the last few seconds of traffic.  It's the best guess
+         * there is at how lossy the network is on the way out, too.  It's 0 unless
+         * setMeasurePacketLoss() has turned the measurement on. */
+        unsigned int getMeasuredPacketLoss() const;
+
+        /** setMeasurePacketLoss turns the packet loss measurement on or off.  It's off by
+         * default, so that nothing has to walk the streams on every expiry tick unless someone
+         * is following the result. */
+        void setMeasurePacketLoss(bool measure);
+
+      protected:
+        /** expiryTickMs is the resolution of the stream expiry wheel, and so how often
+         * expire_streams() should be called.
+         *
+         * Expiry happens in the main execution thread as not to hold the audio playback thread
+         * unnecessarily, particularly as it may involve alloc/free operations.  Each tick only
+         * deals with the timers that are due, so it's cheap to run often.
+         */
+        static const int    expiryTickMs         = 100;
+        static const size_t renderEventQueueSize = 256;
+        /** governorMinDecoders is the fewest streams TierCappedDecoders will cut back to. */
+        static const size_t governorMinDecoders = 4;
+        /** pooledSources is how many stream sources are made ahead of time, before any
+         * setMaxDecoders() cap asks for more. */
+        static const size_t pooledSources = 8;
+
+        /** ingest_packet hands a voice packet to its stream, creating the stream (budget
+         * permitting) if it's the first packet from that callsign. */
+        void ingest_packet(const afv::dto::AudioRxOnTransceivers &pkt);
+
+        /** expire_streams drops the streams that have stopped receiving packets, and applies
+         * (or lifts) the governor's decoder cap. */
+        void expire_streams();
+
+        /** measure_packet_loss adds what the streams have received and lost since the last
+         * tick to the loss window, and folds the window into the measured loss once it's long
+         * enough.  Called from expire_streams() while the measurement is on. */
+        void measure_packet_loss();
+
+        /** reset_streams drops every stream. */
+        void reset_streams();
+
+        /** render_bus fills bufferOut with the next numSamples samples of bus, running render
+         * ticks as its ring runs dry.  bufferOut must hold Policy::busChannels(bus) channels. */
+        audio::SourceStatus render_bus(OutputBus bus, audio::SampleType *bufferOut, size_t numSamples = audio::frameSizeSamples);
+
+        /** set_reduced_rate switches the rate new streams decode at and make_radio_dsp()
+         * renders at, dropping every stream decoding at the old rate.  The simulation then has
+         * to replace its radios' dsps and publish them.
+         *
+         * The first switch to the reduced rate decimates the effects, which takes a moment.
+         *
+         * @return false if the rate was already set.
+         */
+        bool set_reduced_rate(bool reduced);
+
+        /** set_render_quantum switches the number of samples each render tick produces.  The
+         * streams pick up from the start of their next frame, and the simulation then has to
+         * replace its radios' dsps and publish them, as with set_reduced_rate().  Until it does,
+         * radios left at the old quantum are silent.
+         *
+         * @return false if the quantum was already set, or isn't valid.
+         */
+        bool set_render_quantum(size_t quantum);
+
+        /** make_radio_dsp creates a RadioDsp at the current rate and render quantum. */
+        std::shared_ptr<RadioDsp> make_radio_dsp(HardwareType hardware);
+
+        std::mutex mStreamMapLock;
+        /** mSourcePool recycles the incoming streams' sources.  It has its own lock, so it can
+         * be topped up without holding up the render. */
+        VoiceSourcePool mSourcePool;
+        /** mStreamExpiry times out the incoming streams that have stopped receiving packets.
+         * Guarded by mStreamMapLock. */
+        util::TimerWheel<std::string>                 mStreamExpiry;
+        std::unordered_map<std::string, RenderStream> mIncomingStreams;
+        /** mStreamFrames holds the decoded frame of every incoming stream, indexed by the
+         * stream's slot.  Slots are only acquired or released under mStreamMapLock from the
+         * network thread, so the renders never allocate.
+         */
+        audio::FrameSlab mStreamFrames;
+        /** mFrequencyStreams maps each frequency to the streams currently received on it.
+         *
+         * It's kept up to date as voice packets arrive, so each radio only has to look at the
+         * streams actually feeding it when rendering.
+         */
+        std::unordered_map<unsigned int, std::vector<StreamContribution>> mFrequencyStreams;
+        /** mMaxDecoders caps the size of mIncomingStreams, 0 for no cap.  Guarded by
+         * mStreamMapLock. */
+        size_t mMaxDecoders = 0;
+        /** mGovernorDecoderCap is the decoder cap applied at TierCappedDecoders, 0 when the
+         * governor isn't capping.  Guarded by mStreamMapLock. */
+        size_t mGovernorDecoderCap = 0;
+        /** mRejectedStreams holds the streams currently refused a decoder, with no source of
+         * their own.  They expire from mStreamExpiry just like the admitted streams.  Guarded
+         * by mStreamMapLock. */
+        std::unordered_map<std::string, util::TimerWheel<std::string>::Timer> mRejectedStreams;
+
+        std::atomic<bool> mPtt;
+        std::atomic<bool> mSharedNoiseBed;
+
+        /** mRenderResources are the effects radios render from at the normal rate, and
+         * mReducedResources a decimated copy of them, made the first time it's needed. */
+        const EffectResources           &mRenderResources;
+        std::unique_ptr<EffectResources> mReducedResources;
+        std::once_flag                   mReducedResourcesOnce;
+        std::atomic<bool>                mReducedRate;
+        /** mRenderQuantum is the number of samples (at the full rate) each render tick produces.
+         * Only changed under mStreamMapLock, so it holds still for the length of a tick. */
+        std::atomic<size_t> mRenderQuantum;
+        /** mRadioConfig is the snapshot of the simulation's radios the audio threads work
+         * from.  The simulation republishes it (serialised by its own radio state lock)
+         * whenever something the render depends on changes.
+         */
+        util::RcuCell<RenderConfigSnapshot> mRadioConfig;
+
+        /** mBuses are the outputs of the render tick, indexed by OutputBus. */
+        std::array<RenderBus, BusCount> mBuses;
+
+        util::BoundedQueue<RenderEvent, renderEventQueueSize> mRenderEvents;
+
+        /** mDspPool renders radios in parallel if setDspThreads() asked for it.  Swapped under
+         * mStreamMapLock. */
+        std::unique_ptr<util::WorkStealingPool> mDspPool;
+        /** mDecodeWorkers decodes the streams ahead of the render if setDecodeThreads() asked
+         * for it, and then the render only reads the streams' decoded frames.  Swapped under
+         * mStreamMapLock, and every stream is registered with it. */
+        std::unique_ptr<DecodeWorkers> mDecodeWorkers;
+
+        /** mGovernor measures every render tick, and picks the tier the next one renders at. */
+        RenderGovernor mGovernor;
+
+        /** mActiveRadios is the number of radios that weren't idle after the last active tick.
+         * While it's zero and no stream is live, a tick only has to output silence.  Guarded
+         * by mStreamMapLock. */
+        size_t mActiveRadios = 0;
+
+        /** the packets received and lost by the streams since the loss was last worked out,
+         * over mLossWindowTicks expiry ticks.  Guarded by mStreamMapLock. */
+        int64_t      mLossWindowReceived = 0;
+        int64_t      mLossWindowLost     = 0;
+        unsigned int mLossWindowTicks    = 0;
+        /** mPacketLoss is the smoothed loss, as a fraction.  Guarded by mStreamMapLock. */
+        double                    mPacketLoss = 0.0;
+        std::atomic<unsigned int> mMeasuredPacketLoss {0};
+        /** mMeasurePacketLoss is the setMeasurePacketLoss() setting.  mLossMeasuring is whether
+         * the streams' loss counters were brought up to date on the last tick; if they weren't,
+         * the next measurement has to start over from them.  Guarded by mStreamMapLock. */
+        std::atomic<bool> mMeasurePacketLoss {false};
+        bool              mLossMeasuring = false;
+
+      private:
+        typedef std::unordered_map<std::string, RenderStream>::iterator StreamIterator;
+
+        void resetRadioFx(RadioDsp &dsp, bool except_click = false);
+
+        void set_radio_effects(RadioDsp &dsp);
+
+        /** mix_effect mixes the next frame of an active effect voice into the radio's channel
+         * buffer, stopping the voice once the effect runs out. */
+        template <typename EffectT>
+        void mix_effect(EffectVoice<EffectT> &voice, float gain, RadioDsp &dsp);
+
+        /** _process_radio renders a single radio from the live streams indexed under its
+         * frequency into its dsp's channel buffer.  It only touches that radio's dsp, so
+         * different radios may be processed concurrently.
+         *
+         * With sharedNoiseBed, the noise beds are left to the bus and only their gains are
+         * recorded in the dsp.  tier is the governor's tier for this tick.
+         *
+         * @note must be called with mStreamMapLock held.
+         */
+        void _process_radio(const RenderRadioConfig &radio, bool sharedNoiseBed, RenderTier tier);
+
+        /** mix_radio_to_bus mixes a rendered radio into its output bus's frame, and adds its
+         * noise gains to the bus's. */
+        void mix_radio_to_bus(const RenderRadioConfig &radio, RenderBus &bus, audio::SampleType *busFrame);
+
+        /** upsample_bus mixes the radios rendered at the reduced rate into the bus's frame.
+         * It keeps going on silence until the upsamplers have played out. */
+        void upsample_bus(RenderBus &bus, audio::SampleType *busFrame, size_t quantum);
+
+        /** mix_noise_bed mixes the bus's shared noise beds into its frame, stopping the beds
+         * no radio wants any more. */
+        void mix_noise_bed(RenderBus &bus, audio::SampleType *busFrame, size_t quantum);
+
+        /** read_bus_frame copies the bus's next quantum into bufferOut, running a render tick
+         * if its ring is empty.
+         *
+         * @return the number of samples copied, per channel.
+         */
+        size_t read_bus_frame(RenderBus &bus, audio::SampleType *bufferOut);
+
+        /** quantum_at returns the render quantum in samples at sampleRate. */
+        size_t quantum_at(int sampleRate) const;
+
+        /** render_tick renders the next quantum of every bus that has room for it.
+         *
+         * Whichever device finds its ring empty first runs the tick; the others just pick up
+         * their frame from their ring.  Nothing is rendered if requester's ring was refilled
+         * while waiting for the lock.
+         */
+        void render_tick(const RenderBus &requester);
+
+        /** fetch_stream_frame decodes the next frame of a stream into its slot, or copies
+         * it there if the decode workers have already decoded it.
+         *
+         * @note must be called with mStreamMapLock held.
+         *
+         * @return pointer to the decoded samples in mStreamFrames, or nullptr if the stream
+         *      produced no audio.
+         */
+        const audio::SampleType *fetch_stream_frame(RenderStream &meta);
+
+        /** admit_stream decides whether a stream that's not been heard before gets a decoder,
+         * evicting the lowest ranked stream if the decoder budget calls for it.  Refused
+         * streams are tracked in mRejectedStreams.
+         *
+         * @note must be called with mStreamMapLock held.
+         */
+        bool admit_stream(const afv::dto::AudioRxOnTransceivers &pkt);
+
+        /** decoder_budget returns the number of streams that may be decoded at once - the
+         * lower of mMaxDecoders and mGovernorDecoderCap, or 0 if neither applies.
+         *
+         * @note must be called with mStreamMapLock held.
+         */
+        size_t decoder_budget() const;
+
+        /** enforce_decoder_budget evicts the lowest ranked streams until they're within
+         * decoder_budget().
+         *
+         * @note must be called with mStreamMapLock held.
+         */
+        void enforce_decoder_budget();
+
+        /** lowest_ranked_stream returns the stream that would be evicted first, or the end of
+         * mIncomingStreams if there are none.
+         *
+         * @note must be called with mStreamMapLock held.
+         */
+        StreamIterator lowest_ranked_stream(const RenderConfigSnapshot &config, StreamRank &rankOut);
+
+        /** remove_stream drops a stream and everything it holds, returning its source to
+         * mSourcePool.
+         *
+         * @note must be called with mStreamMapLock held.
+         */
+        void remove_stream(StreamIterator stream);
+
+        /** index_stream updates mFrequencyStreams with the transceivers a stream was last
+         * received on.
+         *
+         * @note must be called with mStreamMapLock held.
+         */
+        void index_stream(RenderStream &stream, const std::vector<dto::RxTransceiver> &transceivers);
+
+        /** unindex_stream removes a stream from mFrequencyStreams entirely.
+         *
+         * @note must be called with mStreamMapLock held.
+         */
+        void unindex_stream(RenderStream &stream);
+
+        void remove_contribution(unsigned int freq, const RenderStream *stream);
+    };
+
+    extern template class RadioRenderCore<AtcRenderPolicy>;
+    extern template class RadioRenderCore<PilotRenderPolicy>;
+}} // namespace afv_native::afv
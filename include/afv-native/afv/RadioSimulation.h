@@ -40,6 +40,7 @@
 #include "afv-native/utility.h"
 #include "afv-native/event.h"
 #include "afv-native/afv/EffectResources.h"
+#include "afv-native/afv/RadioRenderCore.h"
 #include "afv-native/afv/RemoteVoiceSource.h"
 #include "afv-native/afv/RollingAverage.h"
 #include "afv-native/afv/VoiceCompressionSink.h"
@@ -53,7 +54,6 @@
 #include "afv-native/cryptodto/UDPChannel.h"
 #include "afv-native/event/EventCallbackTimer.h"
 #include "afv-native/util/ChainedCallback.h"
-#include "afv-native/audio/OutputDeviceState.h"
 
 namespace afv_native {
     namespace afv {
@@ -64,6 +64,8 @@ namespace afv_native {
         public:
             OutputAudioDevice(std::weak_ptr<RadioSimulation> radio, bool onHeadset);
             audio::SourceStatus getAudioFrame(audio::SampleType *bufferOut) override;
+            audio::SourceStatus getAudioSamples(audio::SampleType *bufferOut, size_t numSamples) override;
+            bool partialFrames() const override;
         private:
             std::weak_ptr<RadioSimulation> mRadio;
             bool onHeadset = false;
@@ -71,38 +73,20 @@ namespace afv_native {
 
         /** RadioState is the internal state object for each radio within a RadioSimulation.
          *
-         * It tracks the current playback position of the mixing effects, the channel frequency and gain.
+         * It holds the channel frequency, gain and settings, guarded by the radio state lock.  The
+         * playback position of the mixing effects lives in the radio's RadioDsp, which belongs to
+         * the render.
          */
         class RadioState {
         public:
-            unsigned int Frequency;
+            unsigned int Frequency = 0;
             float Gain = 1.0;
-            std::shared_ptr<audio::RecordedSampleSource> Click;
-            std::shared_ptr<audio::RecordedSampleSource> Crackle;
-            std::shared_ptr<audio::RecordedSampleSource> AcBus;
-            std::shared_ptr<audio::RecordedSampleSource> VhfWhiteNoise;
-            std::shared_ptr<audio::RecordedSampleSource> HfWhiteNoise;
-            std::shared_ptr<audio::SineToneSource> BlockTone;
-            audio::SimpleCompressorEffect simpleCompressorEffect;
-            audio::VHFFilterSource vhfFilter;
-            int mLastRxCount;
-            bool mBypassEffects;
-            bool mHfSquelch;
-            bool mIsReceiving;
+            std::shared_ptr<RadioDsp> dsp;
+            bool mBypassEffects = false;
+            bool mHfSquelch = false;
             bool onHeadset = true;
         };
 
-        /** CallsignMeta is the per-packetstream metadata stored within the RadioSimulation object.
-         *
-         * It's used to hold the RemoteVoiceSource object for that callsign+channel combination,
-         * and the list of transceivers that this packet stream relates to.
-         */
-        struct CallsignMeta {
-            std::shared_ptr<RemoteVoiceSource> source;
-            std::vector<dto::RxTransceiver> transceivers;
-            CallsignMeta();
-        };
-
         enum class RadioSimulationState
         {
             RxStarted,
@@ -121,6 +105,7 @@ namespace afv_native {
          */
         class RadioSimulation:
                 public std::enable_shared_from_this<RadioSimulation>,
+                public RadioRenderCore<PilotRenderPolicy>,
                 public audio::ISampleSink,
                 public ICompressedFrameSink {
         public:
@@ -159,6 +144,21 @@ namespace afv_native {
             void setEnableOutputEffects(bool enableEffects);
             void setEnableHfSquelch(bool enableHfSquelch);
 
+            /** setReducedRateDsp runs the radios at reducedSampleRateHz, as
+             * ATCRadioSimulation::setReducedRateDsp() does. */
+            void setReducedRateDsp(bool reduced);
+
+            /** setRenderQuantum renders the receive mix in quanta of quantum samples, as
+             * ATCRadioSimulation::setRenderQuantum() does. */
+            bool setRenderQuantum(size_t quantum);
+
+            /** setFecPacketLoss turns on in-band FEC for the voice encoder, as
+             * ATCRadioSimulation::setFecPacketLoss() does. */
+            void setFecPacketLoss(int percent);
+
+            /** setEncoderProfile switches the voice encoder to profile, from the next frame. */
+            void setEncoderProfile(const EncoderProfile &profile);
+
             void setupDevices(util::ChainedCallback<void(ClientEventType, void*, void*)> *eventCallback);
 
             void setOnHeadset(unsigned int radio, bool onHeadset);
@@ -166,9 +166,7 @@ namespace afv_native {
 
             void putAudioFrame(const audio::SampleType *bufferIn) override;
             audio::SourceStatus getAudioFrame(audio::SampleType *bufferOut, bool onHeadset);
-
-            /** Contains the number of IncomingAudioStreams known to the simulation stack */
-            std::atomic<uint32_t> IncomingAudioStreams;
+            audio::SourceStatus getAudioSamples(audio::SampleType *bufferOut, size_t numSamples, bool onHeadset);
 
             int lastReceivedRadio() const;
             util::ChainedCallback<void(RadioSimulationState)>  RadioStateCallback;
@@ -177,17 +175,6 @@ namespace afv_native {
             std::shared_ptr<audio::ISampleSource> headsetDevice() { return mHeadsetDevice; }
 
         protected:
-            /** maintenanceTimerIntervalMs is the internal in milliseconds between periodic cleanups
-             * of the inbound audio frame objects.
-             *
-             * This maintenance occurs in the main execution thread as not to hold the audio playback thread
-             * unnecessarily, particularly as it may involve alloc/free operations.
-             *
-             * The current constant of 30s should be frequent enough to prevent massive memory issues, without
-             * causing performance issues.
-             */
-            static const int maintenanceTimerIntervalMs = 30 * 1000; /* every 30s */
-
             util::ChainedCallback<void(ClientEventType, void*, void*)>  *ClientEventCallback;
 
             struct event_base *mEvBase;
@@ -195,42 +182,41 @@ namespace afv_native {
             cryptodto::UDPChannel *mChannel;
             std::string mCallsign;
 
-            std::mutex mStreamMapLock;
-            std::unordered_map<std::string, struct CallsignMeta> mHeadsetIncomingStreams;
-            std::unordered_map<std::string, struct CallsignMeta> mSpeakerIncomingStreams;
-
             std::mutex mRadioStateLock;
-            std::atomic<bool> mPtt;
             bool mLastFramePtt;
             unsigned int mTxRadio;
             std::atomic<uint32_t> mTxSequence;
             std::vector<RadioState> mRadioState;
 
-            bool mSplitChannels = false;
+            /** read by the output devices without the radio state lock */
+            std::atomic<bool> mSplitChannels;
 
             std::shared_ptr<OutputAudioDevice> mHeadsetDevice;
             std::shared_ptr<OutputAudioDevice> mSpeakerDevice;
 
-            std::shared_ptr<OutputDeviceState> mHeadsetState;
-            std::shared_ptr<OutputDeviceState> mSpeakerState;
-
             float mMicVolume = 1.0f;
 
             unsigned int mLastReceivedRadio;
 
             std::shared_ptr<VoiceCompressionSink> mVoiceSink;
             std::shared_ptr<audio::SpeexPreprocessor> mVoiceFilter;
+            std::atomic<int> mFecPacketLoss {0};
 
             event::EventCallbackTimer mMaintenanceTimer;
             RollingAverage<double> mVuMeter;
 
-            void resetRadioFx(unsigned int radio, bool except_click = false);
-
-            void set_radio_effects(size_t rxIter);
-
-            bool mix_effect(std::shared_ptr<audio::ISampleSource> effect, float gain, std::shared_ptr<OutputDeviceState> state);
+            /** publish_radio_config rebuilds the render snapshot from mRadioState.
+             *
+             * The first two radios go left and right when the channels are split, and any
+             * others aren't heard.  Otherwise everything is mixed on the left, which
+             * getAudioFrame() hands out as mono.
+             *
+             * @note must be called with mRadioStateLock held.
+             */
+            void publish_radio_config();
 
-            void processCompressedFrame(std::vector<unsigned char> compressedData) override;
+            void processCompressedFrame(const std::vector<unsigned char> &compressedData) override;
+            bool skipCompressedFrame() override;
 
             static void dtoHandler(
                     const std::string &dtoName, const unsigned char *bufIn, size_t bufLen, void *user_data);
@@ -238,32 +224,6 @@ namespace afv_native {
                     const std::string &dtoName, const unsigned char *bufIn, size_t bufLen);
 
             void maintainIncomingStreams();
-        private:
-            bool _process_radio(
-                    const std::map<void *, audio::SampleType[audio::frameSizeSamples]> &sampleCache,
-                    size_t rxIter,
-                    bool onHeadset);
-
-            inline void interleave(audio::SampleType* leftChannel, audio::SampleType* rightChannel, audio::SampleType* outputBuffer, size_t numSamples) {
-                for (size_t i = 0; i < numSamples; i++) {
-                    outputBuffer[2 * i] = leftChannel[i]; // Interleave left channel data
-                    outputBuffer[2 * i + 1] = rightChannel[i]; // Interleave right channel data
-                }
-            }
-
-            /** mix_buffers is a utility function that mixes two buffers of audio together.  The src_dst
-             * buffer is assumed to be the final output buffer and is modified by the mixing in place.
-             * src2 is read-only and will be scaled by the provided linear gain.
-             *
-             * @note as this mixer has some really fundamental assumptions about buffer alignment which
-             * are required as it uses SSE2 intrinsics to perform the mixing.  These requirements are
-             * met inside elsewhere inside this class.
-             *
-             * @param src_dst pointer to the source and destination buffer.
-             * @param src2 pointer to the origin of the samples to mix in.
-             * @param src2_gain linear gain to apply to src2.
-             */
-            static void mix_buffers(audio::SampleType* RESTRICT src_dst, const audio::SampleType* RESTRICT src2, float src2_gain = 1.0);
         };
     }
 }
@@ -34,58 +34,111 @@
 #ifndef AFV_NATIVE_REMOTEVOICESOURCE_H
 #define AFV_NATIVE_REMOTEVOICESOURCE_H
 
+#include "afv-native/afv/JitterBuffer.h"
 #include "afv-native/afv/dto/interfaces/IAudio.h"
+#include "afv-native/audio/FrameRing.h"
 #include "afv-native/audio/ISampleSource.h"
 #include "afv-native/audio/SourceStatus.h"
 #include "afv-native/audio/audio_params.h"
 #include "afv-native/util/monotime.h"
-#include <mutex>
+#include <atomic>
 #include <opus/opus.h>
-#include <speex/speex_jitter.h>
 
 namespace afv_native { namespace afv {
 
-    /** frameTimeOut is the maximum number of frames we will receive without audio data before we
-     * declare the stream dead.
+    /** frameTimeOut is the maximum number of frames we will conceal, without any audio data
+     * arriving, before we declare the stream dead.
      */
     const int frameTimeOut = 10;
 
-    /** RemoveVoiceSource takes a stream of IAudio DTOs and stores them in an appropriately tuned jitterbuffer.
+    /** RemoveVoiceSource takes a stream of IAudio DTOs and stores them in an adaptive JitterBuffer.
      *
      * These can then be demand polled by a consumer which will pull the packets from the jitterBuffer and run them
-     * through the decoder.
+     * through the decoder.  One thread may append packets while another polls without either
+     * of them blocking.
+     *
+     * A lost frame is decoded from the in-band FEC of the packet after it if that's arrived, and
+     * concealed by the decoder's PLC if it hasn't.
      *
      * @note this is analogous to the GeoVR CallsignSampleProvider, but without the effects pass which is handled
      * elsewhere.
      */
     class RemoteVoiceSource: public audio::ISampleSource {
       protected:
-        JitterBuffer *mJitterBuffer;
-        OpusDecoder  *mDecoder;
+        JitterBuffer mJitterBuffer;
+        OpusDecoder *mDecoder;
 
-        std::mutex       mJitterBufferMutex;
-        bool             mIsActive;
-        util::monotime_t mLastActive;
+        /** mActivity is bumped by the producer for every packet appended.  The consumer records
+         * in mIdleActivity the count it had seen when it last found the jitter buffer idle, so
+         * the stream is active while they differ - and a packet appended while the consumer
+         * was finding it idle keeps it active, rather than being overwritten. */
+        std::atomic<uint64_t>         mActivity;
+        std::atomic<uint64_t>         mIdleActivity;
+        std::atomic<util::monotime_t> mLastActive;
+        /** set by flush(), and acted on by the next getAudioFrame() */
+        std::atomic<bool> mFlushPending;
+        /** mDecoded holds the frames decodeAhead() has decoded for readDecodedFrame(). */
+        audio::FrameRing mDecoded;
 
       protected:
-        int mSilentFrames;
+        /** mIdle is set while the jitter buffer has no transmission playing, so the decoder
+         * can be reset before the next one.  Consumer side only. */
+        bool          mIdle;
+        unsigned char mPacket[JitterBuffer::maxPacketBytes];
 
-        int  mCurrentFrame;
-        bool mEnding;
-        int  mEndingSequence;
+        int mSampleRate;
+        int mFrameSamples;
 
       public:
-        RemoteVoiceSource();
+        /** @param sampleRate the rate to decode at.  Opus decodes natively at any of its
+         *      rates, so this is cheaper than decoding at the full rate and resampling. */
+        explicit RemoteVoiceSource(int sampleRate = audio::sampleRateHz);
         virtual ~RemoteVoiceSource();
         RemoteVoiceSource(const RemoteVoiceSource &copySrc) = delete;
 
-        void                appendAudioDTO(const dto::IAudio &audio);
+        void appendAudioDTO(const dto::IAudio &audio);
+        /** appendAudioDTO appends a packet that arrived at arrivalMs (on the monotime clock),
+         * rather than now. */
+        void                appendAudioDTO(const dto::IAudio &audio, util::monotime_t arrivalMs);
         audio::SourceStatus getAudioFrame(audio::SampleType *bufferOut) override;
 
+        /** decodeAhead decodes the next frame into the source's PCM ring, if the stream's
+         * active and the last one has been read.  The caller takes the place of
+         * getAudioFrame()'s as the jitter buffer's consumer, so the two mustn't be mixed.
+         *
+         * @return true if a frame was decoded.
+         */
+        bool decodeAhead();
+
+        /** readDecodedFrame copies the frame decodeAhead() decoded into bufferOut.
+         *
+         * @return false if there wasn't one, and the stream should be treated as silent.
+         */
+        bool readDecodedFrame(audio::SampleType *bufferOut);
+
+        /** dropDecodedFrames throws away anything decodeAhead() decoded that hasn't been read,
+         * for when the stream goes back to being decoded by getAudioFrame().  Nothing may be
+         * decoding ahead at the time. */
+        void dropDecodedFrames();
+
         util::monotime_t getLastActivityTime() const;
 
+        int getSampleRate() const;
+
+        /** getJitterBuffer returns the stream's jitter buffer, for its counters and target
+         * delay. */
+        const JitterBuffer &getJitterBuffer() const;
+
+        /** reset returns the source to as good as new, decoding at sampleRate, so that it can be
+         * reused for another stream.  The decoder keeps its memory and is only reset (or
+         * reinitialised, if the rate changes).  Nothing else may be using the source.
+         */
+        void reset(int sampleRate);
+
         /** flush resets the stream, preserving any jitter adjustments, but otherwise clearing the
          * codec state and jitter buffered packets.
+         *
+         * It may be called from any thread, and takes effect on the next getAudioFrame().
          */
         void flush();
         bool isActive() const;
@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace afv_native { namespace afv {
+    /** RenderTier is how much of the receive effects chain the render is running.
+     *
+     * The tiers are cumulative - each one gives up everything the tiers above it did, and then
+     * some more.
+     */
+    enum RenderTier : uint8_t {
+        /** everything */
+        TierFull = 0,
+        /** no crackle, white noise or AC bus beds */
+        TierNoNoiseBeds,
+        /** the radio filter's band edges only, see VHFFilterSource::transformFrameEconomy */
+        TierEconomyFilter,
+        /** no compressor after the radio filter */
+        TierNoCompressor,
+        /** fewer streams decoded at once - the lowest ranked are evicted.  Only reached if
+         * RenderGovernor::setDecoderCapping() allows it. */
+        TierCappedDecoders,
+        TierCount,
+    };
+
+    /** RenderGovernor keeps the render within its CPU budget by trading away effects.
+     *
+     * Every render tick reports how long it took.  The governor keeps a moving average of
+     * that, and steps down a tier when the pressure is sustained: the average gets close to
+     * the budget, or overrunLimit ticks overrun it within overrunWindowTicks.  The times are
+     * wall clock, so a single overrun is as likely to be the thread being preempted as the
+     * render being too slow, and isn't enough on its own.  Once the average has stayed well
+     * under budget for long enough, it steps back up again, one tier at a time.  After each
+     * change it waits for the average to catch up before changing again, so it doesn't hunt
+     * between tiers.
+     *
+     * It starts out disabled, and never goes as far as TierCappedDecoders - which stops
+     * streams being heard - unless that's asked for too.
+     *
+     * update() is only called from the render, under its stream lock; everything else may be
+     * called from any thread.
+     */
+    class RenderGovernor {
+      public:
+        /** the default budget is half a frame, leaving the rest of the device callback for
+         * everything else on the audio thread */
+        static const uint64_t defaultBudgetNs = 10000000;
+
+        RenderGovernor();
+
+        RenderGovernor(const RenderGovernor &)            = delete;
+        RenderGovernor &operator=(const RenderGovernor &) = delete;
+
+        /** update accounts for a render tick that took renderNs, and returns the tier the next
+         * tick should render at. */
+        RenderTier update(uint64_t renderNs);
+
+        RenderTier getTier() const;
+
+        /** setEnabled turns the governor on or off (the default).  Turning it off returns to
+         * TierFull straight away, though overruns are still counted. */
+        void setEnabled(bool enabled);
+        bool getEnabled() const;
+
+        /** setDecoderCapping lets the governor step down as far as TierCappedDecoders.  It's
+         * off by default, so the governor stops at TierNoCompressor; turning it off while
+         * there steps straight back up to that. */
+        void setDecoderCapping(bool capping);
+        bool getDecoderCapping() const;
+
+        void     setBudgetNs(uint64_t budgetNs);
+        uint64_t getBudgetNs() const;
+
+        /** Contains the number of render ticks that took longer than the budget */
+        std::atomic<uint64_t> Overruns;
+
+        /** Contains the number of times the tier has changed, either way */
+        std::atomic<uint64_t> TierChanges;
+
+      private:
+        /** ticks to wait after a change before stepping down again, and how long the average
+         * has to stay under recoverFraction of the budget before stepping back up */
+        static const unsigned int holdTicks    = 25;
+        static const unsigned int recoverTicks = 250;
+        /** how many overruns within overrunWindowTicks count as sustained pressure */
+        static const unsigned int overrunLimit       = 5;
+        static const unsigned int overrunWindowTicks = 50;
+
+        void set_tier(RenderTier tier);
+
+        /** lowest_tier returns the furthest the governor may step down to. */
+        RenderTier lowest_tier() const;
+
+        std::atomic<bool>     mEnabled;
+        std::atomic<bool>     mDecoderCapping;
+        std::atomic<uint64_t> mBudgetNs;
+        std::atomic<uint8_t>  mTier;
+
+        // render side only
+        double       mAverageNs;
+        unsigned int mHoldTicks;
+        unsigned int mHeadroomTicks;
+        unsigned int mWindowTicks;
+        unsigned int mWindowOverruns;
+    };
+}} // namespace afv_native::afv
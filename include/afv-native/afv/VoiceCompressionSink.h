@@ -34,14 +34,67 @@
 #ifndef AFV_NATIVE_VOICECOMPRESSIONSINK_H
 #define AFV_NATIVE_VOICECOMPRESSIONSINK_H
 
+#include "afv-native/afv/JitterBuffer.h"
 #include "afv-native/audio/ISampleSink.h"
+#include "afv-native/audio/audio_params.h"
+#include <atomic>
+#include <mutex>
 #include <opus/opus.h>
 #include <vector>
 
 namespace afv_native { namespace afv {
     class ICompressedFrameSink {
       public:
-        virtual void processCompressedFrame(std::vector<unsigned char> compressedData) = 0;
+        virtual void processCompressedFrame(const std::vector<unsigned char> &compressedData) = 0;
+
+        /** skipCompressedFrame is called instead of processCompressedFrame() for a frame that
+         * DTX found to be silence, and so needn't be sent.  Return false to have it processed
+         * after all - eg, because it's the last frame of a transmission.
+         *
+         * The first frame of silence is always processed, so receivers know the gap after it
+         * is DTX, and so is a keep-alive before the gap gets long enough for them to give up on
+         * the transmission.
+         */
+        virtual bool skipCompressedFrame() {
+            return false;
+        }
+    };
+
+    /** EncoderProfile is how VoiceCompressionSink encodes the voice.  The defaults are what
+     * has always been sent. */
+    struct EncoderProfile {
+        /** an OPUS_APPLICATION_*.  Changing it means a new encoder. */
+        int application = OPUS_APPLICATION_VOIP;
+        /** in bits per second, from minBitrate to maxBitrate */
+        int32_t bitrate = audio::encoderBitrate;
+        /** 0 (cheapest) to 10, or -1 for Opus' own default */
+        int  complexity = -1;
+        bool vbr        = true;
+        /** dtx stops sending most frames of silence while the PTT is held.  Receivers see a
+         * gap after a DTX frame, which they conceal without counting it as loss. */
+        bool dtx = false;
+        /** OPUS_SIGNAL_VOICE, OPUS_SIGNAL_MUSIC or OPUS_AUTO */
+        int signal = OPUS_AUTO;
+        /** the widest audio bandwidth to code, an OPUS_BANDWIDTH_* */
+        int maxBandwidth = OPUS_BANDWIDTH_FULLBAND;
+
+        /** the range of bitrates Opus accepts */
+        static const int32_t minBitrate = 500;
+        static const int32_t maxBitrate = 512000;
+
+        /** standard returns the default profile. */
+        static EncoderProfile standard();
+
+        /** lowCpu returns the default profile at a low complexity, for slow machines. */
+        static EncoderProfile lowCpu();
+
+        /** radio returns a profile that only codes narrowband voice - all a radio carries - at
+         * a lower bitrate. */
+        static EncoderProfile radio();
+
+        /** bandwidthForCutoff returns the narrowest OPUS_BANDWIDTH_* that passes everything up
+         * to cutoffHz. */
+        static int bandwidthForCutoff(unsigned int cutoffHz);
     };
 
     /** VoiceCompressionSink is an SampleSink that accepts samples from an origin and
@@ -51,6 +104,28 @@ namespace afv_native { namespace afv {
       protected:
         OpusEncoder          *mEncoder;
         ICompressedFrameSink &mCompressedFrameSink;
+        /** mPacketLoss is what setPacketLoss() asked for, and mEncoderPacketLoss what the
+         * encoder was last set to.  The encoder's only touched from putAudioFrame(), so it's
+         * caught up there. */
+        std::atomic<int> mPacketLoss;
+        int              mEncoderPacketLoss;
+        /** mProfile is what the encoder's set up for.  setProfile() leaves the new one in
+         * mPendingProfile, for putAudioFrame() to pick up. */
+        EncoderProfile    mProfile;
+        std::mutex        mProfileLock;
+        EncoderProfile    mPendingProfile;
+        std::atomic<bool> mProfileChanged;
+        /** mDtxSent is set once a DTX frame has been sent, and mDtxSkipped counts those
+         * skipped since */
+        bool         mDtxSent;
+        unsigned int mDtxSkipped;
+        int          mDefaultComplexity;
+        /** mEncoded is where each frame is encoded to, allocated once at the largest a frame
+         * can be. */
+        std::vector<unsigned char> mEncoded;
+
+        void apply_packet_loss(int percent);
+        void apply_profile();
 
       public:
         VoiceCompressionSink(ICompressedFrameSink &sink);
@@ -58,6 +133,25 @@ namespace afv_native { namespace afv {
         int  open();
         void close();
         void reset();
+
+        /** setPacketLoss tunes the encoder for a network losing percent of its packets.  0 (the
+         * default) turns Opus' in-band FEC off; anything above turns it on, with more of the
+         * bitrate spent on it the higher it is.  It may be called from any thread, takes effect
+         * from the next frame, and is kept over reset().
+         */
+        void setPacketLoss(int percent);
+        int  getPacketLoss() const;
+
+        /** setProfile switches the encoder to profile.  Like setPacketLoss(), it may be called
+         * from any thread, takes effect from the next frame, and is kept over reset(). */
+        void           setProfile(const EncoderProfile &profile);
+        EncoderProfile getProfile();
+
+        /** the largest packet Opus makes of a single frame */
+        static const size_t maxFrameBytes = 1275;
+        /** an encoded frame this size or smaller is one DTX says needn't be sent */
+        static const size_t dtxFrameBytes = JitterBuffer::dtxPacketBytes;
+
         void putAudioFrame(const audio::SampleType *bufferIn) override;
     };
 }} // namespace afv_native::afv
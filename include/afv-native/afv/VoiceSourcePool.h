@@ -0,0 +1,62 @@
+#pragma once
+#include "afv-native/afv/RemoteVoiceSource.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace afv_native { namespace afv {
+    /** VoiceSourcePool keeps RemoteVoiceSources for reuse, so that streams coming and going
+     * don't create and destroy an Opus decoder and a jitter buffer (with all of its packet
+     * slots) every time.
+     *
+     * A released source is reset - OPUS_RESET_STATE and an emptied jitter buffer - and handed
+     * out again by the next acquire().  New sources are only created when the pool has run
+     * dry, and only maxIdle are kept once they're released.
+     */
+    class VoiceSourcePool {
+      public:
+        static const size_t defaultMaxIdle = 64;
+
+        explicit VoiceSourcePool(size_t maxIdle = defaultMaxIdle);
+
+        VoiceSourcePool(const VoiceSourcePool &)            = delete;
+        VoiceSourcePool &operator=(const VoiceSourcePool &) = delete;
+
+        /** acquire returns a source decoding at sampleRate, from the pool if it can. */
+        std::shared_ptr<RemoteVoiceSource> acquire(int sampleRate);
+
+        /** release hands source back to the pool.  A source still referenced elsewhere is
+         * left to its other owners instead. */
+        void release(std::shared_ptr<RemoteVoiceSource> source);
+
+        /** reserve creates sources at the full rate until at least count (up to maxIdle) are
+         * idle.  They're created outside the pool's lock, so acquire() isn't held up. */
+        void reserve(size_t count);
+
+        /** getInUse returns the number of sources acquired and not yet released */
+        size_t getInUse() const;
+
+        /** getPeakInUse returns the most sources that have been in use at once */
+        size_t getPeakInUse() const;
+
+        /** getIdle returns the number of sources waiting in the pool */
+        size_t getIdle() const;
+
+        /** Contains the number of sources acquired */
+        std::atomic<uint64_t> Acquires;
+
+        /** Contains the number of acquires that were served from the pool, rather than by
+         * creating a new source */
+        std::atomic<uint64_t> Hits;
+
+      private:
+        mutable std::mutex                              mLock;
+        std::vector<std::shared_ptr<RemoteVoiceSource>> mIdle;
+        const size_t                                    mMaxIdle;
+        size_t                                          mInUse;
+        size_t                                          mPeakInUse;
+    };
+}} // namespace afv_native::afv
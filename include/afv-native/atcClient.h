@@ -177,6 +177,78 @@ namespace afv_native {
         void setEnableInputFilters(bool enableInputFilters);
         void setEnableOutputEffects(bool enableEffects);
 
+        /** setDspThreads spreads the per-radio DSP over this many worker threads (0 to keep it
+         * on the audio thread).  Useful for positions with many frequencies on slow machines.
+         *
+         * @param deterministic always render each radio on the same thread.
+         */
+        void setDspThreads(unsigned int threads, bool deterministic);
+
+        /** setDecodeThreads decodes the incoming voice streams on this many worker threads
+         * instead of the audio thread (0, the default).  It keeps the audio callback short with
+         * many stations talking, but received audio plays a frame (20ms) later.
+         */
+        void setDecodeThreads(unsigned int threads);
+
+        /** setSharedNoiseBed mixes the background noise once per output instead of once per
+         * radio.  Cheaper with many frequencies receiving, but they all share the same noise.
+         */
+        void setSharedNoiseBed(bool shared);
+
+        /** setMaxDecoders caps how many incoming voice streams are decoded at once (0 for no
+         * cap).  When it's reached, the streams on receiving frequencies and closest to us win.
+         */
+        void setMaxDecoders(unsigned int maxDecoders);
+
+        /** setReducedRateDsp decodes and processes the received audio at 16kHz instead of
+         * 48kHz, which is plenty for the radio's voice band and much cheaper per frequency.
+         * Streams being received when it's switched drop out for a moment.
+         */
+        void setReducedRateDsp(bool reduced);
+
+        /** setFecPacketLoss adds Opus in-band FEC to our transmissions for a network losing
+         * percent of its packets, so a lost packet can be rebuilt from the next one at the
+         * cost of some voice bitrate.  0 turns it off (the default), and -1 follows the loss
+         * measured on the incoming streams.
+         */
+        void setFecPacketLoss(int percent);
+
+        /** setEncoderProfile changes how our voice is encoded - see afv::EncoderProfile.  A
+         * lower complexity suits a slow machine, and narrowband is all a radio needs.  DTX
+         * stops sending silence while the PTT is held, but receivers have to conceal the
+         * gaps.
+         */
+        void setEncoderProfile(const afv::EncoderProfile &profile);
+
+        /** setRenderQuantum mixes the received audio in blocks of samples samples (at 48kHz)
+         * rather than a whole 20ms frame at a time, and opens the audio outputs with that
+         * period, cutting the output latency to match.  240 (5ms) and 480 (10ms) are the useful
+         * values; 960 goes back to whole frames.  The output period only changes the next time
+         * the audio is started.
+         *
+         * @return false if samples isn't a quantum the mix can run at.
+         */
+        bool setRenderQuantum(unsigned int samples);
+
+        /** setRenderGovernor turns the render's CPU governor on or off (the default).  When
+         * the receive mix runs short of time it drops the noise beds, then uses a cheaper
+         * radio filter, then drops the compressor, and - only with capDecoders - finally
+         * decodes fewer streams, restoring them again once there's headroom.
+         *
+         * @param budgetUs how long a render may take before it counts as an overrun, 0 to
+         *      leave it as it is.
+         * @param capDecoders lets the governor stop decoding the lowest ranked streams, which
+         *      then aren't heard.
+         */
+        void setRenderGovernor(bool enabled, unsigned int budgetUs, bool capDecoders = false);
+
+        /** getRenderTier returns how far the governor has stepped down, from 0 (everything)
+         * to 4 (decoders capped). */
+        unsigned int getRenderTier() const;
+
+        /** getRenderOverruns returns the number of renders that overran their budget. */
+        unsigned long long getRenderOverruns() const;
+
         /** ClientEventCallback provides notifications when certain client events occur.  These can be used to
          * provide feedback within the client itself without needing to poll Client's methods.
          *
@@ -69,6 +69,17 @@ extern "C" {
     AFV_NATIVE_API const double ATCClient_GetInputVu(ATCClientHandle handle);
     AFV_NATIVE_API void ATCClient_SetEnableInputFilters(ATCClientHandle handle, bool enableInputFilters);
     AFV_NATIVE_API void ATCClient_SetEnableOutputEffects(ATCClientHandle handle, bool enableEffects);
+    AFV_NATIVE_API void ATCClient_SetDspThreads(ATCClientHandle handle, unsigned int threads, bool deterministic);
+    AFV_NATIVE_API void ATCClient_SetDecodeThreads(ATCClientHandle handle, unsigned int threads);
+    AFV_NATIVE_API void ATCClient_SetSharedNoiseBed(ATCClientHandle handle, bool shared);
+    AFV_NATIVE_API void ATCClient_SetMaxDecoders(ATCClientHandle handle, unsigned int maxDecoders);
+    AFV_NATIVE_API void ATCClient_SetReducedRateDsp(ATCClientHandle handle, bool reduced);
+    AFV_NATIVE_API void ATCClient_SetFecPacketLoss(ATCClientHandle handle, int percent);
+    AFV_NATIVE_API void ATCClient_SetEncoderProfile(ATCClientHandle handle, unsigned int bitrate, int complexity, bool vbr, bool dtx, bool voiceSignal, unsigned int maxBandwidthHz);
+    AFV_NATIVE_API bool ATCClient_SetRenderQuantum(ATCClientHandle handle, unsigned int samples);
+    AFV_NATIVE_API void ATCClient_SetRenderGovernor(ATCClientHandle handle, bool enabled, unsigned int budgetUs, bool capDecoders);
+    AFV_NATIVE_API unsigned int ATCClient_GetRenderTier(ATCClientHandle handle);
+    AFV_NATIVE_API unsigned long long ATCClient_GetRenderOverruns(ATCClientHandle handle);
     AFV_NATIVE_API bool ATCClient_GetEnableInputFilters(ATCClientHandle handle);
     AFV_NATIVE_API void ATCClient_StartAudio(ATCClientHandle handle);
     AFV_NATIVE_API void ATCClient_StopAudio(ATCClientHandle handle);
@@ -94,6 +94,22 @@ namespace afv_native::api {
 
         AFV_NATIVE_API void SetEnableInputFilters(bool enableInputFilters);
         AFV_NATIVE_API void SetEnableOutputEffects(bool enableEffects);
+        AFV_NATIVE_API void SetDspThreads(unsigned int threads, bool deterministic = false);
+        AFV_NATIVE_API void SetDecodeThreads(unsigned int threads);
+        AFV_NATIVE_API void SetSharedNoiseBed(bool shared);
+        AFV_NATIVE_API void SetMaxDecoders(unsigned int maxDecoders);
+        AFV_NATIVE_API void SetReducedRateDsp(bool reduced);
+        AFV_NATIVE_API void SetFecPacketLoss(int percent);
+        /** SetEncoderProfile sets how our voice is encoded.  bitrate is in bits per second, 0
+         * for the default, and is kept within what Opus accepts.  complexity runs from 0 to 10,
+         * or -1 for the default, and maxBandwidthHz is the highest frequency to code (4000 for
+         * narrowband), 0 for the default (fullband).  voiceSignal tells the encoder it's only
+         * ever speech. */
+        AFV_NATIVE_API void SetEncoderProfile(unsigned int bitrate, int complexity, bool vbr, bool dtx, bool voiceSignal, unsigned int maxBandwidthHz);
+        AFV_NATIVE_API bool SetRenderQuantum(unsigned int samples);
+        AFV_NATIVE_API void SetRenderGovernor(bool enabled, unsigned int budgetUs = 0, bool capDecoders = false);
+        AFV_NATIVE_API unsigned int GetRenderTier() const;
+        AFV_NATIVE_API unsigned long long GetRenderOverruns() const;
         AFV_NATIVE_API bool GetEnableInputFilters() const;
 
         AFV_NATIVE_API void StartAudio();
@@ -159,7 +159,7 @@ namespace afv_native {
         afv::APISession            mAPISession;
         afv::VoiceSession          mVoiceSession;
 
-        void processCompressedFrame(std::vector<unsigned char> compressedData);
+        void processCompressedFrame(const std::vector<unsigned char> &compressedData);
 
         double       mClientLatitude;
         double       mClientLongitude;
@@ -59,6 +59,8 @@ namespace afv_native { namespace audio {
         std::mutex mSourcePtrLock;
         std::function<void(std::string, int)> mNotificationFunc = std::function<void(std::string, int)>();
         std::mutex mNotificationFuncLock;
+        /** the period the output is opened with, in samples per channel */
+        unsigned int mOutputPeriod;
 
         /** Ensures data within the abstract is zeroed. Should always be called via
          * the initialiser chain of any subclasses.
@@ -112,6 +114,16 @@ namespace afv_native { namespace audio {
          */
         virtual void setSource(std::shared_ptr<ISampleSource> newSrc);
 
+        /** setOutputPeriod sets how many samples (per channel) the output asks its source for
+         * at a time, from the next openOutput() on.  The default is frameSizeSamples.
+         *
+         * A period that isn't a whole number of frames only adds latency for a source that
+         * can't supply partial frames, as the rest of each frame has to be held back for the
+         * next period.
+         */
+        void         setOutputPeriod(unsigned int samples);
+        unsigned int getOutputPeriod() const;
+
         /** setSink sets the ISampleSink for this AudioDevice.
          *
          * Any existing sink will have its pointer released.
@@ -45,6 +45,9 @@ namespace afv_native { namespace audio {
 
         SampleType TransformOne(SampleType sampleIn);
 
+        /** reset clears the filter history, keeping the coefficients. */
+        void reset();
+
         void setCoefficients(double aa0, double aa1, double aa2, double b0, double b1, double b2);
         void setLowPassFilter(float sampleRate, float cutoffFrequency, float q);
         void setPeakingEq(float sampleRate, float centreFrequency, float q, float dbGain);
@@ -53,6 +56,11 @@ namespace afv_native { namespace audio {
         void setHighShelfFilter(float sampleRate, float cutoffFrequency, float q, float dbGain);
 
         static BiQuadFilter customBuild(double aa0, double aa1, double aa2, double b0, double b1, double b2);
+        /** customBuildAtRate takes coefficients designed for designRate and maps them to
+         * sampleRate through the bilinear transform.  The response keeps its shape, but is
+         * warped towards the new Nyquist frequency - it's exact at matchFrequency, and the
+         * further from it the more it drifts. */
+        static BiQuadFilter customBuildAtRate(float designRate, float sampleRate, float matchFrequency, double aa0, double aa1, double aa2, double b0, double b1, double b2);
         static BiQuadFilter lowPassFilter(float sampleRate, float cutoffFrequency, float q);
         static BiQuadFilter highPassFilter(float sampleRate, float cutoffFrequency, float q);
         static BiQuadFilter lowShelfFilter(float sampleRate, float cutoffFrequency, float q, float dbGain);
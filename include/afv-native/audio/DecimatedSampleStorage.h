@@ -0,0 +1,23 @@
+#pragma once
+#include "afv-native/audio/ISampleStorage.h"
+#include <memory>
+
+namespace afv_native { namespace audio {
+    /** DecimatedSampleStorage is a copy of another recording at a whole fraction of its sample
+     * rate, low pass filtered first so nothing above the new Nyquist frequency folds back.
+     *
+     * All of the work happens in the constructor.  A looped recording should be decimated with
+     * loop set, so that the filter wraps around its ends instead of fading them out.
+     */
+    class DecimatedSampleStorage: public ISampleStorage {
+      public:
+        DecimatedSampleStorage(const ISampleStorage &source, unsigned int factor, bool loop);
+
+        SampleType *data() const override;
+        size_t      lengthInSamples() const override;
+
+      private:
+        std::unique_ptr<SampleType[]> mSamples;
+        size_t                        mLength;
+    };
+}} // namespace afv_native::audio
@@ -0,0 +1,72 @@
+#pragma once
+#include "afv-native/audio/audio_params.h"
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace afv_native { namespace audio {
+    /** FrameRing is a fixed-capacity single-producer/single-consumer queue of audio frames.
+     *
+     * The producer renders straight into the ring: writeFrame() hands out the next free frame
+     * and commitFrame() publishes it.  The consumer copies frames out with readFrame().
+     * Neither side blocks or allocates.
+     *
+     * Frames may be committed short, so a ring sized for the longest frame can carry shorter
+     * ones too.  Each frame is read back at the length it was committed with.
+     *
+     * @note there may only be one producer and one consumer at a time.  The producer doesn't
+     * have to be the same thread every time, as long as producers are serialised (eg, by a
+     * lock).
+     */
+    class FrameRing {
+      public:
+        /** @param frameSamples the most samples a frame can hold (all channels).
+         * @param capacity the number of frames the ring holds. */
+        FrameRing(size_t frameSamples, size_t capacity);
+
+        FrameRing(const FrameRing &)            = delete;
+        FrameRing &operator=(const FrameRing &) = delete;
+
+        /** writeFrame returns the frame the producer should fill next, or nullptr if the ring
+         * is full.  The frame's contents are undefined. */
+        SampleType *writeFrame();
+
+        /** commitFrame publishes the first samples samples of the frame returned by the last
+         * writeFrame(). */
+        void commitFrame(size_t samples);
+
+        /** readFrame copies the oldest frame into bufferOut and removes it.
+         *
+         * @return the number of samples copied, 0 if the ring was empty.
+         */
+        size_t readFrame(SampleType *bufferOut);
+
+        /** clear empties the ring.  Neither side may be using it. */
+        void clear();
+
+        size_t size() const {
+            return mWritePos.load(std::memory_order_acquire) - mReadPos.load(std::memory_order_acquire);
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+        size_t frameSamples() const {
+            return mFrameSamples;
+        }
+
+        size_t capacity() const {
+            return mCapacity;
+        }
+
+      protected:
+        const size_t            mFrameSamples;
+        const size_t            mCapacity;
+        std::vector<SampleType> mFrames;
+        std::vector<size_t>     mLengths;
+
+        alignas(64) std::atomic<size_t> mWritePos;
+        alignas(64) std::atomic<size_t> mReadPos;
+    };
+}} // namespace afv_native::audio
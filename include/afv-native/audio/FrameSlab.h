@@ -0,0 +1,60 @@
+#pragma once
+#include "afv-native/audio/audio_params.h"
+#include <cstddef>
+#include <vector>
+
+namespace afv_native { namespace audio {
+    /** FrameSlab is a contiguous block of audio frames addressed by a dense slot index.
+     *
+     * Slots are handed out and returned by the owner of the stream table (acquire() and
+     * release()), and the slab only ever grows from there.  The render path just indexes
+     * slots that already exist, so it never has to touch the heap.
+     *
+     * @note FrameSlab does no locking of its own.  Growing the slab invalidates any frame
+     * pointers previously handed out, so acquire() must be serialised against anyone holding
+     * them.
+     */
+    class FrameSlab {
+      public:
+        static const size_t InvalidSlot = static_cast<size_t>(-1);
+
+        explicit FrameSlab(size_t initialSlots = 32);
+
+        /** acquire reserves a free slot, growing the slab if none are left.
+         *
+         * @return the slot index.
+         */
+        size_t acquire();
+
+        /** release returns a slot to the free list. */
+        void release(size_t slot);
+
+        /** releaseAll returns every slot to the free list without shrinking the slab. */
+        void releaseAll();
+
+        SampleType *frame(size_t slot) {
+            return mFrames.data() + (slot * frameSizeSamples);
+        }
+
+        const SampleType *frame(size_t slot) const {
+            return mFrames.data() + (slot * frameSizeSamples);
+        }
+
+        /** capacity returns the number of slots currently backed by the slab. */
+        size_t capacity() const {
+            return mCapacity;
+        }
+
+        /** inUse returns the number of slots currently handed out. */
+        size_t inUse() const {
+            return mCapacity - mFreeSlots.size();
+        }
+
+      protected:
+        std::vector<SampleType> mFrames;
+        std::vector<size_t>     mFreeSlots;
+        size_t                  mCapacity;
+
+        void grow(size_t newCapacity);
+    };
+}} // namespace afv_native::audio
@@ -36,6 +36,7 @@
 
 #include "afv-native/audio/SourceStatus.h"
 #include "afv-native/audio/audio_params.h"
+#include <cstddef>
 
 namespace afv_native { namespace audio {
     class ISampleSource {
@@ -47,6 +48,23 @@ namespace afv_native { namespace audio {
          *  the stream.
          */
         virtual SourceStatus getAudioFrame(SampleType *bufferOut) = 0;
+
+        /** fetch the next numSamples samples (per channel) from the source, which needn't
+         * be a whole frame.
+         *
+         * Only sources that return true from partialFrames() implement this - anything
+         * else has to be read a frame at a time.
+         */
+        virtual SourceStatus getAudioSamples(SampleType *bufferOut, size_t numSamples) {
+            (void) bufferOut;
+            (void) numSamples;
+            return SourceStatus::Error;
+        }
+
+        /** partialFrames returns true if the source can be read with getAudioSamples(). */
+        virtual bool partialFrames() const {
+            return false;
+        }
     };
 }} // namespace afv_native::audio
 
@@ -13,6 +13,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #ifdef _WIN32
     #include "windows.h"
@@ -42,6 +43,12 @@ namespace afv_native { namespace audio {
         static void maInputCallback(ma_device *pDevice, void *pOutput, const void *pInput, ma_uint32 frameCount);
         static void maNotificationCallback(const ma_device_notification *pNotification);
         int  outputCallback(void *outputBuffer, unsigned int nFrames);
+        /** fillFromFrames fills nFrames of the output from a source that only supplies whole
+         * frames, keeping what's left of the last one for the next callback.
+         *
+         * @return the number of frames filled, short of nFrames if the source failed.
+         */
+        size_t fillFromFrames(float *out, unsigned int nFrames, size_t channels);
         int  inputCallback(const void *inputBuffer, unsigned int nFrames);
         void notificationCallback(const ma_device_notification *pNotification);
 
@@ -57,6 +64,12 @@ namespace afv_native { namespace audio {
         bool         mStereo = false;
         unsigned int mAudioApi;
         bool         mHasClosedManually = false;
+
+        /** the rest of the last frame read from a whole-frame source, interleaved, starting at
+         * mResidualOffset (in samples per channel).  Only touched by the output callback. */
+        std::vector<SampleType> mResidual;
+        size_t                  mResidualOffset = frameSizeSamples;
+        const ISampleSource    *mResidualSource = nullptr;
     };
 }} // namespace afv_native::audio
 
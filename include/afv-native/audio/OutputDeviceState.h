@@ -14,8 +14,11 @@ namespace afv_native {
          */
 
         audio::SampleType *mMixingBuffer; // for single channel mode
-        audio::SampleType *mLeftMixingBuffer;
-        audio::SampleType *mRightMixingBuffer;
+
+        /** mStereoMixingBuffer is the interleaved stereo equivalent of mMixingBuffer, for
+         * devices that route radios to the left and/or right channel.
+         */
+        audio::SampleType *mStereoMixingBuffer;
         audio::SampleType *mFetchBuffer;
 
         OutputDeviceState();
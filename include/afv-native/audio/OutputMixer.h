@@ -51,6 +51,9 @@ namespace afv_native { namespace audio {
         std::forward_list<MixerSource> mSources;
         float                          mGain;
 
+        /** mIntermediateBuffer holds each source's frame while it's mixed in. */
+        SampleType mIntermediateBuffer[frameSizeSamples];
+
       public:
         OutputMixer();
         virtual ~OutputMixer();
@@ -0,0 +1,54 @@
+#pragma once
+#include "afv-native/audio/audio_params.h"
+#include "afv-native/utility.h"
+#include <cstddef>
+#include <vector>
+
+namespace afv_native { namespace audio {
+    /** PolyphaseUpsampler raises a mono signal's sample rate by a whole factor.
+     *
+     * It's a windowed-sinc low pass split into one short FIR per output phase, so each output
+     * sample only costs tapsPerPhase multiply-adds and the zeros stuffed between the input
+     * samples are never actually filtered.  The pass band runs to 90% of the input's Nyquist
+     * frequency.
+     *
+     * Everything is allocated up front; process() never touches the heap.
+     */
+    class PolyphaseUpsampler {
+      public:
+        static const size_t tapsPerPhase = 16;
+
+        /** @param maxInputSamples the most samples any one call to process() will pass in. */
+        explicit PolyphaseUpsampler(unsigned int factor, size_t maxInputSamples = reducedFrameSizeSamples);
+
+        /** process upsamples inSamples samples of in into inSamples * factor samples of out. */
+        void process(SampleType *RESTRICT out, const SampleType *RESTRICT in, size_t inSamples);
+
+        /** reset clears the filter history. */
+        void reset();
+
+        /** settled returns true if the filter history is all silence, so that processing
+         * silence would only produce silence. */
+        bool settled() const {
+            return mSettled;
+        }
+
+        unsigned int factor() const {
+            return mFactor;
+        }
+
+        /** designLowPass returns a Blackman-windowed sinc low pass with taps taps, a cutoff of
+         * cutoff (as a fraction of the sample rate) and a gain of gain at DC. */
+        static std::vector<float> designLowPass(size_t taps, double cutoff, double gain);
+
+      private:
+        unsigned int mFactor;
+        size_t       mMaxInputSamples;
+        /** the taps of each phase in turn, reversed so each output is a forward dot product
+         * over the history */
+        std::vector<float> mPhaseTaps;
+        /** the last tapsPerPhase - 1 input samples, followed by the samples being processed */
+        std::vector<SampleType> mHistory;
+        bool                    mSettled = true;
+    };
+}} // namespace afv_native::audio
@@ -43,16 +43,23 @@ namespace afv_native { namespace audio {
       protected:
         const std::shared_ptr<ISampleStorage> mSampleSource;
         size_t mCurPosition;
+        size_t mFrameSamples;
         bool   mLoop;
         bool   mPlay;
         bool   mFirstFrame;
 
       public:
-        RecordedSampleSource(std::shared_ptr<ISampleStorage> src, bool loop);
+        /** @param frameSamples the frame size to play at, for a recording that isn't at the
+         *      normal sample rate. */
+        RecordedSampleSource(std::shared_ptr<ISampleStorage> src, bool loop, size_t frameSamples = frameSizeSamples);
         virtual ~RecordedSampleSource();
         SourceStatus getAudioFrame(SampleType *bufferOut) override;
 
+        /** setFrameSamples changes the frame size from the next frame on. */
+        void setFrameSamples(size_t frameSamples);
+
         bool isPlaying() const;
+        /** reset rewinds the source to the start and resumes playback. */
         void reset();
         bool firstFrame();
     };
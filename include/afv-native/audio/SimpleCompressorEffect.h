@@ -9,15 +9,19 @@ namespace afv_native::audio
     class SimpleCompressorEffect
     {
     public:
-        explicit SimpleCompressorEffect();
+        /** @param frameSamples the number of samples in each frame, 0 for a whole
+         *      frameLengthMs frame at sampleRate.  The compressor updates its envelope every
+         *      SF_COMPRESSOR_SPU samples, so it behaves best with a multiple of that. */
+        explicit SimpleCompressorEffect(int sampleRate = sampleRateHz, size_t frameSamples = 0);
         virtual ~SimpleCompressorEffect();
 
         void transformFrame(SampleType *bufferOut, SampleType const bufferIn[]);
 
     private:
         sf_compressor_state_st m_simpleCompressor;
-        sf_snd m_inputSound;
-        sf_snd m_outputSound;
+        int m_frameSamples;
+        sf_sample_st m_inputSamples[frameSizeSamples];
+        sf_sample_st m_outputSamples[frameSizeSamples];
     };
 }
 
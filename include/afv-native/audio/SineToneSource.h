@@ -47,10 +47,17 @@ namespace afv_native { namespace audio {
         double mFrequency;
         float  mGain;
         size_t mFillCount;
+        int    mSampleRate;
+        size_t mFrameSamples;
 
       public:
-        explicit SineToneSource(double freqHz, float gain = 1.0);
+        /** @param frameSamples the number of samples each frame holds, 0 for a whole
+         *      frameLengthMs frame at sampleRate. */
+        explicit SineToneSource(double freqHz, float gain = 1.0, int sampleRate = sampleRateHz, size_t frameSamples = 0);
         SourceStatus getAudioFrame(SampleType *bufferOut) override;
+
+        /** reset restarts the tone from phase zero. */
+        void reset();
     };
 }} // namespace afv_native::audio
 
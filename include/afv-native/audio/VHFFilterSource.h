@@ -55,7 +55,10 @@ namespace afv_native { namespace audio {
      */
     class VHFFilterSource {
       public:
-        explicit VHFFilterSource(HardwareType hd = HardwareType::Schmid_ED_137B);
+        /** @param sampleRate the rate the filter runs at, normally sampleRateHz.
+         * @param frameSamples the number of samples in each frame, 0 for a whole frameLengthMs
+         *      frame at sampleRate. */
+        explicit VHFFilterSource(HardwareType hd = HardwareType::Schmid_ED_137B, int sampleRate = sampleRateHz, size_t frameSamples = 0);
         virtual ~VHFFilterSource();
 
         /** transformFrame lets use apply this filter to a normal buffer, without following the sink/source flow.
@@ -64,14 +67,45 @@ namespace afv_native { namespace audio {
          */
         void transformFrame(SampleType *bufferOut, SampleType const bufferIn[]);
 
+        /** transformFrameEconomy is a cheaper transformFrame for when the render is short of
+         * CPU: just the band edges of the radio's response, without the compressor or limiter.
+         *
+         * Its output is brought up to the loudness of the full chain by a gain measured when
+         * the filter is made, and clipped in place of the limiter.  Each chain keeps its own
+         * state, and the one being switched to is reset first, so neither starts from where
+         * it was left frames ago.
+         */
+        void transformFrameEconomy(SampleType *bufferOut, SampleType const bufferIn[]);
+
+        /** reset returns the filters, compressor and limiter to their initial state without
+         * reallocating them.
+         */
+        void reset();
+
       protected:
         void setupPresets();
 
+        /** matchEconomyGain sets mEconomyGain from the loudness of noise through each chain,
+         * and then resets them both.  The gain only depends on the hardware and the sample
+         * rate, so it's worked out the first time a filter is made for them, and shared by
+         * every one after. */
+        void matchEconomyGain();
+
+        /** measureEconomyGain runs the noise through both chains and returns the gain. */
+        float measureEconomyGain();
+
         chunkware_simple::SimpleComp  *compressor;
         chunkware_simple::SimpleLimit *limiter;
         float compressorPostGain;
         std::vector<BiQuadFilter> mFilters;
+        std::vector<BiQuadFilter> mEconomyFilters;
+        /** mEconomyGain makes the economy chain as loud as the full one */
+        float mEconomyGain = 1.0f;
+        /** mEconomyActive is set while the economy chain is the one in use */
+        bool mEconomyActive = false;
         HardwareType hardware = HardwareType::Schmid_ED_137B;
+        int          mSampleRate;
+        size_t       mFrameSamples;
     };
 }} // namespace afv_native::audio
 
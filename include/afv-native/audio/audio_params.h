@@ -45,6 +45,16 @@ namespace afv_native { namespace audio {
 
     const int frameSizeSamples = (sampleRateHz * frameLengthMs / 1000);
 
+    /** the rate the receive DSP can optionally run at instead - still comfortably above the
+     * radio's voice band - and the frame size at that rate */
+    const int reducedSampleRateHz     = 16000;
+    const int reducedRateFactor       = sampleRateHz / reducedSampleRateHz;
+    const int reducedFrameSizeSamples = (reducedSampleRateHz * frameLengthMs / 1000);
+
+    /** the shortest quantum, in samples, the receive mix can render in.  Quanta are always
+     * whole fractions of a frame, so that each decoded frame is used up exactly. */
+    const int minRenderQuantumSamples = (sampleRateHz * 5 / 1000);
+
     const int32_t encoderBitrate = 16384; /* 16Kibps */
 
     /** approximate target size of outputFrames in bytes */
@@ -0,0 +1,69 @@
+#pragma once
+#include "afv-native/audio/audio_params.h"
+#include "afv-native/utility.h"
+#include <cstddef>
+
+namespace afv_native { namespace audio { namespace kernels {
+    /** Isa identifies one of the kernel implementations.
+     *
+     * The best implementation the CPU supports is picked the first time any kernel is called.
+     * Every implementation produces the same results as Scalar, give or take float rounding in
+     * levels() (which sums in a different order).
+     */
+    enum class Isa {
+        Scalar,
+        SSE2,
+        AVX2,
+        NEON,
+    };
+
+    struct Levels {
+        float peak; // largest absolute sample value
+        float rms;
+    };
+
+    /** isaName returns a printable name for isa. */
+    const char *isaName(Isa isa);
+
+    /** isaSupported returns true if isa was compiled in and the running CPU can execute it. */
+    bool isaSupported(Isa isa);
+
+    /** activeIsa returns the implementation the kernels currently dispatch to. */
+    Isa activeIsa();
+
+    /** selectIsa switches every kernel over to isa.
+     *
+     * This is meant for benchmarks and diagnostics and should be called before audio starts.
+     *
+     * @return false (leaving the selection alone) if isa isn't supported.
+     */
+    bool selectIsa(Isa isa);
+
+    /** mix adds src, scaled by gain, into dst. */
+    void mix(SampleType *RESTRICT dst, const SampleType *RESTRICT src, float gain, size_t numSamples = frameSizeSamples);
+
+    /** scale multiplies buf by gain in place. */
+    void scale(SampleType *buf, float gain, size_t numSamples = frameSizeSamples);
+
+    /** clamp limits buf to [-1.0, 1.0] in place. */
+    void clamp(SampleType *buf, size_t numSamples = frameSizeSamples);
+
+    /** mixClamp is mix() followed by clamp() on dst, in a single pass. */
+    void mixClamp(SampleType *RESTRICT dst, const SampleType *RESTRICT src, float gain, size_t numSamples = frameSizeSamples);
+
+    /** scaleClamp writes src scaled by gain and limited to [-1.0, 1.0] into dst.  dst may be src. */
+    void scaleClamp(SampleType *dst, const SampleType *src, float gain, size_t numSamples = frameSizeSamples);
+
+    /** levels measures the peak and RMS level of buf. */
+    Levels levels(const SampleType *buf, size_t numSamples = frameSizeSamples);
+
+    /** interleave writes left and right into out as interleaved stereo (numSamples frames). */
+    void interleave(const SampleType *RESTRICT left, const SampleType *RESTRICT right, SampleType *RESTRICT out, size_t numSamples = frameSizeSamples);
+
+    /** mixMonoToStereo routes a mono buffer into an interleaved stereo buffer, adding mono
+     * scaled by gainLeft into the left channel and by gainRight into the right.
+     *
+     * A gain of 0 leaves that channel untouched, so this covers left-only, right-only and both.
+     */
+    void mixMonoToStereo(SampleType *RESTRICT stereo, const SampleType *RESTRICT mono, float gainLeft, float gainRight, size_t numSamples = frameSizeSamples);
+}}} // namespace afv_native::audio::kernels
@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace afv_native { namespace util {
+    /** allocationTrackingEnabled returns true if the library was built with
+     * AFV_NATIVE_TRACK_ALLOCATIONS, in which case the global allocation operators are replaced
+     * with counting versions.
+     */
+    bool allocationTrackingEnabled();
+
+    /** threadAllocationCount returns the number of heap allocations made by the calling thread
+     * so far.  Always 0 if allocation tracking is not compiled in.
+     */
+    uint64_t threadAllocationCount();
+
+    /** allocationViolations returns the number of NoAllocationScopes that saw an allocation. */
+    uint64_t allocationViolations();
+
+    /** NoAllocationScope asserts that no heap allocations are made on the current thread for
+     * as long as it is in scope.
+     *
+     * It's meant for the realtime paths (audio rendering) that must never call into the
+     * allocator.  Violations are counted and logged when the scope ends, and trip an assert in
+     * debug builds.  Without AFV_NATIVE_TRACK_ALLOCATIONS this compiles down to nothing.
+     */
+    class NoAllocationScope {
+      public:
+        explicit NoAllocationScope(const char *where);
+        ~NoAllocationScope();
+
+        NoAllocationScope(const NoAllocationScope &) = delete;
+        NoAllocationScope &operator=(const NoAllocationScope &) = delete;
+
+        /** allocations returns the number of allocations made within the scope so far. */
+        uint64_t allocations() const;
+
+      private:
+        const char *mWhere;
+        uint64_t    mStartCount;
+    };
+}} // namespace afv_native::util
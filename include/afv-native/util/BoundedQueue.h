@@ -0,0 +1,99 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace afv_native { namespace util {
+    /** BoundedQueue is a fixed-capacity, lock-free multi-producer/multi-consumer queue.
+     *
+     * It's used to pass small POD messages out of the realtime audio threads: push() never
+     * blocks or allocates, it just fails when the queue is full.  Dropped pushes are counted so
+     * the overflow can be reported from somewhere that's allowed to log.
+     *
+     * This is the classic bounded MPMC ring with a sequence number per cell.
+     *
+     * @tparam T a trivially copyable message type.
+     * @tparam Capacity the number of cells, must be a power of two.
+     */
+    template <typename T, size_t Capacity>
+    class BoundedQueue {
+        static_assert(std::is_trivially_copyable<T>::value, "BoundedQueue only carries POD messages");
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+      public:
+        BoundedQueue(): mEnqueuePos(0), mDequeuePos(0), mDropped(0) {
+            for (size_t i = 0; i < Capacity; i++) {
+                mCells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        BoundedQueue(const BoundedQueue &)            = delete;
+        BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+        /** push appends value to the queue.
+         *
+         * @return false (and counts a drop) if the queue was full.
+         */
+        bool push(const T &value) {
+            size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell     &cell = mCells[pos & (Capacity - 1)];
+                size_t    seq  = cell.sequence.load(std::memory_order_acquire);
+                ptrdiff_t diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos);
+                if (diff == 0) {
+                    if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        cell.value = value;
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    mDropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                } else {
+                    pos = mEnqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /** pop removes the oldest value from the queue into valueOut.
+         *
+         * @return false if the queue was empty.
+         */
+        bool pop(T &valueOut) {
+            size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell     &cell = mCells[pos & (Capacity - 1)];
+                size_t    seq  = cell.sequence.load(std::memory_order_acquire);
+                ptrdiff_t diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos + 1);
+                if (diff == 0) {
+                    if (mDequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        valueOut = cell.value;
+                        cell.sequence.store(pos + Capacity, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = mDequeuePos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /** dropped returns the number of pushes rejected because the queue was full. */
+        uint64_t dropped() const {
+            return mDropped.load(std::memory_order_relaxed);
+        }
+
+      private:
+        struct Cell {
+            std::atomic<size_t> sequence;
+            T                   value;
+        };
+
+        Cell mCells[Capacity];
+        alignas(64) std::atomic<size_t> mEnqueuePos;
+        alignas(64) std::atomic<size_t> mDequeuePos;
+        std::atomic<uint64_t>           mDropped;
+    };
+}} // namespace afv_native::util
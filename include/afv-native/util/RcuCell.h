@@ -0,0 +1,134 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace afv_native { namespace util {
+    /** RcuCell holds an immutable value that a writer replaces wholesale, and that readers can
+     * access without ever blocking on the writer.
+     *
+     * Readers announce the epoch they started in into one of MaxReaders slots before loading
+     * the current pointer.  publish() swaps the pointer, bumps the epoch and retires the
+     * previous value tagged with the new epoch - it is only destroyed once every reader that
+     * could still see it has left.  Retired values are cleaned up on the next publish() or
+     * reclaim(), on the writer's thread, so readers never free memory either.
+     *
+     * @note publish() and reclaim() must be serialised by the caller.  Reads are wait-free as
+     * long as there are no more concurrent readers than slots.
+     */
+    template <typename T, size_t MaxReaders = 8>
+    class RcuCell {
+      public:
+        /** ReadGuard pins the value current at the time it was taken for its lifetime. */
+        class ReadGuard {
+          public:
+            ReadGuard(ReadGuard &&other) noexcept: mSlot(other.mSlot), mValue(other.mValue) {
+                other.mSlot = nullptr;
+            }
+            ReadGuard(const ReadGuard &)            = delete;
+            ReadGuard &operator=(const ReadGuard &) = delete;
+
+            ~ReadGuard() {
+                if (mSlot != nullptr) {
+                    mSlot->store(0, std::memory_order_release);
+                }
+            }
+
+            const T &operator*() const {
+                return *mValue;
+            }
+            const T *operator->() const {
+                return mValue;
+            }
+            const T *get() const {
+                return mValue;
+            }
+
+          private:
+            friend class RcuCell;
+            ReadGuard(std::atomic<uint64_t> *slot, const T *value): mSlot(slot), mValue(value) {
+            }
+
+            std::atomic<uint64_t> *mSlot;
+            const T               *mValue;
+        };
+
+        explicit RcuCell(std::unique_ptr<T> initial = std::make_unique<T>()):
+            mCurrent(initial.release()), mEpoch(1), mRetired() {
+            for (auto &slot: mReaders) {
+                slot.store(0);
+            }
+        }
+
+        ~RcuCell() {
+            delete mCurrent.load();
+            for (auto &retired: mRetired) {
+                delete retired.value;
+            }
+        }
+
+        RcuCell(const RcuCell &)            = delete;
+        RcuCell &operator=(const RcuCell &) = delete;
+
+        /** read pins and returns the current value. */
+        ReadGuard read() {
+            for (;;) {
+                for (auto &slot: mReaders) {
+                    uint64_t free = 0;
+                    if (slot.compare_exchange_strong(free, mEpoch.load())) {
+                        return ReadGuard(&slot, mCurrent.load());
+                    }
+                }
+                // every slot's busy - that's only possible with more readers than slots.
+                std::this_thread::yield();
+            }
+        }
+
+        /** publish makes next the current value and retires the previous one. */
+        void publish(std::unique_ptr<T> next) {
+            const T *previous = mCurrent.exchange(next.release());
+            uint64_t tag      = mEpoch.fetch_add(1) + 1;
+            mRetired.push_back({previous, tag});
+            reclaim();
+        }
+
+        /** reclaim destroys all retired values that no reader can still be using. */
+        void reclaim() {
+            uint64_t oldestReader = UINT64_MAX;
+            for (auto &slot: mReaders) {
+                uint64_t epoch = slot.load();
+                if (epoch != 0 && epoch < oldestReader) {
+                    oldestReader = epoch;
+                }
+            }
+            auto it = mRetired.begin();
+            while (it != mRetired.end()) {
+                if (it->tag <= oldestReader) {
+                    delete it->value;
+                    it = mRetired.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        /** retiredCount returns the number of values still waiting on readers. */
+        size_t retiredCount() const {
+            return mRetired.size();
+        }
+
+      private:
+        struct Retired {
+            const T *value;
+            uint64_t tag;
+        };
+
+        std::atomic<const T *> mCurrent;
+        std::atomic<uint64_t>  mEpoch;
+        std::atomic<uint64_t>  mReaders[MaxReaders];
+        std::vector<Retired>   mRetired;
+    };
+}} // namespace afv_native::util
@@ -0,0 +1,254 @@
+#pragma once
+#include "afv-native/util/monotime.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace afv_native { namespace util {
+    /** TimerWheel is a hierarchical timing wheel for large numbers of timeouts that are mostly
+     * rearmed or cancelled long before they expire.
+     *
+     * Time is cut into ticks of tickMs.  The first level has a slot for each of the next 64
+     * ticks, and every level above it covers 64 times the span of the one below, so four levels
+     * reach about 16.7 million ticks ahead.  A timer goes in the slot its deadline falls in on
+     * the lowest level that reaches that far, and is moved down a level each time the level
+     * below wraps around to it.  Scheduling, rearming and cancelling are O(1), and advance()
+     * only touches the slots it passes over - there are never any full scans.
+     *
+     * Timers are intrusive: each one lives inside whatever it times out and carries a key
+     * that identifies it.  Nothing is allocated.  A timer never fires before its deadline: it
+     * fires from the first advance() that reaches the end of the tick its deadline falls in.
+     *
+     * @note TimerWheel isn't thread safe.  The wheel and all of its timers must be guarded by
+     *      the same lock, including when a scheduled timer is destroyed.
+     *
+     * @tparam Key the type identifying what each timer belongs to.
+     */
+    template <typename Key>
+    class TimerWheel {
+      public:
+        static const unsigned int levelBits     = 6;
+        static const size_t       slotsPerLevel = size_t(1) << levelBits;
+        static const unsigned int levels        = 4;
+
+        class Timer {
+          public:
+            Timer() = default;
+
+            explicit Timer(Key k): key(std::move(k)) {
+            }
+
+            /* Copies get the key, but never the schedule - a copy of something being timed out
+             * isn't itself timed out, and assigning over a timer cancels it. */
+            Timer(const Timer &other): key(other.key) {
+            }
+
+            Timer &operator=(const Timer &other) {
+                if (this != &other) {
+                    cancel();
+                    key = other.key;
+                }
+                return *this;
+            }
+
+            ~Timer() {
+                cancel();
+            }
+
+            bool scheduled() const {
+                return mWheel != nullptr;
+            }
+
+            /** deadline returns the monotonic time the timer was last scheduled for. */
+            monotime_t deadline() const {
+                return mDeadline;
+            }
+
+            void cancel() {
+                if (mWheel != nullptr) {
+                    mWheel->cancel(*this);
+                }
+            }
+
+            Key key {};
+
+          private:
+            friend class TimerWheel;
+
+            TimerWheel *mWheel    = nullptr;
+            Timer      *mPrev     = nullptr;
+            Timer      *mNext     = nullptr;
+            Timer     **mSlot     = nullptr;
+            monotime_t  mDeadline = 0;
+        };
+
+        /**
+         * @param tickMs the resolution of the wheel, in milliseconds.
+         * @param now the current monotonic time.
+         */
+        TimerWheel(monotime_t tickMs, monotime_t now):
+            mTickMs(tickMs > 0 ? tickMs : 1), mCurrentTick(static_cast<uint64_t>(now) / mTickMs), mCount(0) {
+            for (auto &level: mSlots) {
+                for (auto &slot: level) {
+                    slot = nullptr;
+                }
+            }
+        }
+
+        /* Any timers still scheduled are left unscheduled, so they can outlive the wheel. */
+        ~TimerWheel() {
+            for (auto &level: mSlots) {
+                for (auto &slot: level) {
+                    while (slot != nullptr) {
+                        unlink(*slot);
+                    }
+                }
+            }
+        }
+
+        TimerWheel(const TimerWheel &)            = delete;
+        TimerWheel &operator=(const TimerWheel &) = delete;
+
+        /** schedule (re)arms timer to fire at deadline, replacing any earlier deadline. */
+        void schedule(Timer &timer, monotime_t deadline) {
+            if (timer.mWheel == this) {
+                unlink(timer);
+            } else {
+                timer.cancel();
+                mCount++;
+            }
+            timer.mDeadline = deadline;
+            insert(timer, mCurrentTick + 1);
+        }
+
+        /** cancel disarms timer.  It's fine to cancel a timer that isn't scheduled. */
+        void cancel(Timer &timer) {
+            if (timer.mWheel == this) {
+                unlink(timer);
+                mCount--;
+            }
+        }
+
+        /** advance moves the wheel on to now and calls expired(timer) for every timer whose
+         * deadline has passed.
+         *
+         * Each timer is unscheduled before expired is called, so the callback may destroy it,
+         * or schedule it (or any other timer) again.
+         *
+         * @return the number of timers that expired.
+         */
+        template <typename F>
+        size_t advance(monotime_t now, F &&expired) {
+            const uint64_t target = static_cast<uint64_t>(now) / mTickMs;
+            size_t         fired  = 0;
+            while (mCurrentTick < target) {
+                if (mCount == 0) {
+                    // nothing to pass over on the way.
+                    mCurrentTick = target;
+                    break;
+                }
+                mCurrentTick++;
+                for (unsigned int level = 1; level < levels; level++) {
+                    if ((mCurrentTick & (span(level) - 1)) != 0) {
+                        break;
+                    }
+                    cascade(level, (mCurrentTick >> (levelBits * level)) & (slotsPerLevel - 1));
+                }
+
+                Timer *&slot = mSlots[0][mCurrentTick & (slotsPerLevel - 1)];
+                while (slot != nullptr) {
+                    Timer &timer = *slot;
+                    unlink(timer);
+                    if (expiry_tick(timer) > mCurrentTick) {
+                        // it was too far ahead for the wheel when it was scheduled.
+                        insert(timer, mCurrentTick + 1);
+                        continue;
+                    }
+                    mCount--;
+                    fired++;
+                    expired(timer);
+                }
+            }
+            return fired;
+        }
+
+        /** size returns the number of scheduled timers. */
+        size_t size() const {
+            return mCount;
+        }
+
+        monotime_t tickMs() const {
+            return mTickMs;
+        }
+
+      private:
+        static uint64_t span(unsigned int level) {
+            return uint64_t(1) << (levelBits * level);
+        }
+
+        /* The tick a timer fires on - rounded up, so it never fires early. */
+        uint64_t expiry_tick(const Timer &timer) const {
+            if (timer.mDeadline <= 0) {
+                return 0;
+            }
+            return (static_cast<uint64_t>(timer.mDeadline) + mTickMs - 1) / mTickMs;
+        }
+
+        /* earliest is the first tick the timer may go in: the current tick has already been
+         * dealt with unless we're cascading into it. */
+        void insert(Timer &timer, uint64_t earliest) {
+            uint64_t expiry = expiry_tick(timer);
+            if (expiry < earliest) {
+                expiry = earliest;
+            }
+            const uint64_t delta = expiry - mCurrentTick;
+            unsigned int   level = 0;
+            while (level + 1 < levels && delta >= span(level + 1)) {
+                level++;
+            }
+            if (delta >= span(levels)) {
+                expiry = mCurrentTick + span(levels) - 1;
+            }
+            Timer *&slot = mSlots[level][(expiry >> (levelBits * level)) & (slotsPerLevel - 1)];
+
+            timer.mWheel = this;
+            timer.mSlot  = &slot;
+            timer.mPrev  = nullptr;
+            timer.mNext  = slot;
+            if (slot != nullptr) {
+                slot->mPrev = &timer;
+            }
+            slot = &timer;
+        }
+
+        void unlink(Timer &timer) {
+            if (timer.mPrev != nullptr) {
+                timer.mPrev->mNext = timer.mNext;
+            } else {
+                *timer.mSlot = timer.mNext;
+            }
+            if (timer.mNext != nullptr) {
+                timer.mNext->mPrev = timer.mPrev;
+            }
+            timer.mWheel = nullptr;
+            timer.mSlot  = nullptr;
+            timer.mPrev  = nullptr;
+            timer.mNext  = nullptr;
+        }
+
+        /* Redistributes a slot's timers over the levels below it. */
+        void cascade(unsigned int level, uint64_t index) {
+            Timer *&slot = mSlots[level][index];
+            while (slot != nullptr) {
+                Timer &timer = *slot;
+                unlink(timer);
+                insert(timer, mCurrentTick);
+            }
+        }
+
+        const monotime_t mTickMs;
+        uint64_t         mCurrentTick;
+        size_t           mCount;
+        Timer           *mSlots[levels][slotsPerLevel];
+    };
+}} // namespace afv_native::util
@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace afv_native { namespace util {
+    /** WorkStealingPool runs the iterations of a parallel-for across a fixed set of worker
+     * threads, with the calling thread joining in.
+     *
+     * Each call splits [0, count) into one contiguous range per participant.  Participants work
+     * through their own range from the front and, once it's empty, steal from the back of
+     * everyone else's.  parallelFor() doesn't return until every iteration has run.  It never
+     * allocates, so it can be called from an audio callback.
+     *
+     * In deterministic mode nothing is stolen, so each iteration always runs on the same
+     * participant for a given count.  That costs some balance but makes runs reproducible when
+     * profiling or debugging.
+     *
+     * @note parallelFor() calls must be serialised by the caller.
+     */
+    class WorkStealingPool {
+      public:
+        /** @param threads the number of worker threads to start, not counting the caller. */
+        WorkStealingPool(unsigned threads, bool deterministic);
+        ~WorkStealingPool();
+
+        WorkStealingPool(const WorkStealingPool &)            = delete;
+        WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+        unsigned threadCount() const {
+            return static_cast<unsigned>(mThreads.size());
+        }
+
+        bool deterministic() const {
+            return mDeterministic;
+        }
+
+        /** stolen returns the number of iterations that ran on a participant other than the one
+         * they were assigned to. */
+        uint64_t stolen() const {
+            return mStolen.load(std::memory_order_relaxed);
+        }
+
+        /** parallelFor calls body(i) for every i in [0, count), spread across the pool. */
+        template <typename F>
+        void parallelFor(size_t count, F &body) {
+            run(count, &invoke<F>, &body);
+        }
+
+      private:
+        typedef void (*TaskFn)(void *context, size_t index);
+
+        template <typename F>
+        static void invoke(void *context, size_t index) {
+            (*static_cast<F *>(context))(index);
+        }
+
+        /* A participant's range is packed into one word so both ends can be claimed with a
+         * single CAS: | 24-bit job tag | 20-bit begin | 20-bit end |.  The tag stops a worker
+         * that woke up late for one job from claiming iterations of the next. */
+        struct alignas(64) Range {
+            std::atomic<uint64_t> bounds;
+        };
+
+        void run(size_t count, TaskFn fn, void *context);
+        void worker_main(unsigned participant);
+        void execute(unsigned participant, uint32_t tag, TaskFn fn, void *context);
+        bool claim(unsigned participant, uint32_t tag, bool fromBack, size_t &indexOut);
+
+        const bool               mDeterministic;
+        std::vector<std::thread> mThreads;
+        std::unique_ptr<Range[]> mRanges; // participant 0 is the caller
+
+        std::mutex              mJobLock;
+        std::condition_variable mJobReady;
+        uint64_t                mJobGeneration;
+        TaskFn                  mJobFn;
+        void                   *mJobContext;
+        bool                    mStopping;
+
+        std::atomic<size_t>   mRemaining;
+        std::atomic<uint64_t> mStolen;
+    };
+}} // namespace afv_native::util
@@ -34,26 +34,71 @@
  */
 
 #include "afv-native/afv/ATCRadioSimulation.h"
-#include "afv-native/audio/VHFFilterSource.h"
+#include "afv-native/audio/kernels.h"
 #include "afv-native/event.h"
 #include "afv-native/util/other.h"
+#include <algorithm>
 #include <cstddef>
 #include <memory>
 
 using namespace afv_native;
 using namespace afv_native::afv;
 
-const float  fxClickGain         = 1.3f;
-const float  fxBlockToneGain     = 0.25f;
-const float  fxBlockToneFreq     = 180.0f;
-const float  fxAcBusGain         = 0.005f;
-const float  fxVhfWhiteNoiseGain = 0.17f;
-const float  fxHfWhiteNoiseGain  = 0.16f;
-const double minDb               = -40.0;
-const double maxDb               = 0.0;
+const double minDb = -40.0;
+const double maxDb = 0.0;
 
-AtcCallsignMeta::AtcCallsignMeta(): source(), transceivers() {
-    source = std::make_shared<RemoteVoiceSource>();
+AtcRadioState *AtcRadioTable::find(unsigned int freq) {
+    auto it = mSlotByFrequency.find(freq);
+    return it != mSlotByFrequency.end() ? &mSlots[it->second] : nullptr;
+}
+
+const AtcRadioState *AtcRadioTable::find(unsigned int freq) const {
+    auto it = mSlotByFrequency.find(freq);
+    return it != mSlotByFrequency.end() ? &mSlots[it->second] : nullptr;
+}
+
+AtcRadioState &AtcRadioTable::add(unsigned int freq) {
+    uint32_t slot;
+    auto     existing = mSlotByFrequency.find(freq);
+    if (existing != mSlotByFrequency.end()) {
+        slot = existing->second;
+    } else if (!mFreeSlots.empty()) {
+        slot = mFreeSlots.back();
+        mFreeSlots.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(mSlots.size());
+        mSlots.emplace_back();
+        mInUse.push_back(false);
+    }
+    mSlotByFrequency[freq] = slot;
+    mInUse[slot]           = true;
+
+    AtcRadioState &state   = mSlots[slot];
+    state                  = AtcRadioState();
+    state.Frequency        = freq;
+    state.voiceTimeout.key = freq;
+    return state;
+}
+
+bool AtcRadioTable::remove(unsigned int freq) {
+    auto it = mSlotByFrequency.find(freq);
+    if (it == mSlotByFrequency.end()) {
+        return false;
+    }
+    const uint32_t slot = it->second;
+    mSlotByFrequency.erase(it);
+    // drop everything the radio held on to (its dsp, its timeout) now, not when the slot is reused.
+    mSlots[slot] = AtcRadioState();
+    mInUse[slot] = false;
+    mFreeSlots.push_back(slot);
+    return true;
+}
+
+void AtcRadioTable::clear() {
+    mSlots.clear();
+    mInUse.clear();
+    mFreeSlots.clear();
+    mSlotByFrequency.clear();
 }
 
 AtcOutputAudioDevice::AtcOutputAudioDevice(std::weak_ptr<ATCRadioSimulation> radio, bool onHeadset):
@@ -64,12 +109,22 @@ audio::SourceStatus AtcOutputAudioDevice::getAudioFrame(audio::SampleType *buffe
     return mRadio.lock()->getAudioFrame(bufferOut, onHeadset);
 }
 
+audio::SourceStatus AtcOutputAudioDevice::getAudioSamples(audio::SampleType *bufferOut, size_t numSamples) {
+    return mRadio.lock()->getAudioSamples(bufferOut, numSamples, onHeadset);
+}
+
+bool AtcOutputAudioDevice::partialFrames() const {
+    return true;
+}
+
 ATCRadioSimulation::ATCRadioSimulation(struct event_base *evBase, std::shared_ptr<EffectResources> resources, cryptodto::UDPChannel *channel):
-    IncomingAudioStreams(0), mEvBase(evBase), mResources(std::move(resources)), mChannel(), mStreamMapLock(), mHeadsetIncomingStreams(), mSpeakerIncomingStreams(), mRadioStateLock(), mPtt(false), mLastFramePtt(false), mTxSequence(0), mVoiceSink(std::make_shared<VoiceCompressionSink>(*this)), mVoiceFilter(std::make_shared<audio::SpeexPreprocessor>(mVoiceSink)), mMaintenanceTimer(mEvBase, std::bind(&ATCRadioSimulation::maintainIncomingStreams, this)), mVoiceTimeoutTimer(mEvBase, std::bind(&ATCRadioSimulation::maintainVoiceTimeout, this)), mVuMeter(300 / audio::frameLengthMs) // VU is a 300ms zero to peak response...
+    RadioRenderCore(*resources), mEvBase(evBase), mResources(std::move(resources)), mChannel(), mRadioStateLock(), mVoiceTimeouts(expiryTickMs, util::monotime_get()), mLastFramePtt(false), mTxSequence(0), mVoiceSink(std::make_shared<VoiceCompressionSink>(*this)), mVoiceFilter(std::make_shared<audio::SpeexPreprocessor>(mVoiceSink)), mMaintenanceTimer(mEvBase, std::bind(&ATCRadioSimulation::maintainIncomingStreams, this)), mVoiceTimeoutTimer(mEvBase, std::bind(&ATCRadioSimulation::maintainVoiceTimeout, this)), mRenderEventTimer(mEvBase, std::bind(&ATCRadioSimulation::dispatchRenderEvents, this)), mVuMeter(300 / audio::frameLengthMs) // VU is a 300ms zero to peak response...
 {
     setUDPChannel(channel);
-    mMaintenanceTimer.enable(maintenanceTimerIntervalMs);
-    mVoiceTimeoutTimer.enable(voiceTimeoutIntervalMs);
+    LOG("ATCRadioSimulation", "mixing with %s audio kernels", audio::kernels::isaName(audio::kernels::activeIsa()));
+    mMaintenanceTimer.enable(expiryTickMs);
+    mVoiceTimeoutTimer.enable(expiryTickMs);
+    mRenderEventTimer.enable(renderEventIntervalMs);
 }
 
 ATCRadioSimulation::~ATCRadioSimulation() {
@@ -87,27 +142,12 @@ void ATCRadioSimulation::putAudioFrame(const audio::SampleType *bufferIn) {
         ::memcpy(samples, bufferIn, sizeof(samples));
     }
 
-    float value = 0;
-    for (int i = 0; i < audio::frameSizeSamples; i++) {
-        value = samples[i] * mMicVolume;
-        if (value > 1.0f) {
-            value = 1.0f;
-        }
-        if (value < -1.0f) {
-            value = -1.0f;
-        }
-        samples[i] = value;
-    }
+    audio::kernels::scaleClamp(samples, samples, mMicVolume);
 
     // do the peak/Vu calcs
     {
-        auto             *b    = samples;
-        int               i    = audio::frameSizeSamples - 1;
-        audio::SampleType peak = fabs(*(b++));
-        while (i-- > 0) {
-            peak = std::max<audio::SampleType>(peak, fabs(*(b++)));
-        }
-        double peakDb = 20.0 * log10(peak);
+        audio::SampleType peak   = audio::kernels::levels(samples).peak;
+        double            peakDb = 20.0 * log10(peak);
         peakDb        = std::max(minDb, peakDb);
         peakDb        = std::min(maxDb, peakDb);
         double ratio  = (peakDb - minDb) / (maxDb - minDb);
@@ -129,50 +169,45 @@ void ATCRadioSimulation::putAudioFrame(const audio::SampleType *bufferIn) {
     mVoiceSink->putAudioFrame(samples);
 }
 
-void ATCRadioSimulation::processCompressedFrame(std::vector<unsigned char> compressedData) {
+void ATCRadioSimulation::processCompressedFrame(const std::vector<unsigned char> &compressedData) {
     if (mChannel != nullptr && mChannel->isOpen()) {
         dto::AudioTxOnTransceivers audioOutDto;
-        {
-            std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-
-            if (!mPtt.load()) {
-                audioOutDto.LastPacket = true;
-                mLastFramePtt          = false;
-            } else {
-                audioOutDto.LastPacket = false;
-                mLastFramePtt          = true;
-            }
-
-            for (auto &[_, radio]: mRadioState) {
-                if (!radio.tx) {
-                    continue;
-                }
+        if (!mPtt.load()) {
+            audioOutDto.LastPacket = true;
+            mLastFramePtt          = false;
+        } else {
+            audioOutDto.LastPacket = false;
+            mLastFramePtt          = true;
+        }
 
-                for (const auto trans: radio.transceivers) {
-                    audioOutDto.Transceivers.emplace_back(trans.ID);
-                }
+        {
+            auto config = mRadioConfig.read();
+            for (auto id: config->txTransceiverIDs) {
+                audioOutDto.Transceivers.emplace_back(id);
             }
         }
         audioOutDto.SequenceCounter = std::atomic_fetch_add<uint32_t>(&mTxSequence, 1);
         audioOutDto.Callsign = mCallsign;
-        audioOutDto.Audio    = std::move(compressedData);
+        audioOutDto.Audio    = compressedData;
         mChannel->sendDto(audioOutDto);
     }
 }
 
-void ATCRadioSimulation::mix_buffers(audio::SampleType *RESTRICT src_dst, const audio::SampleType *RESTRICT src2, float src2_gain) {
-    for (int i = 0; i < audio::frameSizeSamples; i++) {
-        src_dst[i] += (src2_gain * src2[i]);
+bool ATCRadioSimulation::skipCompressedFrame() {
+    if (!mPtt.load()) {
+        // the last frame is what ends the transmission, so it has to go.
+        return false;
     }
+    // the sequence still moves on, so receivers know how long the gap is.
+    mLastFramePtt = true;
+    std::atomic_fetch_add<uint32_t>(&mTxSequence, 1);
+    return true;
 }
 
 bool ATCRadioSimulation::getTxActive(unsigned int radio) {
     std::lock_guard<std::mutex> mRadioStateGuard(mRadioStateLock);
-    if (!isFrequencyActive(radio)) {
-        return false;
-    }
-
-    if (!mRadioState[radio].tx) {
+    const AtcRadioState        *state = mRadios.find(radio);
+    if (state == nullptr || !state->tx) {
         return false;
     }
     return mPtt.load();
@@ -180,338 +215,106 @@ bool ATCRadioSimulation::getTxActive(unsigned int radio) {
 
 bool ATCRadioSimulation::getRxActive(unsigned int radio) {
     std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-    if (!isFrequencyActive(radio)) {
+    const AtcRadioState        *state = mRadios.find(radio);
+    if (state == nullptr || !state->rx) {
         return false;
     }
 
-    if (!mRadioState[radio].rx) {
-        return false;
-    }
-
-    return (mRadioState[radio].mLastRxCount > 0);
-}
-
-inline bool freqIsHF(unsigned int freq) {
-    return freq < 30000000;
+    return (state->dsp && state->dsp->mLastRxCount.load() > 0);
 }
 
-bool ATCRadioSimulation::_process_radio(const std::map<void *, audio::SampleType[audio::frameSizeSamples]> &sampleCache, unsigned int rxIter, bool onHeadset) {
-    if (!isFrequencyActive(rxIter)) {
-        resetRadioFx(rxIter);
-        return false;
-    }
-
-    bool ignoreaudio = false;
-    std::shared_ptr<OutputDeviceState> state = onHeadset ? mHeadsetState : mSpeakerState;
-
-    ::memset(state->mChannelBuffer, 0, audio::frameSizeBytes);
-    if (mPtt.load() && mRadioState[rxIter].tx) {
-        // don't analyze and mix-in the radios transmitting, but suppress the
-        // effects.
-        resetRadioFx(rxIter, true);
-        ignoreaudio = true;
-        // return true;
+void ATCRadioSimulation::dispatchRenderEvents() {
+    RenderEvent event;
+    while (mRenderEvents.pop(event)) {
+        handle_rx_transition(event.frequency, event.type == RenderEvent::FrequencyRxBegin);
     }
-    // now, find all streams that this applies to.
-    float    crackleGain       = 0.0f;
-    float    hfGain            = 0.0f;
-    float    vhfGain           = 0.0f;
-    float    acBusGain         = 0.0f;
-    uint32_t concurrentStreams = 0;
-    for (auto &srcPair: (onHeadset ? mHeadsetIncomingStreams : mSpeakerIncomingStreams)) {
-        if (!srcPair.second.source || !srcPair.second.source->isActive() ||
-            (sampleCache.find(srcPair.second.source.get()) == sampleCache.end())) {
-            continue;
-        }
-        bool  mUseStream = false;
-        float voiceGain  = 1.0f;
-
-        std::vector<afv::dto::RxTransceiver> matchingTransceivers;
-        std::copy_if(srcPair.second.transceivers.begin(),
-                     srcPair.second.transceivers.end(), std::back_inserter(matchingTransceivers), [&](afv::dto::RxTransceiver k) {
-                         return k.Frequency == mRadioState[rxIter].Frequency;
-                     });
-
-        if (matchingTransceivers.size() > 0) {
-            mUseStream = true;
-
-            auto closestTransceiver = *std::max_element(matchingTransceivers.begin(),
-                                                        matchingTransceivers.end(), [](afv::dto::RxTransceiver a, afv::dto::RxTransceiver b) {
-                                                            return (a.DistanceRatio < b.DistanceRatio);
-                                                        });
-
-            float crackleFactor = 0.0f;
-            if (!mRadioState[rxIter].mBypassEffects) {
-                crackleFactor = static_cast<float>((exp(closestTransceiver.DistanceRatio) *
-                                                    pow(closestTransceiver.DistanceRatio, -4.0) / 350.0) -
-                                                   0.00776652);
-                crackleFactor = fmax(0.0f, crackleFactor);
-                crackleFactor = fmin(0.20f, crackleFactor);
-
-                if (freqIsHF(rxIter)) {
-                    if (!mRadioState[rxIter].mHfSquelch) {
-                        hfGain = fxHfWhiteNoiseGain;
-                    } else {
-                        hfGain = 0.0f;
-                    }
-                    vhfGain   = 0.0f;
-                    acBusGain = 0.001f;
-                    voiceGain = 0.20f;
-                } else {
-                    hfGain    = 0.0f;
-                    vhfGain   = fxVhfWhiteNoiseGain;
-                    acBusGain = fxAcBusGain;
-                    crackleGain += crackleFactor * 2;
-                    voiceGain = 1.0 - crackleFactor * 3.7;
-                }
-            }
-        }
-
-        if (mUseStream) {
-            // then include this stream.
-            try {
-                if (!ignoreaudio) {
-                    mix_buffers(state->mChannelBuffer,
-                                sampleCache.at(srcPair.second.source.get()),
-                                voiceGain * mRadioState[rxIter].Gain);
-                }
-
-                concurrentStreams++;
-            } catch (const std::out_of_range &) {
-                LOG("ATCRadioSimulation", "internal error:  Tried to mix uncached stream");
-            }
-        }
+    const uint64_t dropped = mRenderEvents.dropped();
+    if (dropped != mReportedDroppedRenderEvents) {
+        LOG("ATCRadioSimulation", "render event queue overflowed: %llu event(s) dropped",
+            static_cast<unsigned long long>(dropped - mReportedDroppedRenderEvents));
+        mReportedDroppedRenderEvents = dropped;
     }
-
-    if (concurrentStreams > 0) {
-        if (mRadioState[rxIter].mLastRxCount == 0 && !ignoreaudio) {
-            // Post Begin Voice Receiving Notfication
-            unsigned int freq = rxIter;
-            mRadioState[rxIter].liveTransmittingCallsigns = {}; // We know for sure nobody is transmitting yet
-            ClientEventCallback->invokeAll(ClientEventType::FrequencyRxBegin, &freq, nullptr);
-            LOG("ATCRadioSimulation", "FrequencyRxBegin event: %i", freq);
-        }
-        if (!mRadioState[rxIter].mBypassEffects) {
-            // limiter effect
-            for (unsigned int i = 0; i < audio::frameSizeSamples; i++) {
-                if (state->mChannelBuffer[i] > 1.0f) {
-                    state->mChannelBuffer[i] = 1.0f;
-                }
-                if (state->mChannelBuffer[i] < -1.0f) {
-                    state->mChannelBuffer[i] = -1.0f;
-                }
-            }
-
-            set_radio_effects(rxIter);
-            mRadioState[rxIter].vhfFilter->transformFrame(state->mChannelBuffer,
-                                                          state->mChannelBuffer);
-            mRadioState[rxIter].simpleCompressorEffect.transformFrame(state->mChannelBuffer,
-                                                                      state->mChannelBuffer);
-            if (!mix_effect(mRadioState[rxIter].Crackle,
-                            crackleGain * mRadioState[rxIter].Gain, state)) {
-                mRadioState[rxIter].Crackle.reset();
-            }
-            if (!mix_effect(mRadioState[rxIter].HfWhiteNoise,
-                            hfGain * mRadioState[rxIter].Gain, state)) {
-                mRadioState[rxIter].HfWhiteNoise.reset();
-            }
-            if (!mix_effect(mRadioState[rxIter].VhfWhiteNoise,
-                            vhfGain * mRadioState[rxIter].Gain, state)) {
-                mRadioState[rxIter].VhfWhiteNoise.reset();
-            }
-            if (!mix_effect(mRadioState[rxIter].AcBus,
-                            acBusGain * mRadioState[rxIter].Gain, state)) {
-                mRadioState[rxIter].AcBus.reset();
-            }
-        } // bypass effects
-        if (concurrentStreams > 1) {
-            if (!mRadioState[rxIter].BlockTone) {
-                mRadioState[rxIter].BlockTone = std::make_shared<audio::SineToneSource>(fxBlockToneFreq);
-            }
-            if (!mix_effect(mRadioState[rxIter].BlockTone,
-                            fxBlockToneGain * mRadioState[rxIter].Gain, state)) {
-                mRadioState[rxIter].BlockTone.reset();
-            }
-        } else {
-            if (mRadioState[rxIter].BlockTone) {
-                mRadioState[rxIter].BlockTone.reset();
-            }
-        }
-    } else {
-        resetRadioFx(rxIter, true);
-        if (mRadioState[rxIter].mLastRxCount > 0) {
-            mRadioState[rxIter].Click =
-                std::make_shared<audio::RecordedSampleSource>(mResources->mClick, false);
-
-            mRadioState[rxIter].liveTransmittingCallsigns = {}; // We know for sure nobody is transmitting anymore
-            ClientEventCallback->invokeAll(ClientEventType::FrequencyRxEnd, &rxIter, nullptr);
-            mRadioState[rxIter].lastVoiceTime = 0;
-            LOG("ATCRadioSimulation", "FrequencyRxEnd event: %i", rxIter);
-        }
-    }
-
-    mRadioState[rxIter].mLastRxCount = concurrentStreams;
-
-    // if we have a pending click, play it.
-    if (!mix_effect(mRadioState[rxIter].Click, fxClickGain * mRadioState[rxIter].Gain, state)) {
-        mRadioState[rxIter].Click.reset();
-    }
-
-    // now, finally, mix the channel buffer into the mixing buffer.
-    if (onHeadset) {
-        if (!ignoreaudio) {
-            if (mRadioState[rxIter].playbackChannel == PlaybackChannel::Left ||
-                mRadioState[rxIter].playbackChannel == PlaybackChannel::Both) {
-                mix_buffers(state->mLeftMixingBuffer, state->mChannelBuffer);
-            }
-
-            if (mRadioState[rxIter].playbackChannel == PlaybackChannel::Right ||
-                mRadioState[rxIter].playbackChannel == PlaybackChannel::Both) {
-                mix_buffers(state->mRightMixingBuffer, state->mChannelBuffer);
-            }
-        }
-
-    } else {
-        if (!ignoreaudio) {
-            mix_buffers(state->mMixingBuffer, state->mChannelBuffer);
-        }
-    }
-
-    return false;
+    mRenderEventTimer.enable(renderEventIntervalMs);
 }
 
-audio::SourceStatus ATCRadioSimulation::getAudioFrame(audio::SampleType *bufferOut, bool onHeadset) {
-    std::shared_ptr<OutputDeviceState> state = onHeadset ? mHeadsetState : mSpeakerState;
-
-    std::lock_guard<std::mutex> streamGuard(mStreamMapLock);
-
-    std::map<void *, audio::SampleType[audio::frameSizeSamples]> sampleCache;
-    for (auto &src: (onHeadset ? mHeadsetIncomingStreams : mSpeakerIncomingStreams)) {
-        if (src.second.source && src.second.source->isActive() &&
-            (sampleCache.find(src.second.source.get()) == sampleCache.end())) {
-            const auto rv =
-                src.second.source->getAudioFrame(sampleCache[src.second.source.get()]);
-            if (rv != audio::SourceStatus::OK) {
-                sampleCache.erase(src.second.source.get());
-            }
-        }
-    }
-
-    ::memset(state->mLeftMixingBuffer, 0, sizeof(audio::SampleType) * audio::frameSizeSamples);
-    ::memset(state->mRightMixingBuffer, 0, sizeof(audio::SampleType) * audio::frameSizeSamples);
-    ::memset(state->mMixingBuffer, 0, sizeof(audio::SampleType) * audio::frameSizeSamples);
-
+void ATCRadioSimulation::handle_rx_transition(unsigned int freq, bool rxBegin) {
     {
         std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-        for (auto &[freq, radio]: mRadioState) {
-            if (radio.onHeadset == onHeadset) {
-                _process_radio(sampleCache, freq, onHeadset);
-            }
+        AtcRadioState              *state = mRadios.find(freq);
+        if (state == nullptr) {
+            return;
+        }
+        // We know for sure nobody is transmitting yet/anymore
+        state->liveTransmittingCallsigns = {};
+        if (!rxBegin) {
+            state->voiceTimeout.cancel();
         }
     }
-
-    if (onHeadset) {
-        audio::SampleType interleavedSamples[audio::frameSizeSamples * 2];
-        interleave(state->mLeftMixingBuffer, state->mRightMixingBuffer, interleavedSamples, audio::frameSizeSamples);
-        ::memcpy(bufferOut, interleavedSamples, sizeof(audio::SampleType) * audio::frameSizeSamples * 2);
+    if (rxBegin) {
+        ClientEventCallback->invokeAll(ClientEventType::FrequencyRxBegin, &freq, nullptr);
+        LOG("ATCRadioSimulation", "FrequencyRxBegin event: %i", freq);
     } else {
-        ::memcpy(bufferOut, state->mMixingBuffer, sizeof(audio::SampleType) * audio::frameSizeSamples);
+        ClientEventCallback->invokeAll(ClientEventType::FrequencyRxEnd, &freq, nullptr);
+        LOG("ATCRadioSimulation", "FrequencyRxEnd event: %i", freq);
     }
-
-    return audio::SourceStatus::OK;
 }
 
-void ATCRadioSimulation::set_radio_effects(unsigned int rxIter) {
-    if (!mRadioState[rxIter].VhfWhiteNoise) {
-        mRadioState[rxIter].VhfWhiteNoise =
-            std::make_shared<audio::RecordedSampleSource>(mResources->mVhfWhiteNoise, true);
-    }
-    if (!mRadioState[rxIter].HfWhiteNoise) {
-        mRadioState[rxIter].HfWhiteNoise =
-            std::make_shared<audio::RecordedSampleSource>(mResources->mHfWhiteNoise, true);
-    }
-    if (!mRadioState[rxIter].Crackle) {
-        mRadioState[rxIter].Crackle =
-            std::make_shared<audio::RecordedSampleSource>(mResources->mCrackle, true);
-    }
-    if (!mRadioState[rxIter].AcBus) {
-        mRadioState[rxIter].AcBus =
-            std::make_shared<audio::RecordedSampleSource>(mResources->mAcBus, true);
-    }
-    if (!mRadioState[rxIter].vhfFilter) {
-        mRadioState[rxIter].vhfFilter =
-            std::make_shared<audio::VHFFilterSource>(mRadioState[rxIter].simulatedHardware);
-    }
+audio::SourceStatus ATCRadioSimulation::getAudioFrame(audio::SampleType *bufferOut, bool onHeadset) {
+    return render_bus(onHeadset ? BusHeadset : BusSpeaker, bufferOut, audio::frameSizeSamples);
 }
 
-bool ATCRadioSimulation::mix_effect(std::shared_ptr<audio::ISampleSource> effect, float gain, std::shared_ptr<OutputDeviceState> state) {
-    if (effect && gain > 0.0f) {
-        auto rv = effect->getAudioFrame(state->mFetchBuffer);
-        if (rv == audio::SourceStatus::OK) {
-            ATCRadioSimulation::mix_buffers(state->mChannelBuffer, state->mFetchBuffer, gain);
-        } else {
-            return false;
-        }
-    }
-    return true;
+audio::SourceStatus ATCRadioSimulation::getAudioSamples(audio::SampleType *bufferOut, size_t numSamples, bool onHeadset) {
+    return render_bus(onHeadset ? BusHeadset : BusSpeaker, bufferOut, numSamples);
 }
 
 bool ATCRadioSimulation::_packetListening(const afv::dto::AudioRxOnTransceivers &pkt) {
-    std::lock_guard<std::mutex> radioStateLock(mRadioStateLock);
-    for (auto trans: pkt.Transceivers) {
-        if (!isFrequencyActive(trans.Frequency)) {
-            continue;
-        }
-
-        if (!mRadioState[trans.Frequency].rx) {
-            continue;
-        }
-
-        mRadioState[trans.Frequency].lastTransmitCallsign = pkt.Callsign;
-        mRadioState[trans.Frequency].lastVoiceTime        = time(0);
-
-        if (pkt.LastPacket) {
-            bool hasBeenDeleted = afv_native::util::removeIfExists(
-                pkt.Callsign, mRadioState[trans.Frequency].liveTransmittingCallsigns);
-            if (hasBeenDeleted) {
-                // There is a risk that the pointer to lastTransmitCallsign might already change
-                // or be invalid by the event handler receives it, needs to be checked in real conditions
-                ClientEventCallback->invokeAll(
-                    ClientEventType::StationRxEnd, &trans.Frequency,
-                    (void *) mRadioState[trans.Frequency].lastTransmitCallsign.c_str());
-                LOG("ATCRadioSimulation", "StationRxEnd event: %i: %s", trans.Frequency,
-                    mRadioState[trans.Frequency].lastTransmitCallsign.c_str());
+    bool            listening    = false;
+    bool            stationEvent = false;
+    ClientEventType eventType    = ClientEventType::StationRxBegin;
+    unsigned int    eventFreq    = 0;
+    {
+        const util::monotime_t      now = util::monotime_get();
+        std::lock_guard<std::mutex> radioStateLock(mRadioStateLock);
+        for (const auto &trans: pkt.Transceivers) {
+            AtcRadioState *state = mRadios.find(trans.Frequency);
+            if (state == nullptr || !state->rx) {
+                continue;
             }
-        } else {
-            if (!afv_native::util::vectorContains(pkt.Callsign,
-                                                  mRadioState[trans.Frequency].liveTransmittingCallsigns)) {
-                LOG("ATCRadioSimulation", "StationRxBegin event: %i: %s", trans.Frequency,
-                    mRadioState[trans.Frequency].lastTransmitCallsign.c_str());
 
-                // Need to emit that we have a new pilot that started transmitting
-                ClientEventCallback->invokeAll(
-                    ClientEventType::StationRxBegin, &trans.Frequency,
-                    (void *) mRadioState[trans.Frequency].lastTransmitCallsign.c_str());
+            state->lastTransmitCallsign = pkt.Callsign;
+            mVoiceTimeouts.schedule(state->voiceTimeout, now + voiceTimeoutIntervalMs);
 
-                mRadioState[trans.Frequency].liveTransmittingCallsigns.emplace_back(pkt.Callsign);
+            if (pkt.LastPacket) {
+                stationEvent = afv_native::util::removeIfExists(pkt.Callsign, state->liveTransmittingCallsigns);
+                eventType = ClientEventType::StationRxEnd;
+            } else if (!afv_native::util::vectorContains(pkt.Callsign, state->liveTransmittingCallsigns)) {
+                // Need to emit that we have a new pilot that started transmitting
+                state->liveTransmittingCallsigns.emplace_back(pkt.Callsign);
+                stationEvent = true;
+                eventType    = ClientEventType::StationRxBegin;
             }
+            eventFreq = trans.Frequency;
+            listening = true;
+            break;
         }
+    }
 
-        return true;
+    // notify outside of the lock so slow handlers can't hold up the rest of the client.  The
+    // packet outlives the callbacks, so its callsign is safe to hand out.
+    if (stationEvent) {
+        ClientEventCallback->invokeAll(eventType, &eventFreq, (void *) pkt.Callsign.c_str());
+        LOG("ATCRadioSimulation", "%s event: %i: %s",
+            eventType == ClientEventType::StationRxBegin ? "StationRxBegin" : "StationRxEnd",
+            eventFreq, pkt.Callsign.c_str());
     }
 
-    return false;
+    return listening;
 }
 
 void ATCRadioSimulation::rxVoicePacket(const afv::dto::AudioRxOnTransceivers &pkt) {
     // FIXME:  Deal with the case of a single-callsign transmitting multiple different voicestreams simultaneously.
     if (_packetListening(pkt)) {
-        std::lock_guard<std::mutex> streamMapLock(mStreamMapLock);
-        mHeadsetIncomingStreams[pkt.Callsign].source->appendAudioDTO(pkt);
-        mHeadsetIncomingStreams[pkt.Callsign].transceivers = pkt.Transceivers;
-
-        mSpeakerIncomingStreams[pkt.Callsign].source->appendAudioDTO(pkt);
-        mSpeakerIncomingStreams[pkt.Callsign].transceivers = pkt.Transceivers;
+        ingest_packet(pkt);
     }
 }
 
@@ -527,37 +330,53 @@ bool ATCRadioSimulation::addFrequency(unsigned int radio, bool onHeadset, std::s
         LOG("ATCRadioSimulation", "addFrequency overriding unused: %i", radio);
     }
 
-    mRadioState[radio] = AtcRadioState();
+    AtcRadioState &state = mRadios.add(radio);
+    state.dsp            = make_radio_dsp(hardware);
 
-    mRadioState[radio].Frequency         = radio;
-    mRadioState[radio].onHeadset         = onHeadset;
-    mRadioState[radio].playbackChannel   = channel;
-    mRadioState[radio].stationName       = stationName;
-    mRadioState[radio].simulatedHardware = hardware;
-    mRadioState[radio].mBypassEffects    = mDefaultBypassEffects;
-    mRadioState[radio].mHfSquelch        = mDefaultEnableHfSquelch;
+    state.onHeadset         = onHeadset;
+    state.playbackChannel   = channel;
+    state.stationName       = stationName;
+    state.simulatedHardware = hardware;
+    state.mBypassEffects    = mDefaultBypassEffects;
+    state.mHfSquelch        = mDefaultEnableHfSquelch;
 
     if (stationName.find("_ATIS") != std::string::npos) {
-        mRadioState[radio].isATIS = true;
+        state.isATIS = true;
     }
-    // reset all of the effects, except the click which should be audiable due to the Squelch-gate kicking in on the new frequency
-    resetRadioFx(radio, true);
+    // the new state brings its own, freshly reset, effects.
+    publish_radio_config();
     LOG("ATCRadioSimulation", "addFrequency: %s: %i", stationName.c_str(), radio);
 
     return true;
 }
 
-void ATCRadioSimulation::resetRadioFx(unsigned int radio, bool except_click) {
-    if (!except_click) {
-        mRadioState[radio].Click.reset();
-        mRadioState[radio].mLastRxCount = 0;
-    }
-    mRadioState[radio].BlockTone.reset();
-    mRadioState[radio].Crackle.reset();
-    mRadioState[radio].VhfWhiteNoise.reset();
-    mRadioState[radio].HfWhiteNoise.reset();
-    mRadioState[radio].AcBus.reset();
-    mRadioState[radio].vhfFilter.reset();
+void ATCRadioSimulation::publish_radio_config() {
+    auto snapshot = std::make_unique<RenderConfigSnapshot>();
+    snapshot->radios.reserve(mRadios.size());
+    snapshot->dspOwners.reserve(mRadios.size());
+    mRadios.forEach([&snapshot](const AtcRadioState &radio) {
+        // the speaker is mono, so the playback channel only applies on the headset.
+        float leftGain  = 1.0f;
+        float rightGain = 0.0f;
+        if (radio.onHeadset) {
+            leftGain  = radio.playbackChannel != PlaybackChannel::Right ? 1.0f : 0.0f;
+            rightGain = radio.playbackChannel != PlaybackChannel::Left ? 1.0f : 0.0f;
+        }
+        snapshot->radios.push_back({radio.dsp.get(), radio.Frequency, radio.Gain, leftGain, rightGain,
+                                    radio.onHeadset ? BusHeadset : BusSpeaker, radio.mBypassEffects,
+                                    radio.mHfSquelch, radio.tx});
+        snapshot->dspOwners.push_back(radio.dsp);
+        if (radio.rx) {
+            snapshot->rxFrequencies.push_back(radio.Frequency);
+        }
+        if (radio.tx) {
+            for (const auto &trans: radio.transceivers) {
+                snapshot->txTransceiverIDs.push_back(trans.ID);
+            }
+        }
+    });
+    std::sort(snapshot->rxFrequencies.begin(), snapshot->rxFrequencies.end());
+    mRadioConfig.publish(std::move(snapshot));
 }
 
 void ATCRadioSimulation::setPtt(bool pressed) {
@@ -566,7 +385,13 @@ void ATCRadioSimulation::setPtt(bool pressed) {
 
 void ATCRadioSimulation::setGain(unsigned int radio, float gain) {
     std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-    mRadioState[radio].Gain = gain;
+    AtcRadioState              *state = mRadios.find(radio);
+    if (state == nullptr) {
+        LOG("ATCRadioSimulation", "setGain failed, frequency inactive: %i", radio);
+        return;
+    }
+    state->Gain = gain;
+    publish_radio_config();
     LOG("ATCRadioSimulation", "setGain: %i: %f", radio, gain);
 }
 
@@ -615,58 +440,31 @@ void ATCRadioSimulation::setUDPChannel(cryptodto::UDPChannel *newChannel) {
 
 void ATCRadioSimulation::maintainVoiceTimeout() {
     std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-    std::map<unsigned int, AtcRadioState>::iterator it;
-
-    for (it = mRadioState.begin(); it != mRadioState.end(); it++) {
-        if (it->second.lastVoiceTime == 0) {
-            continue;
+    mVoiceTimeouts.advance(util::monotime_get(), [this](util::TimerWheel<unsigned int>::Timer &timer) {
+        AtcRadioState *state = mRadios.find(timer.key);
+        if (state == nullptr) {
+            return;
         }
-        LOG("ATCRadioSimulation", "Potential VoiceTimeout.. %i %i", it->second.lastVoiceTime,
-            time(0) - it->second.lastVoiceTime);
-
-        if (time(0) - it->second.lastVoiceTime >= voiceTimeoutIntervalS) {
-            LOG("ATCRadioSimulation", "Found VoiceTimeout.. %i", it->second.Frequency);
-            // Voice channel rx has timed out.. update things.
-            it->second.lastVoiceTime = 0;
-            for (const auto &c: it->second.liveTransmittingCallsigns) {
-                ClientEventCallback->invokeAll(ClientEventType::StationRxEnd,
-                                               &it->second.Frequency, (void *) c.c_str());
-                LOG("ATCRadioSimulation", "StationRxEnd TIMEOUT event: %i: %s",
-                    it->second.Frequency, c.c_str());
-            }
-
-            ClientEventCallback->invokeAll(ClientEventType::FrequencyRxEnd,
-                                           &it->second.Frequency, nullptr);
-            LOG("ATCRadioSimulation", "FrequencyRxEnd TIMEOUT event: %i",
-                it->second.Frequency);
+        // Voice channel rx has timed out.. update things.
+        LOG("ATCRadioSimulation", "Found VoiceTimeout.. %i", state->Frequency);
+        for (const auto &c: state->liveTransmittingCallsigns) {
+            ClientEventCallback->invokeAll(ClientEventType::StationRxEnd, &state->Frequency, (void *) c.c_str());
+            LOG("ATCRadioSimulation", "StationRxEnd TIMEOUT event: %i: %s", state->Frequency, c.c_str());
         }
-    }
 
-    mVoiceTimeoutTimer.enable(voiceTimeoutIntervalMs);
+        ClientEventCallback->invokeAll(ClientEventType::FrequencyRxEnd, &state->Frequency, nullptr);
+        LOG("ATCRadioSimulation", "FrequencyRxEnd TIMEOUT event: %i", state->Frequency);
+    });
+
+    mVoiceTimeoutTimer.enable(expiryTickMs);
 }
 
 void ATCRadioSimulation::maintainIncomingStreams() {
-    std::lock_guard<std::mutex> ml(mStreamMapLock);
-    std::vector<std::string>    callsignsToPurge;
-    std::vector<std::string>    speakerCallsignsToPurge;
-    util::monotime_t            now = util::monotime_get();
-    for (const auto &streamPair: mHeadsetIncomingStreams) {
-        if ((now - streamPair.second.source->getLastActivityTime()) > audio::compressedSourceCacheTimeoutMs) {
-            callsignsToPurge.emplace_back(streamPair.first);
-        }
-    }
-    for (const auto &streamPair: mSpeakerIncomingStreams) {
-        if ((now - streamPair.second.source->getLastActivityTime()) > audio::compressedSourceCacheTimeoutMs) {
-            speakerCallsignsToPurge.emplace_back(streamPair.first);
-        }
+    expire_streams();
+    if (mFecPacketLoss.load() < 0) {
+        mVoiceSink->setPacketLoss(static_cast<int>(getMeasuredPacketLoss()));
     }
-    for (const auto &callsign: callsignsToPurge) {
-        mHeadsetIncomingStreams.erase(callsign);
-    }
-    for (const auto &callsign: speakerCallsignsToPurge) {
-        mSpeakerIncomingStreams.erase(callsign);
-    }
-    mMaintenanceTimer.enable(maintenanceTimerIntervalMs);
+    mMaintenanceTimer.enable(expiryTickMs);
 }
 
 void ATCRadioSimulation::setCallsign(const std::string &newCallsign) {
@@ -682,14 +480,11 @@ void ATCRadioSimulation::setClientPosition(double lat, double lon, double amslm,
 }
 
 void ATCRadioSimulation::reset() {
-    {
-        std::lock_guard<std::mutex> ml(mStreamMapLock);
-        mHeadsetIncomingStreams.clear();
-        mSpeakerIncomingStreams.clear();
-    }
+    reset_streams();
     {
         std::lock_guard<std::mutex> ml(mRadioStateLock);
-        mRadioState.clear();
+        mRadios.clear();
+        publish_radio_config();
     }
     mTxSequence.store(0);
     mPtt.store(false);
@@ -723,19 +518,59 @@ void ATCRadioSimulation::setEnableInputFilters(bool enableInputFilters) {
 
 void ATCRadioSimulation::setEnableOutputEffects(bool enableEffects) {
     std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-    for (auto &[_, thisRadio]: mRadioState) {
+    mRadios.forEach([enableEffects](AtcRadioState &thisRadio) {
         thisRadio.mBypassEffects = !enableEffects;
-    }
+    });
     mDefaultBypassEffects = !enableEffects;
+    publish_radio_config();
     LOG("ATCRadioSimulation", "setEnableOutputEffects: %i", enableEffects);
 }
 
+void ATCRadioSimulation::setReducedRateDsp(bool reduced) {
+    if (!set_reduced_rate(reduced)) {
+        return;
+    }
+    std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
+    mRadios.forEach([this](AtcRadioState &thisRadio) {
+        thisRadio.dsp = make_radio_dsp(thisRadio.simulatedHardware);
+    });
+    publish_radio_config();
+    LOG("ATCRadioSimulation", "setReducedRateDsp: %i", reduced);
+}
+
+void ATCRadioSimulation::setFecPacketLoss(int percent) {
+    mFecPacketLoss.store(percent);
+    setMeasurePacketLoss(percent < 0);
+    mVoiceSink->setPacketLoss(percent < 0 ? static_cast<int>(getMeasuredPacketLoss()) : percent);
+    LOG("ATCRadioSimulation", "setFecPacketLoss: %i", percent);
+}
+
+void ATCRadioSimulation::setEncoderProfile(const EncoderProfile &profile) {
+    mVoiceSink->setProfile(profile);
+    LOG("ATCRadioSimulation", "setEncoderProfile: %d bps, complexity %d, %s, dtx %i, signal %d, max bandwidth %d",
+        profile.bitrate, profile.complexity, profile.vbr ? "vbr" : "cbr", profile.dtx, profile.signal, profile.maxBandwidth);
+}
+
+bool ATCRadioSimulation::setRenderQuantum(size_t quantum) {
+    if (!set_render_quantum(quantum)) {
+        return getRenderQuantum() == quantum;
+    }
+    std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
+    mRadios.forEach([this](AtcRadioState &thisRadio) {
+        thisRadio.dsp = make_radio_dsp(thisRadio.simulatedHardware);
+    });
+    publish_radio_config();
+    LOG("ATCRadioSimulation", "setRenderQuantum: %zu", quantum);
+    return true;
+}
+
 void ATCRadioSimulation::setEnableHfSquelch(bool enableSquelch) {
     std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-    for (auto &[_, thisRadio]: mRadioState) {
+    mRadios.forEach([enableSquelch](AtcRadioState &thisRadio) {
         thisRadio.mHfSquelch = enableSquelch;
-    }
+    });
     mDefaultEnableHfSquelch = enableSquelch;
+    publish_radio_config();
     LOG("ATCRadioSimulation", "setEnableHfSquelch: %i", enableSquelch);
 }
 
@@ -743,24 +578,24 @@ void ATCRadioSimulation::setupDevices(util::ChainedCallback<void(ClientEventType
     mHeadsetDevice = std::make_shared<AtcOutputAudioDevice>(shared_from_this(), true);
     mSpeakerDevice = std::make_shared<AtcOutputAudioDevice>(shared_from_this(), false);
 
-    mHeadsetState = std::make_shared<OutputDeviceState>();
-    mSpeakerState = std::make_shared<OutputDeviceState>();
-
     ClientEventCallback = eventCallback;
 }
 
 void ATCRadioSimulation::setOnHeadset(unsigned int radio, bool onHeadset) {
     std::lock_guard<std::mutex> mRadioStateGuard(mRadioStateLock);
-    if (!isFrequencyActive(radio)) {
+    AtcRadioState              *state = mRadios.find(radio);
+    if (state == nullptr) {
         LOG("ATCRadioSimulation", "setOnHeadset failed, frequency inactive: %i", radio);
         return;
     }
-    mRadioState[radio].onHeadset = onHeadset;
+    state->onHeadset = onHeadset;
+    publish_radio_config();
 }
 
 void afv_native::afv::ATCRadioSimulation::setRx(unsigned int freq, bool rx) {
     std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-    if (!isFrequencyActive(freq)) {
+    AtcRadioState              *state = mRadios.find(freq);
+    if (state == nullptr) {
         LOG("ATCRadioSimulation", "setRxRadio failed, frequency inactive: %i", freq);
         return;
     }
@@ -768,77 +603,84 @@ void afv_native::afv::ATCRadioSimulation::setRx(unsigned int freq, bool rx) {
         // Emit client callback for the end of station transmission
         ClientEventCallback->invokeAll(ClientEventType::FrequencyRxEnd, &freq, nullptr);
         LOG("ATCRadioSimulation", "FrequencyRxEnd event: %i", freq);
-        for (auto callsign: mRadioState[freq].liveTransmittingCallsigns) {
+        for (const auto &callsign: state->liveTransmittingCallsigns) {
             ClientEventCallback->invokeAll(ClientEventType::StationRxEnd, &freq,
                                            (void *) callsign.c_str());
             LOG("ATCRadioSimulation", "SetRx false StationRxEnd event: %i: %s", freq,
                 callsign.c_str());
         }
-        mRadioState[freq].liveTransmittingCallsigns = {};
-        mRadioState[freq].lastVoiceTime             = 0;
+        state->liveTransmittingCallsigns = {};
+        state->voiceTimeout.cancel();
     }
-    mRadioState[freq].rx = rx;
+    state->rx = rx;
+    publish_radio_config();
     LOG("ATCRadioSimulation", "setRxRadio: %i", freq);
 }
 
 void afv_native::afv::ATCRadioSimulation::setTx(unsigned int freq, bool tx) {
     std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-    if (!isFrequencyActive(freq)) {
+    AtcRadioState              *state = mRadios.find(freq);
+    if (state == nullptr) {
         LOG("ATCRadioSimulation", "setTxRadio failed, frequency inactive: %i", freq);
         return;
     }
-    mRadioState[freq].tx = tx;
+    state->tx = tx;
+    publish_radio_config();
     LOG("ATCRadioSimulation", "setTxRadio: %i", freq);
 };
 
 void afv_native::afv::ATCRadioSimulation::setXc(unsigned int freq, bool xc) {
     std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-    if (!isFrequencyActive(freq)) {
+    AtcRadioState              *state = mRadios.find(freq);
+    if (state == nullptr) {
         LOG("ATCRadioSimulation", "setXcRadio failed, frequency inactive: %i", freq);
         return;
     }
-    mRadioState[freq].xc = xc;
+    state->xc = xc;
     LOG("ATCRadioSimulation", "setXcRadio: %i", freq);
 };
 
 void afv_native::afv::ATCRadioSimulation::setCrossCoupleAcross(unsigned int freq, bool crossCoupleAcross) {
     std::lock_guard<std::mutex> lock(mRadioStateLock);
-    if (!isFrequencyActive(freq)) {
+    AtcRadioState              *state = mRadios.find(freq);
+    if (state == nullptr) {
         LOG("ATCRadioSimulation", "setXcRadio failed, frequency inactive: %i", freq);
         return;
     }
-    mRadioState[freq].xc                = crossCoupleAcross;
-    mRadioState[freq].crossCoupleAcross = crossCoupleAcross;
+    state->xc                = crossCoupleAcross;
+    state->crossCoupleAcross = crossCoupleAcross;
     if (crossCoupleAcross) {
-        mRadioState[freq].xc = false;
+        state->xc = false;
     }
     LOG("ATCRadioSimulation", "setXcRadio: %i", freq);
 }
 
 bool afv_native::afv::ATCRadioSimulation::getCrossCoupleAcrossState(unsigned int freq) {
     std::lock_guard<std::mutex> lock(mRadioStateLock);
-    return mRadioState.count(freq) != 0 ? mRadioState[freq].crossCoupleAcross : false;
+    const AtcRadioState        *state = mRadios.find(freq);
+    return state != nullptr ? state->crossCoupleAcross : false;
 }
 
 void afv_native::afv::ATCRadioSimulation::setGainAll(float gain) {
     std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-    for (auto &[_, radio]: mRadioState) {
+    mRadios.forEach([gain](AtcRadioState &radio) {
         radio.Gain = gain;
-    }
+    });
+    publish_radio_config();
     LOG("ATCRadioSimulation", "setGainAll: %f", gain);
 }
 
 bool afv_native::afv::ATCRadioSimulation::isFrequencyActive(unsigned int freq) {
-    return mRadioState.count(freq) != 0;
+    return mRadios.find(freq) != nullptr;
 };
 
 bool afv_native::afv::ATCRadioSimulation::isFrequencyActiveButUnused(unsigned int freq) {
-    if (!isFrequencyActive(freq)) {
+    const AtcRadioState *state = mRadios.find(freq);
+    if (state == nullptr) {
         return false;
     }
 
-    if (mRadioState[freq].tx == false && mRadioState[freq].rx == false &&
-        mRadioState[freq].xc == false) {
+    if (state->tx == false && state->rx == false && state->xc == false) {
         return true;
     }
 
@@ -851,46 +693,50 @@ void ATCRadioSimulation::setTransceivers(unsigned int freq, std::vector<afv::dto
     // the Radio State Object
 
     std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-    if (!isFrequencyActive(freq)) {
+    AtcRadioState              *state = mRadios.find(freq);
+    if (state == nullptr) {
         LOG("ATCRadioSimulation", "setTransceivers failed, frequency inactive: %i", freq);
         return;
     }
-    mRadioState[freq].transceivers.clear();
+    state->transceivers.clear();
 
-    for (auto inTrans: transceivers) {
+    for (const auto &inTrans: transceivers) {
         // Transceiver IDs all set to 0 here, they will be updated when
         // coalesced into the global transceiver package
         dto::Transceiver out(0, freq, inTrans.LatDeg, inTrans.LonDeg, inTrans.HeightMslM,
                              inTrans.HeightAglM);
-        mRadioState[freq].transceivers.emplace_back(out);
+        state->transceivers.emplace_back(out);
     }
+    publish_radio_config();
 }
 
 std::vector<afv::dto::Transceiver> ATCRadioSimulation::makeTransceiverDto() {
     std::lock_guard<std::mutex>        radioStateGuard(mRadioStateLock);
     std::vector<afv::dto::Transceiver> retSet;
     unsigned int                       i = 0;
-    for (auto &state: mRadioState) {
-        if (!state.second.rx) {
-            continue;
+    mRadios.forEach([&](AtcRadioState &state) {
+        if (!state.rx) {
+            return;
         }
 
-        if (state.second.transceivers.empty()) {
+        if (state.transceivers.empty()) {
             // If there are no transceivers received from the network, we're
             // using the client position
-            retSet.emplace_back(i, state.first, mClientLatitude, mClientLongitude, mClientAltitudeMSLM, mClientAltitudeGLM);
+            retSet.emplace_back(i, state.Frequency, mClientLatitude, mClientLongitude, mClientAltitudeMSLM, mClientAltitudeGLM);
             // Update the radioStack with the added transponder
-            state.second.transceivers = {retSet.back()};
+            state.transceivers = {retSet.back()};
             i++;
         } else {
-            for (auto &trans: state.second.transceivers) {
+            for (auto &trans: state.transceivers) {
                 retSet.emplace_back(i, trans.Frequency, trans.LatDeg, trans.LonDeg,
                                     trans.HeightMslM, trans.HeightAglM);
                 trans.ID = i;
                 i++;
             }
         }
-    }
+    });
+    // the transceiver IDs have just been (re)assigned.
+    publish_radio_config();
     return std::move(retSet);
 }
 
@@ -899,20 +745,20 @@ std::vector<afv::dto::CrossCoupleGroup> ATCRadioSimulation::makeCrossCoupleGroup
     std::vector<afv::dto::CrossCoupleGroup> out   = {{0, {}}};
     unsigned int                            index = 1;
 
-    for (auto &[frequency, radio]: mRadioState) {
+    mRadios.forEach([&](const AtcRadioState &radio) {
         if (!radio.xc && !radio.crossCoupleAcross) {
-            continue;
+            return;
         }
         // There are transceivers and they need to be coupled
 
         if (!radio.tx || !radio.rx) {
             // If the radio is not transmitting or receiving, we don't need to couple it
-            continue;
+            return;
         }
 
         if (radio.transceivers.empty()) {
             // If there are no transceivers, we don't need to couple it
-            continue;
+            return;
         }
 
         if (radio.crossCoupleAcross) {
@@ -931,7 +777,7 @@ std::vector<afv::dto::CrossCoupleGroup> ATCRadioSimulation::makeCrossCoupleGroup
             out.push_back(group);
             index++;
         }
-    }
+    });
 
     return std::move(out);
 }
@@ -942,7 +788,8 @@ void afv_native::afv::ATCRadioSimulation::setTick(std::shared_ptr<audio::ITick>
 
 std::string afv_native::afv::ATCRadioSimulation::getLastTransmitOnFreq(unsigned int freq) {
     std::lock_guard<std::mutex> mRadioStateGuard(mRadioStateLock);
-    return mRadioState[freq].lastTransmitCallsign;
+    const AtcRadioState        *state = mRadios.find(freq);
+    return state != nullptr ? state->lastTransmitCallsign : "";
 }
 
 void afv_native::afv::ATCRadioSimulation::stationTransceiverUpdateCallback(const std::string &stationName, std::map<std::string, std::vector<afv::dto::StationTransceiver>> transceivers) {
@@ -950,85 +797,98 @@ void afv_native::afv::ATCRadioSimulation::stationTransceiverUpdateCallback(const
         return;
     }
 
-    auto it = std::find_if(mRadioState.begin(), mRadioState.end(), [&stationName](const auto &t) {
-        return t.second.stationName == stationName;
-    });
-    if (it != mRadioState.end()) {
-        setTransceivers(it->second.Frequency, transceivers[stationName]);
+    bool         found = false;
+    unsigned int freq  = 0;
+    {
+        std::lock_guard<std::mutex> mRadioStateGuard(mRadioStateLock);
+        mRadios.forEach([&](const AtcRadioState &radio) {
+            if (!found && radio.stationName == stationName) {
+                found = true;
+                freq  = radio.Frequency;
+            }
+        });
+    }
+    if (found) {
+        setTransceivers(freq, transceivers[stationName]);
     }
 }
 
 bool afv_native::afv::ATCRadioSimulation::getOnHeadset(unsigned int freq) {
     std::lock_guard<std::mutex> mRadioStateGuard(mRadioStateLock);
-    return mRadioState.count(freq) != 0 ? mRadioState[freq].onHeadset : true;
+    const AtcRadioState        *state = mRadios.find(freq);
+    return state != nullptr ? state->onHeadset : true;
 }
 
 void afv_native::afv::ATCRadioSimulation::setPlaybackChannelAll(PlaybackChannel channel) {
     std::lock_guard<std::mutex> mRadioStateGuard(mRadioStateLock);
-    for (auto radio: mRadioState) {
-        mRadioState[radio.first].playbackChannel = channel;
-    }
+    mRadios.forEach([channel](AtcRadioState &radio) {
+        radio.playbackChannel = channel;
+    });
+    publish_radio_config();
 }
 
 void afv_native::afv::ATCRadioSimulation::setPlaybackChannel(unsigned int freq, PlaybackChannel channel) {
     std::lock_guard<std::mutex> mRadioStateGuard(mRadioStateLock);
-    if (!isFrequencyActive(freq)) {
+    AtcRadioState              *state = mRadios.find(freq);
+    if (state == nullptr) {
         LOG("ATCRadioSimulation", "setSplitAudioChannels failed, frequency inactive: %i", freq);
         return;
     }
-    mRadioState[freq].playbackChannel = channel;
+    state->playbackChannel = channel;
+    publish_radio_config();
 }
 
 afv_native::PlaybackChannel afv_native::afv::ATCRadioSimulation::getPlaybackChannel(unsigned int freq) {
     std::lock_guard<std::mutex> mRadioStateGuard(mRadioStateLock);
-    return mRadioState.count(freq) != 0 ? mRadioState[freq].playbackChannel : PlaybackChannel::Both;
+    const AtcRadioState        *state = mRadios.find(freq);
+    return state != nullptr ? state->playbackChannel : PlaybackChannel::Both;
 }
 
 bool afv_native::afv::ATCRadioSimulation::getRxState(unsigned int freq) {
-    return mRadioState.count(freq) != 0 ? mRadioState[freq].rx : false;
+    const AtcRadioState *state = mRadios.find(freq);
+    return state != nullptr ? state->rx : false;
 }
 bool afv_native::afv::ATCRadioSimulation::getTxState(unsigned int freq) {
-    return mRadioState.count(freq) != 0 ? mRadioState[freq].tx : false;
+    const AtcRadioState *state = mRadios.find(freq);
+    return state != nullptr ? state->tx : false;
 }
 
 bool afv_native::afv::ATCRadioSimulation::getXcState(unsigned int freq) {
-    return mRadioState.count(freq) != 0 ? mRadioState[freq].xc : false;
+    const AtcRadioState *state = mRadios.find(freq);
+    return state != nullptr ? state->xc : false;
 }
 
 void afv_native::afv::ATCRadioSimulation::removeFrequency(unsigned int freq) {
     std::lock_guard<std::mutex> mRadioStateGuard(mRadioStateLock);
-    if (!isFrequencyActive(freq)) {
+    AtcRadioState              *state = mRadios.find(freq);
+    if (state == nullptr) {
         LOG("ATCRadioSimulation", "removeFrequency cancelled, frequency does not exist: %i", freq);
         return;
     }
     ClientEventCallback->invokeAll(ClientEventType::FrequencyRxEnd, &freq, nullptr);
     LOG("ATCRadioSimulation", "FrequencyRxEnd event: %i", freq);
-    for (auto callsign: mRadioState[freq].liveTransmittingCallsigns) {
+    for (const auto &callsign: state->liveTransmittingCallsigns) {
         ClientEventCallback->invokeAll(ClientEventType::StationRxEnd, &freq,
                                        (void *) callsign.c_str());
         LOG("ATCRadioSimulation", "removeFrequency StationRxEnd event: %i: %s", freq,
             callsign.c_str());
     }
-    resetRadioFx(freq, false);
-    mRadioState.erase(freq);
+    mRadios.remove(freq);
+    publish_radio_config();
     LOG("ATCRadioSimulation", "removeFrequency: %i", freq);
 }
 
 int afv_native::afv::ATCRadioSimulation::getTransceiverCountForFrequency(unsigned int freq) {
     std::lock_guard<std::mutex> lock(mRadioStateLock);
-    if (isFrequencyActive(freq)) {
-        return mRadioState[freq].transceivers.size();
-    }
-    return 0;
+    const AtcRadioState        *state = mRadios.find(freq);
+    return state != nullptr ? static_cast<int>(state->transceivers.size()) : 0;
 }
 
-void afv_native::afv::ATCRadioSimulation::interleave(audio::SampleType *leftChannel, audio::SampleType *rightChannel, audio::SampleType *outputBuffer, size_t numSamples) {
-    for (size_t i = 0; i < numSamples; i++) {
-        outputBuffer[2 * i] = leftChannel[i]; // Interleave left channel data
-        outputBuffer[2 * i + 1] = rightChannel[i]; // Interleave right channel data
-    }
-}
 std::map<unsigned int, AtcRadioState> afv_native::afv::ATCRadioSimulation::getRadioState() {
-    std::lock_guard<std::mutex> lock(mRadioStateLock);
-    return mRadioState;
+    std::lock_guard<std::mutex>           lock(mRadioStateLock);
+    std::map<unsigned int, AtcRadioState> radios;
+    mRadios.forEach([&radios](const AtcRadioState &radio) {
+        radios.emplace(radio.Frequency, radio);
+    });
+    return radios;
 }
@@ -0,0 +1,124 @@
+#include "afv-native/afv/DecodeWorkers.h"
+#include "afv-native/audio/audio_params.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace afv_native;
+using namespace afv_native::afv;
+
+namespace {
+    /** wake() doesn't take the lock, so a wakeup can be missed - the workers look again after
+     * this long regardless. */
+    const std::chrono::milliseconds wakeTimeout(audio::frameLengthMs);
+} // namespace
+
+DecodeWorkers::DecodeWorkers(unsigned int threads, std::atomic<uint64_t> &framesDecoded, std::atomic<uint64_t> &decodeNs):
+    mFramesDecoded(framesDecoded), mDecodeNs(decodeNs), mSourcesLock(), mSources(), mNextWorker(0), mWakeLock(), mWakeReady(), mStopping(false), mWakes(0), mPasses(new std::atomic<uint64_t>[std::max(threads, 1u)]), mThreads() {
+    threads = std::max(threads, 1u);
+    for (unsigned int i = 0; i < threads; i++) {
+        mPasses[i].store(0);
+    }
+    mThreads.reserve(threads);
+    for (unsigned int i = 0; i < threads; i++) {
+        mThreads.emplace_back(&DecodeWorkers::worker_main, this, i);
+    }
+}
+
+DecodeWorkers::~DecodeWorkers() {
+    stop();
+}
+
+void DecodeWorkers::add(std::shared_ptr<RemoteVoiceSource> source) {
+    std::lock_guard<std::mutex> sourcesGuard(mSourcesLock);
+    const unsigned int          worker = mNextWorker++ % static_cast<unsigned int>(mThreads.size());
+    mSources.push_back({std::move(source), worker});
+}
+
+void DecodeWorkers::remove(const RemoteVoiceSource *source) {
+    std::lock_guard<std::mutex> sourcesGuard(mSourcesLock);
+    auto                        it = std::find_if(mSources.begin(), mSources.end(), [source](const Entry &entry) {
+        return entry.source.get() == source;
+    });
+    if (it != mSources.end()) {
+        std::swap(*it, mSources.back());
+        mSources.pop_back();
+    }
+}
+
+void DecodeWorkers::clear() {
+    std::lock_guard<std::mutex> sourcesGuard(mSourcesLock);
+    mSources.clear();
+}
+
+void DecodeWorkers::wake() {
+    mWakes.fetch_add(1, std::memory_order_release);
+    mWakeReady.notify_all();
+}
+
+void DecodeWorkers::stop() {
+    {
+        std::lock_guard<std::mutex> wakeGuard(mWakeLock);
+        if (mStopping) {
+            return;
+        }
+        mStopping = true;
+    }
+    mWakeReady.notify_all();
+    for (auto &thread: mThreads) {
+        thread.join();
+    }
+}
+
+void DecodeWorkers::waitIdle() const {
+    const uint64_t wakes = mWakes.load(std::memory_order_acquire);
+    for (size_t i = 0; i < mThreads.size(); i++) {
+        while (mPasses[i].load(std::memory_order_acquire) < wakes) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+unsigned int DecodeWorkers::getThreadCount() const {
+    return static_cast<unsigned int>(mThreads.size());
+}
+
+void DecodeWorkers::worker_main(unsigned int worker) {
+    std::vector<std::shared_ptr<RemoteVoiceSource>> mine;
+    uint64_t                                        seenWakes = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> wakeGuard(mWakeLock);
+            mWakeReady.wait_for(wakeGuard, wakeTimeout, [&] {
+                return mStopping || mWakes.load(std::memory_order_acquire) != seenWakes;
+            });
+            if (mStopping) {
+                return;
+            }
+        }
+        seenWakes = mWakes.load(std::memory_order_acquire);
+
+        // take our own references, so a stream going away mid-pass doesn't pull the source
+        // out from under us.
+        {
+            std::lock_guard<std::mutex> sourcesGuard(mSourcesLock);
+            for (const auto &entry: mSources) {
+                if (entry.worker == worker) {
+                    mine.push_back(entry.source);
+                }
+            }
+        }
+        const auto start   = std::chrono::steady_clock::now();
+        uint64_t   decoded = 0;
+        for (const auto &source: mine) {
+            if (source->decodeAhead()) {
+                decoded++;
+            }
+        }
+        mine.clear();
+        if (decoded > 0) {
+            mFramesDecoded.fetch_add(decoded, std::memory_order_relaxed);
+            mDecodeNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+        }
+        mPasses[worker].store(seenWakes, std::memory_order_release);
+    }
+}
@@ -32,6 +32,7 @@
  */
 
 #include "afv-native/afv/EffectResources.h"
+#include "afv-native/audio/DecimatedSampleStorage.h"
 #include "afv-native/audio/WavFile.h"
 #include "afv-native/audio/WavSampleStorage.h"
 
@@ -63,3 +64,18 @@ EffectResources::EffectResources(const string &file_path) {
     mVhfWhiteNoise = try_load(file_path + "/WhiteNoise_f32.wav");
     mHfWhiteNoise  = try_load(file_path + "/HF_WhiteNoise_f32.wav");
 };
+
+static shared_ptr<audio::ISampleStorage> decimate(const shared_ptr<audio::ISampleStorage> &source, unsigned int factor, bool loop) {
+    if (!source) {
+        return nullptr;
+    }
+    return make_shared<audio::DecimatedSampleStorage>(*source, factor, loop);
+}
+
+EffectResources::EffectResources(const EffectResources &source, unsigned int factor) {
+    mClick         = decimate(source.mClick, factor, false);
+    mCrackle       = decimate(source.mCrackle, factor, true);
+    mAcBus         = decimate(source.mAcBus, factor, true);
+    mVhfWhiteNoise = decimate(source.mVhfWhiteNoise, factor, true);
+    mHfWhiteNoise  = decimate(source.mHfWhiteNoise, factor, true);
+}
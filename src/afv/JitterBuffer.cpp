@@ -0,0 +1,261 @@
+#include "afv-native/afv/JitterBuffer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace afv_native;
+using namespace afv_native::afv;
+
+namespace {
+    /** a gap between packets longer than this starts a new transmission as far as the jitter
+     * estimate is concerned */
+    const util::monotime_t transmissionGapMs = 250;
+    /** how much of the worst lateness is kept from one packet to the next - it halves in
+     * about three seconds of speech */
+    const double peakDecay = 0.995;
+    /** lateness up to this is put down to the resolution of the clock, not jitter */
+    const double clockSlackMs = 2.0;
+} // namespace
+
+JitterBuffer::JitterBuffer(unsigned int timeoutFrames, int frameLengthMs):
+    mTimeoutFrames(timeoutFrames), mFrameLengthMs(frameLengthMs) {
+    clear();
+}
+
+void JitterBuffer::put(uint32_t sequence, const unsigned char *data, size_t length, bool lastPacket, util::monotime_t arrivalMs) {
+    const uint64_t seq        = sequence;
+    const bool     restarting = mRestart.load(std::memory_order_acquire);
+    const uint64_t played     = mPlayed.load(std::memory_order_acquire);
+    if (seq < played && !restarting) {
+        if (played - seq <= slotCount) {
+            Late.fetch_add(1, std::memory_order_relaxed);
+            if (seq >= mTransmissionFirst && Lost.load(std::memory_order_relaxed) > 0) {
+                // it was counted lost when playout skipped over it.
+                Lost.fetch_sub(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+        // much too old to be late - the sender has started counting again.
+        mNewest = 0;
+        mHead.store(0, std::memory_order_relaxed);
+        mEnd.store(0, std::memory_order_relaxed);
+        mRestart.store(true, std::memory_order_release);
+        mLastWasFinal = true;
+    }
+    Slot &slot = mSlots[seq % slotCount];
+    if (length > maxPacketBytes || slot.stamp.load(std::memory_order_acquire) == seq + 1) {
+        // not a packet we could decode, or a duplicate.
+        return;
+    }
+
+    // lateness is measured against the packet of the transmission that took the least time to
+    // arrive - the sender's clock doesn't matter, as long as it ticks once a frame.
+    const int64_t transit         = arrivalMs - static_cast<int64_t>(seq) * mFrameLengthMs;
+    const bool    newTransmission = mLastWasFinal || arrivalMs - mLastArrivalMs > transmissionGapMs;
+    if (newTransmission) {
+        mTransmissionFirst = seq;
+        mMinTransitMs      = transit;
+    } else {
+        mMinTransitMs      = std::min(mMinTransitMs, transit);
+        mPeakExcessMs      = std::max(static_cast<double>(transit - mMinTransitMs), mPeakExcessMs * peakDecay);
+        const double frame = std::ceil((mPeakExcessMs - clockSlackMs) / mFrameLengthMs);
+        mTargetFrames.store(static_cast<unsigned int>(std::min(std::max(frame, 0.0), static_cast<double>(maxTargetFrames))), std::memory_order_relaxed);
+    }
+    mLastArrivalMs = arrivalMs;
+    mLastWasFinal  = lastPacket;
+
+    uint64_t stamp = slot.stamp.load(std::memory_order_acquire);
+    if (stamp == busyStamp || !slot.stamp.compare_exchange_strong(stamp, busyStamp, std::memory_order_acquire)) {
+        // playout is taking the packet a whole ring before this one.
+        return;
+    }
+    ::memcpy(slot.data, data, length);
+    slot.length = length;
+    slot.stamp.store(seq + 1, std::memory_order_release);
+    Received.fetch_add(1, std::memory_order_relaxed);
+
+    if (mNewest == 0 || seq >= mNewest) {
+        // after a DTX frame the sender skips silence, so a gap there isn't loss.
+        if (mNewest != 0 && seq > mNewest && !newTransmission && !mNewestWasDtx) {
+            Lost.fetch_add(seq - mNewest, std::memory_order_relaxed);
+        }
+        mNewest       = seq + 1;
+        mNewestWasDtx = length <= dtxPacketBytes;
+        mHead.store(mNewest, std::memory_order_release);
+    } else if (seq >= mTransmissionFirst && Lost.load(std::memory_order_relaxed) > 0) {
+        // it was counted lost when a later packet overtook it.
+        Lost.fetch_sub(1, std::memory_order_relaxed);
+    }
+    if (lastPacket) {
+        mEnd.store(seq + 1, std::memory_order_release);
+    }
+}
+
+JitterBuffer::Result JitterBuffer::get(unsigned char *packetOut, size_t &lengthOut) {
+    if (mRestart.load(std::memory_order_acquire)) {
+        mNext        = 0;
+        mPlayingFrom = 0;
+        mState       = State::Idle;
+        mPlayed.store(0, std::memory_order_relaxed);
+        mRestart.store(false, std::memory_order_release);
+    }
+    const uint64_t     head   = mHead.load(std::memory_order_acquire);
+    const unsigned int target = mTargetFrames.load(std::memory_order_relaxed);
+
+    if (mState == State::Idle) {
+        if (head <= mNext) {
+            return Result::Idle;
+        }
+        mNext        = first_buffered(head);
+        mPlayingFrom = mNext;
+        mPlayed.store(mNext, std::memory_order_release);
+        mWaitedFrames  = 0;
+        mStalledFrames = 0;
+        mPlayedDtx     = false;
+        mState         = State::Waiting;
+    }
+    if (mState == State::Waiting) {
+        // hold the transmission back by the target delay, or until that much of it is here.
+        if (mWaitedFrames < target && head - mNext <= target) {
+            mWaitedFrames++;
+            return Result::Waiting;
+        }
+        mState = State::Playing;
+    }
+
+    const uint64_t end = mEnd.load(std::memory_order_acquire);
+    if (end > mPlayingFrom && mNext >= end) {
+        stop();
+        return Result::Idle;
+    }
+    if (head > mNext + slotCount) {
+        // so far behind that the ring has moved on without us.
+        mNext = first_buffered(head);
+        mPlayed.store(mNext, std::memory_order_release);
+    } else if (head > mNext && head - mNext > target + 1 + maxExcessFrames) {
+        // one frame at a time, so the delay comes down gently.
+        if (take(mNext, packetOut, lengthOut)) {
+            Discarded.fetch_add(1, std::memory_order_relaxed);
+        }
+        advance();
+    }
+
+    if (take(mNext, packetOut, lengthOut)) {
+        mStalledFrames = 0;
+        mPlayedDtx     = lengthOut <= dtxPacketBytes;
+        advance();
+        return Result::Packet;
+    }
+    if (head > mNext) {
+        // something later's here, so this one is lost, or at least too late to wait for.  If
+        // it's the very next packet, its FEC can stand in.
+        mStalledFrames = 0;
+        advance();
+        if (peek(mNext, packetOut, lengthOut)) {
+            Recovered.fetch_add(1, std::memory_order_relaxed);
+            return Result::Recover;
+        }
+        Concealed.fetch_add(1, std::memory_order_relaxed);
+        return Result::Conceal;
+    }
+    // nothing's arrived since - hold here, so whatever turns up next still gets played.
+    if (++mStalledFrames > mTimeoutFrames) {
+        stop();
+        return Result::Idle;
+    }
+    if (mPlayedDtx) {
+        // unless the sender is skipping silence - then keep time with it, so its next packet
+        // plays when it's due rather than adding to the delay.
+        advance();
+    }
+    Concealed.fetch_add(1, std::memory_order_relaxed);
+    return Result::Conceal;
+}
+
+void JitterBuffer::reset() {
+    mNext  = std::max(mNext, mHead.load(std::memory_order_acquire));
+    mState = State::Idle;
+    mPlayed.store(mNext, std::memory_order_release);
+}
+
+void JitterBuffer::clear() {
+    for (auto &slot: mSlots) {
+        slot.stamp.store(0, std::memory_order_relaxed);
+        slot.length = 0;
+    }
+    Received.store(0);
+    Late.store(0);
+    Lost.store(0);
+    Concealed.store(0);
+    Recovered.store(0);
+    Discarded.store(0);
+    mHead.store(0);
+    mEnd.store(0);
+    mPlayed.store(0);
+    mRestart.store(false);
+    mTargetFrames.store(0);
+
+    mNewest            = 0;
+    mTransmissionFirst = 0;
+    mMinTransitMs      = 0;
+    mPeakExcessMs      = 0.0;
+    mLastArrivalMs     = 0;
+    mLastWasFinal      = true;
+    mNewestWasDtx      = false;
+
+    mState         = State::Idle;
+    mNext          = 0;
+    mPlayingFrom   = 0;
+    mWaitedFrames  = 0;
+    mStalledFrames = 0;
+    mPlayedDtx     = false;
+}
+
+unsigned int JitterBuffer::getTargetDelayFrames() const {
+    return mTargetFrames.load(std::memory_order_relaxed);
+}
+
+bool JitterBuffer::take(uint64_t sequence, unsigned char *packetOut, size_t &lengthOut) {
+    Slot    &slot     = mSlots[sequence % slotCount];
+    uint64_t expected = sequence + 1;
+    if (!slot.stamp.compare_exchange_strong(expected, busyStamp, std::memory_order_acquire)) {
+        return false;
+    }
+    ::memcpy(packetOut, slot.data, slot.length);
+    lengthOut = slot.length;
+    slot.stamp.store(0, std::memory_order_release);
+    return true;
+}
+
+bool JitterBuffer::peek(uint64_t sequence, unsigned char *packetOut, size_t &lengthOut) {
+    // the slot's held busy while it's copied, so the producer can't reuse it under us.
+    Slot    &slot     = mSlots[sequence % slotCount];
+    uint64_t expected = sequence + 1;
+    if (!slot.stamp.compare_exchange_strong(expected, busyStamp, std::memory_order_acquire)) {
+        return false;
+    }
+    ::memcpy(packetOut, slot.data, slot.length);
+    lengthOut = slot.length;
+    slot.stamp.store(sequence + 1, std::memory_order_release);
+    return true;
+}
+
+uint64_t JitterBuffer::first_buffered(uint64_t head) const {
+    const uint64_t from = std::max(mNext, head > slotCount ? head - slotCount : 0);
+    for (uint64_t seq = from; seq < head; seq++) {
+        if (mSlots[seq % slotCount].stamp.load(std::memory_order_acquire) == seq + 1) {
+            return seq;
+        }
+    }
+    return head - 1;
+}
+
+void JitterBuffer::advance() {
+    mNext++;
+    mPlayed.store(mNext, std::memory_order_release);
+}
+
+void JitterBuffer::stop() {
+    mState = State::Idle;
+    mPlayed.store(mNext, std::memory_order_release);
+}
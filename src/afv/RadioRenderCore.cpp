@@ -0,0 +1,1089 @@
+#include "afv-native/afv/RadioRenderCore.h"
+#include "afv-native/Log.h"
+#include "afv-native/audio/kernels.h"
+#include "afv-native/util/AllocationTracker.h"
+#include "afv-native/util/monotime.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+using namespace afv_native;
+using namespace afv_native::afv;
+
+namespace {
+    const float fxClickGain         = 1.3f;
+    const float fxBlockToneGain     = 0.25f;
+    const float fxBlockToneFreq     = 180.0f;
+    const float fxAcBusGain         = 0.005f;
+    const float fxVhfWhiteNoiseGain = 0.17f;
+    const float fxHfWhiteNoiseGain  = 0.16f;
+
+    /** the packet loss is worked out about once a second, from at least lossWindowPackets
+     * packets, and each second counts for lossSmoothing of the average. */
+    const unsigned int lossWindowTicks   = 10;
+    const int64_t      lossWindowPackets = 50;
+    const double       lossSmoothing     = 0.25;
+
+    inline bool freqIsHF(unsigned int freq) {
+        return freq < 30000000;
+    }
+
+    inline bool on_rx_frequency(const RenderConfigSnapshot &config, unsigned int freq) {
+        return std::binary_search(config.rxFrequencies.begin(), config.rxFrequencies.end(), freq);
+    }
+} // namespace
+
+RenderStream::RenderStream(std::shared_ptr<RemoteVoiceSource> source): source(std::move(source)), frequencies() {
+    decoded.sampleRate = this->source->getSampleRate();
+}
+
+float StreamContribution::crackleFactorFor(float distanceRatio) {
+    float crackleFactor = static_cast<float>((exp(distanceRatio) * pow(distanceRatio, -4.0) / 350.0) - 0.00776652);
+    crackleFactor       = fmax(0.0f, crackleFactor);
+    return fmin(0.20f, crackleFactor);
+}
+
+void StreamContribution::setDistanceRatio(float ratio) {
+    if (ratio != distanceRatio) {
+        distanceRatio = ratio;
+        crackleFactor = crackleFactorFor(ratio);
+    }
+}
+
+RadioDsp::RadioDsp(const EffectResources &resources, HardwareType hardware, int sampleRate, size_t quantum):
+    sampleRate(sampleRate), frameSamples(quantum > 0 ? quantum : sampleRate * audio::frameLengthMs / 1000), Click(resources.mClick, false, frameSamples), Crackle(resources.mCrackle, true, frameSamples), AcBus(resources.mAcBus, true, frameSamples), VhfWhiteNoise(resources.mVhfWhiteNoise, true, frameSamples), HfWhiteNoise(resources.mHfWhiteNoise, true, frameSamples), BlockTone(fxBlockToneFreq, 1.0f, sampleRate, frameSamples), simpleCompressorEffect(sampleRate, frameSamples), vhfFilter(hardware, sampleRate, frameSamples) {
+}
+
+RenderBus::RenderBus(unsigned int channels, const EffectResources &resources):
+    channels(channels), ring(audio::frameSizeSamples * channels, ringFrames * audio::frameSizeSamples / audio::minRenderQuantumSamples), noise {{EffectVoice<audio::RecordedSampleSource>(resources.mCrackle, true), EffectVoice<audio::RecordedSampleSource>(resources.mHfWhiteNoise, true), EffectVoice<audio::RecordedSampleSource>(resources.mVhfWhiteNoise, true), EffectVoice<audio::RecordedSampleSource>(resources.mAcBus, true)}}, upsamplers {{audio::PolyphaseUpsampler(audio::reducedRateFactor), audio::PolyphaseUpsampler(audio::reducedRateFactor)}} {
+}
+
+template <typename Policy>
+RadioRenderCore<Policy>::RadioRenderCore(const EffectResources &resources):
+    IncomingAudioStreams(0), RenderTicks(0), BusFramesDropped(0), RenderLockWaitNs(0), IdleRenderTicks(0), IdleRenderNs(0), ActiveRenderNs(0), IdleRadioRenders(0), DecoderEvictions(0), DecoderRejections(0), DecodeWorkerFrames(0), DecodeWorkerNs(0), mStreamMapLock(), mSourcePool(), mStreamExpiry(expiryTickMs, util::monotime_get()), mIncomingStreams(), mStreamFrames(), mFrequencyStreams(), mPtt(false), mSharedNoiseBed(false), mRenderResources(resources), mReducedResources(), mReducedResourcesOnce(), mReducedRate(false), mRenderQuantum(audio::frameSizeSamples), mRadioConfig(), mBuses {{RenderBus(Policy::busChannels(BusHeadset), resources), RenderBus(Policy::busChannels(BusSpeaker), resources)}}, mRenderEvents() {
+    mSourcePool.reserve(pooledSources);
+}
+
+template <typename Policy>
+uint64_t RadioRenderCore<Policy>::getDroppedRenderEvents() const {
+    return mRenderEvents.dropped();
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::getStreamJitterStats(std::vector<StreamJitterStats> &statsOut) {
+    std::lock_guard<std::mutex> streamMapLock(mStreamMapLock);
+    statsOut.clear();
+    for (const auto &src: mIncomingStreams) {
+        if (!src.second.source) {
+            continue;
+        }
+        const auto       &jitter = src.second.source->getJitterBuffer();
+        StreamJitterStats stats;
+        stats.callsign      = src.first;
+        stats.late          = jitter.Late.load(std::memory_order_relaxed);
+        stats.lost          = jitter.Lost.load(std::memory_order_relaxed);
+        stats.concealed     = jitter.Concealed.load(std::memory_order_relaxed);
+        stats.recovered     = jitter.Recovered.load(std::memory_order_relaxed);
+        stats.discarded     = jitter.Discarded.load(std::memory_order_relaxed);
+        stats.targetDelayMs = jitter.getTargetDelayFrames() * audio::frameLengthMs;
+        statsOut.push_back(stats);
+    }
+}
+
+template <typename Policy>
+const VoiceSourcePool &RadioRenderCore<Policy>::getSourcePool() const {
+    return mSourcePool;
+}
+
+template <typename Policy>
+unsigned int RadioRenderCore<Policy>::getMeasuredPacketLoss() const {
+    return mMeasuredPacketLoss.load(std::memory_order_relaxed);
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::setMeasurePacketLoss(bool measure) {
+    mMeasurePacketLoss.store(measure, std::memory_order_relaxed);
+}
+
+template <typename Policy>
+audio::SourceStatus RadioRenderCore<Policy>::render_bus(OutputBus busId, audio::SampleType *bufferOut, size_t numSamples) {
+    RenderBus   &bus      = mBuses[busId];
+    const size_t channels = bus.channels;
+    size_t       done     = 0;
+
+    const util::monotime_t now = util::monotime_get();
+    if (bus.lastReadMs != 0 && now - bus.lastReadMs > RenderBus::restartGapMs) {
+        // the device has been stopped - start it off with the next quantum rendered, not what
+        // was left from before.  Reading is ours, so the ring can be drained from here.
+        while (bus.ring.readFrame(bus.readChunk) != 0) {
+        }
+        bus.readOffset = 0;
+        bus.readLength = 0;
+    }
+    bus.lastReadMs = now;
+    while (done < numSamples) {
+        const size_t remaining = numSamples - done;
+        if (bus.readOffset == bus.readLength) {
+            if (remaining * channels >= bus.ring.frameSamples()) {
+                // there's room for any quantum, so it can go straight out.
+                done += read_bus_frame(bus, bufferOut + done * channels);
+                continue;
+            }
+            bus.readOffset = 0;
+            bus.readLength = read_bus_frame(bus, bus.readChunk);
+        }
+        const size_t count = std::min(remaining, bus.readLength - bus.readOffset);
+        ::memcpy(bufferOut + done * channels, bus.readChunk + bus.readOffset * channels, sizeof(audio::SampleType) * count * channels);
+        bus.readOffset += count;
+        done += count;
+    }
+    return audio::SourceStatus::OK;
+}
+
+template <typename Policy>
+size_t RadioRenderCore<Policy>::read_bus_frame(RenderBus &bus, audio::SampleType *bufferOut) {
+    bus.wasRead.store(true, std::memory_order_relaxed);
+    size_t length = bus.ring.readFrame(bufferOut);
+    if (length == 0) {
+        render_tick(bus);
+        length = bus.ring.readFrame(bufferOut);
+    }
+    if (length == 0) {
+        // can't happen - the tick always renders for the bus that asked for it.
+        length = audio::minRenderQuantumSamples * bus.channels;
+        ::memset(bufferOut, 0, sizeof(audio::SampleType) * length);
+    }
+    return length / bus.channels;
+}
+
+template <typename Policy>
+size_t RadioRenderCore<Policy>::quantum_at(int sampleRate) const {
+    return mRenderQuantum.load(std::memory_order_relaxed) * sampleRate / audio::sampleRateHz;
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::render_tick(const RenderBus &requester) {
+    util::NoAllocationScope noAllocGuard("RadioRenderCore::render_tick");
+
+    const auto                  waitStart = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> streamGuard(mStreamMapLock);
+    const auto                  renderStart = std::chrono::steady_clock::now();
+    RenderLockWaitNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(renderStart - waitStart).count(), std::memory_order_relaxed);
+    if (!requester.ring.empty()) {
+        // another device ran the tick while we were waiting.
+        return;
+    }
+    RenderTicks.fetch_add(1, std::memory_order_relaxed);
+
+    // a bus that hasn't been read since the last tick has no use for another quantum yet (its
+    // device will run a tick of its own if it runs dry), and one with a full ring has a device
+    // that has fallen behind, so neither is mixed this tick.  The ring has room for the
+    // shortest quantum, so how full it may get is down to the quantum in use.
+    const size_t       quantum    = mRenderQuantum.load(std::memory_order_relaxed);
+    const size_t       queueLimit = RenderBus::ringFrames * audio::frameSizeSamples / quantum;
+    audio::SampleType *busFrames[BusCount];
+    for (size_t i = 0; i < BusCount; i++) {
+        auto      &bus     = mBuses[i];
+        const bool reading = bus.wasRead.exchange(false, std::memory_order_relaxed) || &bus == &requester;
+        busFrames[i]       = nullptr;
+        if (!reading) {
+            continue;
+        }
+        if (bus.ring.size() < queueLimit) {
+            busFrames[i] = bus.ring.writeFrame();
+        }
+        if (busFrames[i] != nullptr) {
+            ::memset(busFrames[i], 0, sizeof(audio::SampleType) * quantum * bus.channels);
+        } else {
+            BusFramesDropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // a stream only decodes once it's worked through its last frame - until then it's live
+    // on whatever that frame was.
+    size_t liveStreams = 0;
+    for (auto &src: mIncomingStreams) {
+        auto &decoded = src.second.decoded;
+        if (decoded.cursor == 0) {
+            // a decoded-ahead frame is played even if the stream has ended since.
+            decoded.live = src.second.source && (mDecodeWorkers || src.second.source->isActive()) &&
+                           fetch_stream_frame(src.second) != nullptr;
+        }
+        if (decoded.live) {
+            liveStreams++;
+        }
+    }
+    if (mDecodeWorkers) {
+        // the frames are out of the way, so the workers can get on with the next ones while
+        // the radios render.
+        mDecodeWorkers->wake();
+    }
+
+    // with nothing received and every radio idle the mix is silence, which the buses already
+    // hold.  New radios start out idle, so a config change can't leave one out.
+    bool upsamplersSettled = true;
+    for (const auto &bus: mBuses) {
+        for (const auto &upsampler: bus.upsamplers) {
+            upsamplersSettled = upsamplersSettled && upsampler.settled();
+        }
+    }
+    const bool idle = liveStreams == 0 && mActiveRadios == 0 && upsamplersSettled;
+    if (!idle) {
+        for (size_t i = 0; i < BusCount; i++) {
+            if (busFrames[i] != nullptr) {
+                ::memset(mBuses[i].reducedFrame, 0, sizeof(mBuses[i].reducedFrame));
+                mBuses[i].reducedLive = false;
+            }
+        }
+
+        auto        config         = mRadioConfig.read();
+        const auto &radios         = config->radios;
+        const bool  sharedNoiseBed = mSharedNoiseBed.load(std::memory_order_relaxed);
+        const auto  tier           = mGovernor.getTier();
+        auto        render         = [&](size_t i) {
+            if (busFrames[radios[i].bus] != nullptr) {
+                _process_radio(radios[i], sharedNoiseBed, tier);
+            }
+        };
+        if (mDspPool) {
+            mDspPool->parallelFor(radios.size(), render);
+        } else {
+            for (size_t i = 0; i < radios.size(); i++) {
+                render(i);
+            }
+        }
+        // mix down in a fixed order so the result doesn't depend on which thread finished first.
+        size_t   activeRadios  = 0;
+        uint64_t skippedRadios = 0;
+        for (const auto &radio: radios) {
+            if (busFrames[radio.bus] != nullptr) {
+                mix_radio_to_bus(radio, mBuses[radio.bus], busFrames[radio.bus]);
+                if (radio.dsp->skipped) {
+                    skippedRadios++;
+                }
+            }
+            if (!radio.dsp->idle) {
+                activeRadios++;
+            }
+        }
+        mActiveRadios = activeRadios;
+        IdleRadioRenders.fetch_add(skippedRadios, std::memory_order_relaxed);
+        for (size_t i = 0; i < BusCount; i++) {
+            if (busFrames[i] != nullptr) {
+                upsample_bus(mBuses[i], busFrames[i], quantum);
+                mix_noise_bed(mBuses[i], busFrames[i], quantum);
+            }
+        }
+    }
+
+    if (liveStreams > 0) {
+        for (auto &src: mIncomingStreams) {
+            auto &decoded = src.second.decoded;
+            if (decoded.live) {
+                decoded.cursor += quantum_at(decoded.sampleRate);
+                if (decoded.cursor >= static_cast<size_t>(decoded.sampleRate * audio::frameLengthMs / 1000)) {
+                    decoded.cursor = 0;
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < BusCount; i++) {
+        if (busFrames[i] != nullptr) {
+            mBuses[i].ring.commitFrame(quantum * mBuses[i].channels);
+        }
+    }
+
+    const auto renderNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - renderStart).count();
+    if (idle) {
+        IdleRenderTicks.fetch_add(1, std::memory_order_relaxed);
+        IdleRenderNs.fetch_add(renderNs, std::memory_order_relaxed);
+    } else {
+        ActiveRenderNs.fetch_add(renderNs, std::memory_order_relaxed);
+    }
+    // the budget is per frame, so a shorter quantum counts for proportionally more.
+    mGovernor.update(static_cast<uint64_t>(renderNs) * audio::frameSizeSamples / quantum);
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::_process_radio(const RenderRadioConfig &radio, bool sharedNoiseBed, RenderTier tier) {
+    RadioDsp &dsp          = *radio.dsp;
+    auto      contributors = mFrequencyStreams.find(radio.Frequency);
+    if (dsp.frameSamples != quantum_at(dsp.sampleRate)) {
+        // the dsp is left over from a quantum switch, and about to be replaced.
+        dsp.mixToBus = false;
+        dsp.skipped  = true;
+        return;
+    }
+    if (dsp.idle) {
+        bool anyLive = false;
+        if (contributors != mFrequencyStreams.end()) {
+            for (const auto &contribution: contributors->second) {
+                if (contribution.stream->decoded.live) {
+                    anyLive = true;
+                    break;
+                }
+            }
+        }
+        if (!anyLive) {
+            // the radio would only be adding silence - its effects are already stopped.
+            dsp.mixToBus = false;
+            dsp.skipped  = true;
+            return;
+        }
+    }
+    dsp.skipped = false;
+
+    if (dsp.frequency != radio.Frequency) {
+        // reset all of the effects, except the click which should be audible due to the
+        // squelch-gate kicking in on the new frequency
+        resetRadioFx(dsp, true);
+        dsp.frequency = radio.Frequency;
+    }
+
+    bool               ignoreaudio  = false;
+    audio::SampleType *channel      = dsp.channelBuffer;
+    const size_t       frameSamples = dsp.frameSamples;
+
+    ::memset(channel, 0, frameSamples * sizeof(audio::SampleType));
+    std::fill(std::begin(dsp.noiseGains), std::end(dsp.noiseGains), 0.0f);
+    if (mPtt.load() && radio.tx) {
+        // don't analyze and mix-in the radios transmitting, but suppress the
+        // effects.
+        if (!Policy::holdRxWhileTransmitting) {
+            resetRadioFx(dsp);
+            dsp.mixToBus = false;
+            dsp.idle     = true;
+            return;
+        }
+        resetRadioFx(dsp, true);
+        ignoreaudio = true;
+    }
+    // now, find all streams that this applies to.
+    float    crackleGain       = 0.0f;
+    float    hfGain            = 0.0f;
+    float    vhfGain           = 0.0f;
+    float    acBusGain         = 0.0f;
+    uint32_t concurrentStreams = 0;
+    // the last stream is held back so it can be mixed and limited in a single pass.
+    const audio::SampleType *lastFrame = nullptr;
+    float                    lastGain  = 0.0f;
+    if (contributors != mFrequencyStreams.end()) {
+        for (const auto &contribution: contributors->second) {
+            const auto &decoded = contribution.stream->decoded;
+            if (!decoded.live || decoded.sampleRate != dsp.sampleRate) {
+                // a stream at the other rate is left over from a switch, and on its way out.
+                continue;
+            }
+            float voiceGain = 1.0f;
+
+            float crackleFactor = 0.0f;
+            if (!radio.bypassEffects) {
+                crackleFactor = contribution.crackleFactor;
+
+                if (freqIsHF(radio.Frequency)) {
+                    if (!radio.hfSquelch) {
+                        hfGain = fxHfWhiteNoiseGain;
+                    } else {
+                        hfGain = 0.0f;
+                    }
+                    vhfGain   = 0.0f;
+                    acBusGain = 0.001f;
+                    voiceGain = 0.20f;
+                } else {
+                    hfGain    = 0.0f;
+                    vhfGain   = fxVhfWhiteNoiseGain;
+                    acBusGain = fxAcBusGain;
+                    crackleGain += crackleFactor * 2;
+                    voiceGain = 1.0 - crackleFactor * 3.7;
+                }
+            }
+
+            // then include this stream.
+            if (!ignoreaudio) {
+                if (lastFrame != nullptr) {
+                    audio::kernels::mix(channel, lastFrame, lastGain, frameSamples);
+                }
+                lastFrame = mStreamFrames.frame(decoded.slot) + decoded.cursor;
+                lastGain  = voiceGain * radio.Gain;
+            }
+
+            concurrentStreams++;
+        }
+    }
+
+    const int lastRxCount = dsp.mLastRxCount.load(std::memory_order_relaxed);
+    if (concurrentStreams > 0) {
+        if (Policy::rxEvents && lastRxCount == 0 && !ignoreaudio) {
+            // Post Begin Voice Receiving Notfication
+            mRenderEvents.push({RenderEvent::FrequencyRxBegin, radio.Frequency});
+        }
+        if (!radio.bypassEffects) {
+            // limiter effect
+            if (lastFrame != nullptr) {
+                audio::kernels::mixClamp(channel, lastFrame, lastGain, frameSamples);
+            }
+
+            set_radio_effects(dsp);
+            if (tier >= TierEconomyFilter) {
+                dsp.vhfFilter.effect.transformFrameEconomy(channel, channel);
+            } else {
+                dsp.vhfFilter.effect.transformFrame(channel, channel);
+            }
+            if (tier < TierNoCompressor) {
+                dsp.simpleCompressorEffect.transformFrame(channel, channel);
+            }
+            if (tier >= TierNoNoiseBeds) {
+                // the beds are the first thing to go - they hold their place until they're
+                // back, and the shared ones stop once no radio asks for them.
+            } else if (sharedNoiseBed) {
+                dsp.noiseGains[NoiseCrackle]       = crackleGain * radio.Gain;
+                dsp.noiseGains[NoiseHfWhiteNoise]  = hfGain * radio.Gain;
+                dsp.noiseGains[NoiseVhfWhiteNoise] = vhfGain * radio.Gain;
+                dsp.noiseGains[NoiseAcBus]         = acBusGain * radio.Gain;
+            } else {
+                mix_effect(dsp.Crackle, crackleGain * radio.Gain, dsp);
+                mix_effect(dsp.HfWhiteNoise, hfGain * radio.Gain, dsp);
+                mix_effect(dsp.VhfWhiteNoise, vhfGain * radio.Gain, dsp);
+                mix_effect(dsp.AcBus, acBusGain * radio.Gain, dsp);
+            }
+        } else if (lastFrame != nullptr) {
+            audio::kernels::mix(channel, lastFrame, lastGain, frameSamples);
+        } // bypass effects
+        if (concurrentStreams > 1) {
+            if (!dsp.BlockTone.active) {
+                dsp.BlockTone.start();
+            }
+            mix_effect(dsp.BlockTone, fxBlockToneGain * radio.Gain, dsp);
+        } else {
+            dsp.BlockTone.stop();
+        }
+    } else {
+        resetRadioFx(dsp, true);
+        if (lastRxCount > 0) {
+            dsp.Click.start();
+            if (Policy::rxEvents) {
+                mRenderEvents.push({RenderEvent::FrequencyRxEnd, radio.Frequency});
+            }
+        }
+    }
+
+    dsp.mLastRxCount.store(static_cast<int>(concurrentStreams), std::memory_order_relaxed);
+
+    // if we have a pending click, play it.
+    mix_effect(dsp.Click, fxClickGain * radio.Gain, dsp);
+
+    dsp.mixToBus = !ignoreaudio;
+    // without streams everything but the click has been stopped, so once that's done the
+    // radio's output is silence until the next stream - skipping it can't change the mix.
+    dsp.idle = concurrentStreams == 0 && !dsp.Click.active;
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::mix_radio_to_bus(const RenderRadioConfig &radio, RenderBus &bus, audio::SampleType *busFrame) {
+    const RadioDsp &dsp = *radio.dsp;
+    if (!dsp.mixToBus) {
+        return;
+    }
+    const float leftGain  = radio.leftGain;
+    const float rightGain = bus.channels == 2 ? radio.rightGain : 0.0f;
+    if (dsp.sampleRate != audio::sampleRateHz) {
+        audio::kernels::mix(bus.reducedFrame[0], dsp.channelBuffer, leftGain, dsp.frameSamples);
+        if (bus.channels == 2) {
+            audio::kernels::mix(bus.reducedFrame[1], dsp.channelBuffer, rightGain, dsp.frameSamples);
+        }
+        bus.reducedLive = true;
+    } else if (bus.channels == 2) {
+        audio::kernels::mixMonoToStereo(busFrame, dsp.channelBuffer, leftGain, rightGain, dsp.frameSamples);
+    } else {
+        audio::kernels::mix(busFrame, dsp.channelBuffer, leftGain, dsp.frameSamples);
+    }
+    // the radios' beds would have been uncorrelated, and so added in power rather than in
+    // amplitude.
+    for (size_t n = 0; n < NoiseCount; n++) {
+        const float left  = dsp.noiseGains[n] * leftGain;
+        const float right = dsp.noiseGains[n] * rightGain;
+        bus.noiseGains[n][0] += left * left;
+        bus.noiseGains[n][1] += right * right;
+    }
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::upsample_bus(RenderBus &bus, audio::SampleType *busFrame, size_t quantum) {
+    for (unsigned int ch = 0; ch < bus.channels; ch++) {
+        auto &upsampler = bus.upsamplers[ch];
+        if (!bus.reducedLive && upsampler.settled()) {
+            continue;
+        }
+        upsampler.process(bus.upsampleBuffer, bus.reducedFrame[ch], quantum / audio::reducedRateFactor);
+        if (bus.channels == 2) {
+            audio::kernels::mixMonoToStereo(busFrame, bus.upsampleBuffer, ch == 0 ? 1.0f : 0.0f, ch == 1 ? 1.0f : 0.0f, quantum);
+        } else {
+            audio::kernels::mix(busFrame, bus.upsampleBuffer, 1.0f, quantum);
+        }
+    }
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::mix_noise_bed(RenderBus &bus, audio::SampleType *busFrame, size_t quantum) {
+    for (size_t n = 0; n < NoiseCount; n++) {
+        auto       &voice = bus.noise[n];
+        const float left  = std::sqrt(bus.noiseGains[n][0]);
+        const float right = std::sqrt(bus.noiseGains[n][1]);
+        bus.noiseGains[n][0] = 0.0f;
+        bus.noiseGains[n][1] = 0.0f;
+        if (left <= 0.0f && right <= 0.0f) {
+            // as with a radio's own, the bed starts over the next time it's wanted.
+            voice.stop();
+            continue;
+        }
+        if (!voice.active) {
+            voice.start();
+        }
+        if (voice.effect.getAudioFrame(bus.noiseBuffer) != audio::SourceStatus::OK) {
+            voice.stop();
+            continue;
+        }
+        if (bus.channels == 2) {
+            audio::kernels::mixMonoToStereo(busFrame, bus.noiseBuffer, left, right, quantum);
+        } else {
+            audio::kernels::mix(busFrame, bus.noiseBuffer, left, quantum);
+        }
+    }
+}
+
+template <typename Policy>
+const audio::SampleType *RadioRenderCore<Policy>::fetch_stream_frame(RenderStream &meta) {
+    auto              &decoded = meta.decoded;
+    audio::SampleType *samples = mStreamFrames.frame(decoded.slot);
+    if (mDecodeWorkers) {
+        decoded.status = meta.source->readDecodedFrame(samples) ? audio::SourceStatus::OK : audio::SourceStatus::Closed;
+    } else {
+        decoded.status = meta.source->getAudioFrame(samples);
+    }
+    if (decoded.status != audio::SourceStatus::OK) {
+        return nullptr;
+    }
+    return samples;
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::resetRadioFx(RadioDsp &dsp, bool except_click) {
+    if (!except_click) {
+        dsp.Click.stop();
+        dsp.mLastRxCount.store(0);
+    }
+    dsp.BlockTone.stop();
+    dsp.Crackle.stop();
+    dsp.VhfWhiteNoise.stop();
+    dsp.HfWhiteNoise.stop();
+    dsp.AcBus.stop();
+    dsp.vhfFilter.stop();
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::set_radio_effects(RadioDsp &dsp) {
+    // (re)start whichever effects aren't running - they're rewound in place, not rebuilt.
+    if (!dsp.VhfWhiteNoise.active) {
+        dsp.VhfWhiteNoise.start();
+    }
+    if (!dsp.HfWhiteNoise.active) {
+        dsp.HfWhiteNoise.start();
+    }
+    if (!dsp.Crackle.active) {
+        dsp.Crackle.start();
+    }
+    if (!dsp.AcBus.active) {
+        dsp.AcBus.start();
+    }
+    if (!dsp.vhfFilter.active) {
+        dsp.vhfFilter.start();
+    }
+}
+
+template <typename Policy>
+template <typename EffectT>
+void RadioRenderCore<Policy>::mix_effect(EffectVoice<EffectT> &voice, float gain, RadioDsp &dsp) {
+    if (voice.active && gain > 0.0f) {
+        auto rv = voice.effect.getAudioFrame(dsp.fetchBuffer);
+        if (rv == audio::SourceStatus::OK) {
+            audio::kernels::mix(dsp.channelBuffer, dsp.fetchBuffer, gain, dsp.frameSamples);
+        } else {
+            voice.stop();
+        }
+    }
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::ingest_packet(const afv::dto::AudioRxOnTransceivers &pkt) {
+    std::lock_guard<std::mutex> streamMapLock(mStreamMapLock);
+    // one stream per callsign - the headset and speaker renders share its decoded frames.
+    auto streamIt = mIncomingStreams.find(pkt.Callsign);
+    if (streamIt == mIncomingStreams.end()) {
+        if (!admit_stream(pkt)) {
+            return;
+        }
+        streamIt = mIncomingStreams.try_emplace(pkt.Callsign, mSourcePool.acquire(mReducedRate.load() ? audio::reducedSampleRateHz : audio::sampleRateHz)).first;
+        // new streams get their frame slot here, on the network thread, so growing the
+        // slab never happens during a render.
+        streamIt->second.decoded.slot = mStreamFrames.acquire();
+        streamIt->second.expiry.key   = pkt.Callsign;
+        if (mDecodeWorkers) {
+            mDecodeWorkers->add(streamIt->second.source);
+        }
+    }
+    auto &stream = streamIt->second;
+    stream.source->appendAudioDTO(pkt);
+    mStreamExpiry.schedule(stream.expiry, util::monotime_get() + audio::compressedSourceCacheTimeoutMs);
+    index_stream(stream, pkt.Transceivers);
+    IncomingAudioStreams.store(static_cast<uint32_t>(mIncomingStreams.size()));
+}
+
+template <typename Policy>
+bool RadioRenderCore<Policy>::admit_stream(const afv::dto::AudioRxOnTransceivers &pkt) {
+    const size_t budget = decoder_budget();
+    if (budget == 0 || mIncomingStreams.size() < budget) {
+        mRejectedStreams.erase(pkt.Callsign);
+        return true;
+    }
+
+    auto       config = mRadioConfig.read();
+    StreamRank rank;
+    for (const auto &trans: pkt.Transceivers) {
+        rank.rx            = rank.rx || on_rx_frequency(*config, trans.Frequency);
+        rank.distanceRatio = std::max(rank.distanceRatio, trans.DistanceRatio);
+    }
+    StreamRank lowestRank;
+    auto       lowest = lowest_ranked_stream(*config, lowestRank);
+    // ties go to the stream that already has the decoder, so two equals can't keep swapping.
+    if (lowest != mIncomingStreams.end() && lowestRank < rank) {
+        remove_stream(lowest);
+        DecoderEvictions.fetch_add(1, std::memory_order_relaxed);
+        mRejectedStreams.erase(pkt.Callsign);
+        return true;
+    }
+
+    auto rejected = mRejectedStreams.try_emplace(pkt.Callsign);
+    if (rejected.second) {
+        rejected.first->second.key = pkt.Callsign;
+        DecoderRejections.fetch_add(1, std::memory_order_relaxed);
+    }
+    mStreamExpiry.schedule(rejected.first->second, util::monotime_get() + audio::compressedSourceCacheTimeoutMs);
+    return false;
+}
+
+template <typename Policy>
+size_t RadioRenderCore<Policy>::decoder_budget() const {
+    if (mMaxDecoders == 0 || mGovernorDecoderCap == 0) {
+        return std::max(mMaxDecoders, mGovernorDecoderCap);
+    }
+    return std::min(mMaxDecoders, mGovernorDecoderCap);
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::enforce_decoder_budget() {
+    const size_t budget = decoder_budget();
+    if (budget == 0 || mIncomingStreams.size() <= budget) {
+        return;
+    }
+    auto config = mRadioConfig.read();
+    while (mIncomingStreams.size() > budget) {
+        StreamRank rank;
+        remove_stream(lowest_ranked_stream(*config, rank));
+        DecoderEvictions.fetch_add(1, std::memory_order_relaxed);
+    }
+    IncomingAudioStreams.store(static_cast<uint32_t>(mIncomingStreams.size()));
+}
+
+template <typename Policy>
+typename RadioRenderCore<Policy>::StreamIterator RadioRenderCore<Policy>::lowest_ranked_stream(const RenderConfigSnapshot &config, StreamRank &rankOut) {
+    auto lowest = mIncomingStreams.end();
+    for (auto it = mIncomingStreams.begin(); it != mIncomingStreams.end(); ++it) {
+        const auto &stream = it->second;
+        StreamRank  rank;
+        rank.rx = std::any_of(stream.frequencies.begin(), stream.frequencies.end(), [&config](unsigned int freq) {
+            return on_rx_frequency(config, freq);
+        });
+        rank.distanceRatio = stream.bestDistanceRatio;
+        if (lowest == mIncomingStreams.end() || rank < rankOut) {
+            lowest  = it;
+            rankOut = rank;
+        }
+    }
+    return lowest;
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::remove_stream(StreamIterator stream) {
+    unindex_stream(stream->second);
+    mStreamFrames.release(stream->second.decoded.slot);
+    if (mDecodeWorkers) {
+        mDecodeWorkers->remove(stream->second.source.get());
+    }
+    mSourcePool.release(std::move(stream->second.source));
+    mIncomingStreams.erase(stream);
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::index_stream(RenderStream &stream, const std::vector<dto::RxTransceiver> &transceivers) {
+    // drop the stream from any frequency it's no longer heard on first.
+    for (auto freq: stream.frequencies) {
+        bool stillHeard = std::any_of(transceivers.begin(), transceivers.end(), [freq](const dto::RxTransceiver &t) {
+            return t.Frequency == freq;
+        });
+        if (!stillHeard) {
+            remove_contribution(freq, &stream);
+        }
+    }
+
+    // then refresh the best DistanceRatio on each frequency it is heard on.  The stream's
+    // frequency list is rebuilt as we go, so the first transceiver seen on a frequency replaces
+    // the previous packet's ratio, and any others only improve on it.  The crackle factor is
+    // only worked out again when a ratio actually changes.
+    stream.frequencies.clear();
+    stream.bestDistanceRatio = 0.0f;
+    for (const auto &trans: transceivers) {
+        stream.bestDistanceRatio = std::max(stream.bestDistanceRatio, trans.DistanceRatio);
+        auto &contributors = mFrequencyStreams[trans.Frequency];
+        auto  it = std::find_if(contributors.begin(), contributors.end(), [&stream](const StreamContribution &c) {
+            return c.stream == &stream;
+        });
+        bool seenThisPacket = std::find(stream.frequencies.begin(), stream.frequencies.end(),
+                                        trans.Frequency) != stream.frequencies.end();
+        if (it == contributors.end()) {
+            contributors.push_back({&stream, trans.DistanceRatio, StreamContribution::crackleFactorFor(trans.DistanceRatio)});
+        } else if (!seenThisPacket) {
+            it->setDistanceRatio(trans.DistanceRatio);
+        } else {
+            it->setDistanceRatio(std::max(it->distanceRatio, trans.DistanceRatio));
+        }
+        if (!seenThisPacket) {
+            stream.frequencies.push_back(trans.Frequency);
+        }
+    }
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::unindex_stream(RenderStream &stream) {
+    for (auto freq: stream.frequencies) {
+        remove_contribution(freq, &stream);
+    }
+    stream.frequencies.clear();
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::remove_contribution(unsigned int freq, const RenderStream *stream) {
+    auto contributors = mFrequencyStreams.find(freq);
+    if (contributors == mFrequencyStreams.end()) {
+        return;
+    }
+    auto &entries = contributors->second;
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [stream](const StreamContribution &c) {
+                      return c.stream == stream;
+                  }),
+                  entries.end());
+    if (entries.empty()) {
+        mFrequencyStreams.erase(contributors);
+    }
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::expire_streams() {
+    std::lock_guard<std::mutex> ml(mStreamMapLock);
+    const size_t expired = mStreamExpiry.advance(util::monotime_get(), [this](util::TimerWheel<std::string>::Timer &timer) {
+        auto streamIt = mIncomingStreams.find(timer.key);
+        if (streamIt != mIncomingStreams.end()) {
+            remove_stream(streamIt);
+            return;
+        }
+        auto rejectedIt = mRejectedStreams.find(timer.key);
+        if (rejectedIt != mRejectedStreams.end()) {
+            mRejectedStreams.erase(rejectedIt);
+        }
+    });
+    if (expired > 0) {
+        IncomingAudioStreams.store(static_cast<uint32_t>(mIncomingStreams.size()));
+    }
+    if (mMeasurePacketLoss.load(std::memory_order_relaxed)) {
+        measure_packet_loss();
+    } else if (mLossMeasuring) {
+        mLossMeasuring = false;
+        mPacketLoss    = 0.0;
+        mMeasuredPacketLoss.store(0, std::memory_order_relaxed);
+    }
+
+    // the render can't free decoders itself, so the governor's cap is applied from here.
+    if (mGovernor.getTier() >= TierCappedDecoders) {
+        if (mGovernorDecoderCap == 0) {
+            mGovernorDecoderCap = std::max(governorMinDecoders, mIncomingStreams.size() * 3 / 4);
+            LOG(Policy::logName(), "render governor capping decoders at %u", static_cast<unsigned int>(mGovernorDecoderCap));
+        }
+        enforce_decoder_budget();
+    } else if (mGovernorDecoderCap != 0) {
+        mGovernorDecoderCap = 0;
+        LOG(Policy::logName(), "render governor lifted its decoder cap");
+    }
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::measure_packet_loss() {
+    if (!mLossMeasuring) {
+        // the counters have moved on unmeasured since the measurement was last on, so the
+        // first tick just catches up with them.
+        for (auto &stream: mIncomingStreams) {
+            if (stream.second.source) {
+                const auto &jitter         = stream.second.source->getJitterBuffer();
+                stream.second.lossReceived = jitter.Received.load(std::memory_order_relaxed);
+                stream.second.lossLost     = jitter.Lost.load(std::memory_order_relaxed);
+            }
+        }
+        mLossWindowReceived = 0;
+        mLossWindowLost     = 0;
+        mLossWindowTicks    = 0;
+        mLossMeasuring      = true;
+        return;
+    }
+    for (auto &stream: mIncomingStreams) {
+        if (!stream.second.source) {
+            continue;
+        }
+        // Lost can go back down as late packets turn up, so the window works in signed deltas.
+        const auto    &jitter   = stream.second.source->getJitterBuffer();
+        const uint64_t received = jitter.Received.load(std::memory_order_relaxed);
+        const uint64_t lost     = jitter.Lost.load(std::memory_order_relaxed);
+        mLossWindowReceived += static_cast<int64_t>(received - stream.second.lossReceived);
+        mLossWindowLost += static_cast<int64_t>(lost) - static_cast<int64_t>(stream.second.lossLost);
+        stream.second.lossReceived = received;
+        stream.second.lossLost     = lost;
+    }
+    if (++mLossWindowTicks < lossWindowTicks) {
+        return;
+    }
+    const int64_t lost  = std::max<int64_t>(mLossWindowLost, 0);
+    const int64_t total = mLossWindowReceived + lost;
+    if (total >= lossWindowPackets) {
+        mPacketLoss += lossSmoothing * (static_cast<double>(lost) / total - mPacketLoss);
+        mMeasuredPacketLoss.store(static_cast<unsigned int>(std::lround(mPacketLoss * 100.0)), std::memory_order_relaxed);
+    }
+    // with too little traffic to go on, the last measurement stands.
+    mLossWindowReceived = 0;
+    mLossWindowLost     = 0;
+    mLossWindowTicks    = 0;
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::reset_streams() {
+    std::lock_guard<std::mutex> ml(mStreamMapLock);
+    if (mDecodeWorkers) {
+        mDecodeWorkers->clear();
+    }
+    for (auto &stream: mIncomingStreams) {
+        mSourcePool.release(std::move(stream.second.source));
+    }
+    mIncomingStreams.clear();
+    mRejectedStreams.clear();
+    mFrequencyStreams.clear();
+    mStreamFrames.releaseAll();
+    IncomingAudioStreams.store(0);
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::setDspThreads(unsigned int threads, bool deterministic) {
+    // start (or stop) the threads outside the stream lock so the renders aren't held up.
+    std::unique_ptr<util::WorkStealingPool> pool;
+    if (threads > 0) {
+        pool = std::make_unique<util::WorkStealingPool>(threads, deterministic);
+    }
+    {
+        std::lock_guard<std::mutex> streamGuard(mStreamMapLock);
+        std::swap(mDspPool, pool);
+    }
+    LOG(Policy::logName(), "setDspThreads: %u%s", threads, deterministic ? " (deterministic)" : "");
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::setDecodeThreads(unsigned int threads) {
+    // the new workers have nothing to decode until the streams are handed over, so they can
+    // be started outside the stream lock.
+    std::unique_ptr<DecodeWorkers> workers;
+    if (threads > 0) {
+        workers = std::make_unique<DecodeWorkers>(threads, DecodeWorkerFrames, DecodeWorkerNs);
+    }
+    {
+        std::lock_guard<std::mutex> streamGuard(mStreamMapLock);
+        // the old workers must be done with the jitter buffers before anybody else takes them
+        // over.  They never take the stream lock, so this can't deadlock.
+        if (mDecodeWorkers) {
+            mDecodeWorkers->stop();
+        }
+        std::swap(mDecodeWorkers, workers);
+        for (auto &stream: mIncomingStreams) {
+            if (!stream.second.source) {
+                continue;
+            }
+            stream.second.source->dropDecodedFrames();
+            if (mDecodeWorkers) {
+                mDecodeWorkers->add(stream.second.source);
+            }
+        }
+    }
+    LOG(Policy::logName(), "setDecodeThreads: %u", threads);
+}
+
+template <typename Policy>
+unsigned int RadioRenderCore<Policy>::getDecodeThreads() {
+    std::lock_guard<std::mutex> streamGuard(mStreamMapLock);
+    return mDecodeWorkers ? mDecodeWorkers->getThreadCount() : 0;
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::waitForDecodeWorkers() {
+    std::lock_guard<std::mutex> streamGuard(mStreamMapLock);
+    if (mDecodeWorkers) {
+        mDecodeWorkers->waitIdle();
+    }
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::setSharedNoiseBed(bool shared) {
+    mSharedNoiseBed.store(shared);
+    LOG(Policy::logName(), "setSharedNoiseBed: %i", shared);
+}
+
+template <typename Policy>
+bool RadioRenderCore<Policy>::getSharedNoiseBed() {
+    return mSharedNoiseBed.load();
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::setMaxDecoders(size_t maxDecoders) {
+    // make the sources for a full complement of streams up front, outside the stream lock.
+    mSourcePool.reserve(maxDecoders);
+    std::lock_guard<std::mutex> streamGuard(mStreamMapLock);
+    mMaxDecoders = maxDecoders;
+    enforce_decoder_budget();
+    LOG(Policy::logName(), "setMaxDecoders: %u", static_cast<unsigned int>(maxDecoders));
+}
+
+template <typename Policy>
+size_t RadioRenderCore<Policy>::getMaxDecoders() {
+    std::lock_guard<std::mutex> streamGuard(mStreamMapLock);
+    return mMaxDecoders;
+}
+
+template <typename Policy>
+bool RadioRenderCore<Policy>::getReducedRateDsp() const {
+    return mReducedRate.load();
+}
+
+template <typename Policy>
+bool RadioRenderCore<Policy>::set_reduced_rate(bool reduced) {
+    if (reduced) {
+        std::call_once(mReducedResourcesOnce, [this]() {
+            mReducedResources = std::make_unique<EffectResources>(mRenderResources, audio::reducedRateFactor);
+        });
+    }
+    if (mReducedRate.exchange(reduced) == reduced) {
+        return false;
+    }
+    // the decoders are all at the old rate - start them over as the packets come in.
+    reset_streams();
+    LOG(Policy::logName(), "receive DSP now at %d Hz", reduced ? audio::reducedSampleRateHz : audio::sampleRateHz);
+    return true;
+}
+
+template <typename Policy>
+std::shared_ptr<RadioDsp> RadioRenderCore<Policy>::make_radio_dsp(HardwareType hardware) {
+    if (mReducedRate.load()) {
+        return std::make_shared<RadioDsp>(*mReducedResources, hardware, audio::reducedSampleRateHz, quantum_at(audio::reducedSampleRateHz));
+    }
+    return std::make_shared<RadioDsp>(mRenderResources, hardware, audio::sampleRateHz, quantum_at(audio::sampleRateHz));
+}
+
+template <typename Policy>
+size_t RadioRenderCore<Policy>::getRenderQuantum() const {
+    return mRenderQuantum.load();
+}
+
+template <typename Policy>
+bool RadioRenderCore<Policy>::validRenderQuantum(size_t quantum) {
+    return quantum >= static_cast<size_t>(audio::minRenderQuantumSamples) && audio::frameSizeSamples % quantum == 0 &&
+           quantum % audio::reducedRateFactor == 0;
+}
+
+template <typename Policy>
+bool RadioRenderCore<Policy>::set_render_quantum(size_t quantum) {
+    if (!validRenderQuantum(quantum)) {
+        LOG(Policy::logName(), "render quantum of %zu samples isn't a whole fraction of a frame, keeping %zu", quantum, mRenderQuantum.load());
+        return false;
+    }
+    std::lock_guard<std::mutex> streamGuard(mStreamMapLock);
+    if (mRenderQuantum.exchange(quantum) == quantum) {
+        return false;
+    }
+    // the cursors are in steps of the old quantum - start every stream on a fresh frame.
+    for (auto &src: mIncomingStreams) {
+        src.second.decoded.cursor = 0;
+    }
+    for (auto &bus: mBuses) {
+        for (auto &voice: bus.noise) {
+            voice.effect.setFrameSamples(quantum);
+        }
+    }
+    LOG(Policy::logName(), "rendering in quanta of %zu samples", quantum);
+    return true;
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::setRenderGovernor(bool enabled) {
+    mGovernor.setEnabled(enabled);
+    LOG(Policy::logName(), "setRenderGovernor: %i", enabled);
+}
+
+template <typename Policy>
+bool RadioRenderCore<Policy>::getRenderGovernor() const {
+    return mGovernor.getEnabled();
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::setRenderGovernorDecoderCap(bool capDecoders) {
+    mGovernor.setDecoderCapping(capDecoders);
+    LOG(Policy::logName(), "setRenderGovernorDecoderCap: %i", capDecoders);
+}
+
+template <typename Policy>
+bool RadioRenderCore<Policy>::getRenderGovernorDecoderCap() const {
+    return mGovernor.getDecoderCapping();
+}
+
+template <typename Policy>
+void RadioRenderCore<Policy>::setRenderBudget(unsigned int budgetUs) {
+    mGovernor.setBudgetNs(static_cast<uint64_t>(budgetUs) * 1000);
+    LOG(Policy::logName(), "setRenderBudget: %u us", budgetUs);
+}
+
+template <typename Policy>
+unsigned int RadioRenderCore<Policy>::getRenderBudget() const {
+    return static_cast<unsigned int>(mGovernor.getBudgetNs() / 1000);
+}
+
+template <typename Policy>
+RenderTier RadioRenderCore<Policy>::getRenderTier() const {
+    return mGovernor.getTier();
+}
+
+template <typename Policy>
+uint64_t RadioRenderCore<Policy>::getRenderOverruns() const {
+    return mGovernor.Overruns.load();
+}
+
+template <typename Policy>
+uint64_t RadioRenderCore<Policy>::getRenderTierChanges() const {
+    return mGovernor.TierChanges.load();
+}
+
+namespace afv_native { namespace afv {
+    template class RadioRenderCore<AtcRenderPolicy>;
+    template class RadioRenderCore<PilotRenderPolicy>;
+}} // namespace afv_native::afv
@@ -34,8 +34,8 @@
 #include "afv-native/afv/RadioSimulation.h"
 #include "afv-native/Log.h"
 #include "afv-native/afv/dto/voice_server/AudioTxOnTransceivers.h"
-#include "afv-native/audio/PinkNoiseGenerator.h"
-#include "afv-native/audio/VHFFilterSource.h"
+#include "afv-native/audio/kernels.h"
+#include <algorithm>
 #include <atomic>
 #include <cmath>
 #include <iostream>
@@ -43,18 +43,8 @@
 using namespace afv_native;
 using namespace afv_native::afv;
 
-const float  fxClickGain         = 1.3f;
-const float  fxBlockToneGain     = 0.25f;
-const float  fxBlockToneFreq     = 180.0f;
-const float  fxAcBusGain         = 0.005f;
-const float  fxVhfWhiteNoiseGain = 0.17f;
-const float  fxHfWhiteNoiseGain  = 0.16f;
-const double minDb               = -40.0;
-const double maxDb               = 0.0;
-
-CallsignMeta::CallsignMeta(): source(), transceivers() {
-    source = std::make_shared<RemoteVoiceSource>();
-}
+const double minDb = -40.0;
+const double maxDb = 0.0;
 
 OutputAudioDevice::OutputAudioDevice(std::weak_ptr<RadioSimulation> radio, bool onHeadset):
     mRadio(radio), onHeadset(onHeadset) {
@@ -64,11 +54,26 @@ audio::SourceStatus OutputAudioDevice::getAudioFrame(audio::SampleType *bufferOu
     return mRadio.lock()->getAudioFrame(bufferOut, onHeadset);
 }
 
+audio::SourceStatus OutputAudioDevice::getAudioSamples(audio::SampleType *bufferOut, size_t numSamples) {
+    return mRadio.lock()->getAudioSamples(bufferOut, numSamples, onHeadset);
+}
+
+bool OutputAudioDevice::partialFrames() const {
+    return true;
+}
+
 RadioSimulation::RadioSimulation(struct event_base *evBase, std::shared_ptr<EffectResources> resources, cryptodto::UDPChannel *channel, unsigned int radioCount):
-    IncomingAudioStreams(0), mEvBase(evBase), mResources(std::move(resources)), mChannel(), mStreamMapLock(), mHeadsetIncomingStreams(), mSpeakerIncomingStreams(), mRadioStateLock(), mPtt(false), mLastFramePtt(false), mTxRadio(0), mTxSequence(0), mRadioState(radioCount), mVoiceSink(std::make_shared<VoiceCompressionSink>(*this)), mVoiceFilter(), mMaintenanceTimer(mEvBase, std::bind(&RadioSimulation::maintainIncomingStreams, this)), mVuMeter(300 / audio::frameLengthMs) // VU is a 300ms zero to peak response...
+    RadioRenderCore(*resources), mEvBase(evBase), mResources(std::move(resources)), mChannel(), mRadioStateLock(), mLastFramePtt(false), mTxRadio(0), mTxSequence(0), mRadioState(radioCount), mSplitChannels(false), mVoiceSink(std::make_shared<VoiceCompressionSink>(*this)), mVoiceFilter(), mMaintenanceTimer(mEvBase, std::bind(&RadioSimulation::maintainIncomingStreams, this)), mVuMeter(300 / audio::frameLengthMs) // VU is a 300ms zero to peak response...
 {
     setUDPChannel(channel);
-    mMaintenanceTimer.enable(maintenanceTimerIntervalMs);
+    {
+        std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
+        for (auto &radio: mRadioState) {
+            radio.dsp = make_radio_dsp(HardwareType::Schmid_ED_137B);
+        }
+        publish_radio_config();
+    }
+    mMaintenanceTimer.enable(expiryTickMs);
 }
 
 RadioSimulation::~RadioSimulation() {
@@ -78,27 +83,12 @@ void RadioSimulation::putAudioFrame(const audio::SampleType *bufferIn) {
     audio::SampleType samples[audio::frameSizeSamples];
     mVoiceFilter->transformFrame(samples, bufferIn);
 
-    float value = 0;
-    for (int i = 0; i < audio::frameSizeSamples; i++) {
-        value = samples[i] * mMicVolume;
-        if (value > 1.0f) {
-            value = 1.0f;
-        }
-        if (value < -1.0f) {
-            value = -1.0f;
-        }
-        samples[i] = value;
-    }
+    audio::kernels::scaleClamp(samples, samples, mMicVolume);
 
     // do the peak/Vu calcs
     {
-        auto             *b    = samples;
-        int               i    = audio::frameSizeSamples - 1;
-        audio::SampleType peak = fabs(*(b++));
-        while (i-- > 0) {
-            peak = std::max<audio::SampleType>(peak, fabs(*(b++)));
-        }
-        double peakDb = 20.0 * log10(peak);
+        audio::SampleType peak   = audio::kernels::levels(samples).peak;
+        double            peakDb = 20.0 * log10(peak);
         peakDb        = std::max(minDb, peakDb);
         peakDb        = std::min(maxDb, peakDb);
         double ratio  = (peakDb - minDb) / (maxDb - minDb);
@@ -120,7 +110,7 @@ void RadioSimulation::putAudioFrame(const audio::SampleType *bufferIn) {
     mVoiceSink->putAudioFrame(samples);
 }
 
-void RadioSimulation::processCompressedFrame(std::vector<unsigned char> compressedData) {
+void RadioSimulation::processCompressedFrame(const std::vector<unsigned char> &compressedData) {
     if (mChannel != nullptr && mChannel->isOpen()) {
         dto::AudioTxOnTransceivers audioOutDto;
         {
@@ -138,15 +128,18 @@ void RadioSimulation::processCompressedFrame(std::vector<unsigned char> compress
         }
         audioOutDto.SequenceCounter = std::atomic_fetch_add<uint32_t>(&mTxSequence, 1);
         audioOutDto.Callsign        = mCallsign;
-        audioOutDto.Audio           = std::move(compressedData);
+        audioOutDto.Audio           = compressedData;
         mChannel->sendDto(audioOutDto);
     }
 }
 
-void RadioSimulation::mix_buffers(audio::SampleType *RESTRICT src_dst, const audio::SampleType *RESTRICT src2, float src2_gain) {
-    for (int i = 0; i < audio::frameSizeSamples; i++) {
-        src_dst[i] += (src2_gain * src2[i]);
+bool RadioSimulation::skipCompressedFrame() {
+    if (!mPtt.load()) {
+        return false;
     }
+    mLastFramePtt = true;
+    std::atomic_fetch_add<uint32_t>(&mTxSequence, 1);
+    return true;
 }
 
 bool RadioSimulation::getTxActive(unsigned int radio) {
@@ -158,221 +151,61 @@ bool RadioSimulation::getTxActive(unsigned int radio) {
 
 bool RadioSimulation::getRxActive(unsigned int radio) {
     std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-
-    return (mRadioState[radio].mLastRxCount > 0);
-}
-
-inline bool freqIsHF(unsigned int freq) {
-    return freq < 30000000;
-}
-
-bool RadioSimulation::_process_radio(const std::map<void *, audio::SampleType[audio::frameSizeSamples]> &sampleCache, size_t rxIter, bool onHeadset) {
-    std::shared_ptr<OutputDeviceState> state = onHeadset ? mHeadsetState : mSpeakerState;
-
-    ::memset(state->mChannelBuffer, 0, audio::frameSizeBytes);
-    if (mPtt.load() && mTxRadio == rxIter) {
-        // don't analyze and mix-in the radios transmitting, but suppress the
-        // effects.
-        resetRadioFx(rxIter);
-        return true;
-    }
-    // now, find all streams that this applies to.
-    float    crackleGain       = 0.0f;
-    float    hfGain            = 0.0f;
-    float    vhfGain           = 0.0f;
-    float    acBusGain         = 0.0f;
-    uint32_t concurrentStreams = 0;
-    for (auto &srcPair: (onHeadset ? mHeadsetIncomingStreams : mSpeakerIncomingStreams)) {
-        if (!srcPair.second.source || !srcPair.second.source->isActive() ||
-            (sampleCache.find(srcPair.second.source.get()) == sampleCache.end())) {
-            continue;
-        }
-        bool  mUseStream = false;
-        float voiceGain  = 1.0f;
-        for (const afv::dto::RxTransceiver &tx: srcPair.second.transceivers) {
-            if (tx.Frequency == mRadioState[rxIter].Frequency) {
-                mUseStream = true;
-
-                float crackleFactor = 0.0f;
-                if (!mRadioState[rxIter].mBypassEffects) {
-                    crackleFactor = static_cast<float>((exp(tx.DistanceRatio) * pow(tx.DistanceRatio, -4.0) / 350.0) - 0.00776652);
-                    crackleFactor = fmax(0.0f, crackleFactor);
-                    crackleFactor = fmin(0.20f, crackleFactor);
-
-                    if (freqIsHF(tx.Frequency)) {
-                        if (!mRadioState[rxIter].mHfSquelch) {
-                            hfGain = fxHfWhiteNoiseGain;
-                        } else {
-                            hfGain = 0.0f;
-                        }
-                        vhfGain   = 0.0f;
-                        acBusGain = 0.001f;
-                        voiceGain = 0.20f;
-                    } else {
-                        hfGain    = 0.0f;
-                        vhfGain   = fxVhfWhiteNoiseGain;
-                        acBusGain = fxAcBusGain;
-                        crackleGain += crackleFactor * 2;
-                        voiceGain = 1.0 - crackleFactor * 3.7;
-                    }
-                }
-                break; // matched once.  dont' bother anymore.
-            }
-        }
-        if (mUseStream) {
-            // then include this stream.
-            try {
-                mix_buffers(state->mChannelBuffer, sampleCache.at(srcPair.second.source.get()),
-                            voiceGain * mRadioState[rxIter].Gain);
-                concurrentStreams++;
-            } catch (const std::out_of_range &) {
-                LOG("RadioSimulation", "internal error:  Tried to mix uncached stream");
-            }
-        }
-    }
-
-    if (concurrentStreams > 0) {
-        if (!mRadioState[rxIter].mBypassEffects) {
-            // limiter effect
-            for (unsigned int i = 0; i < audio::frameSizeSamples; i++) {
-                if (state->mChannelBuffer[i] > 1.0f) {
-                    state->mChannelBuffer[i] = 1.0f;
-                }
-                if (state->mChannelBuffer[i] < -1.0f) {
-                    state->mChannelBuffer[i] = -1.0f;
-                }
-            }
-
-            mRadioState[rxIter].vhfFilter.transformFrame(state->mChannelBuffer, state->mChannelBuffer);
-            mRadioState[rxIter].simpleCompressorEffect.transformFrame(state->mChannelBuffer, state->mChannelBuffer);
-
-            set_radio_effects(rxIter);
-            if (!mix_effect(mRadioState[rxIter].Crackle, crackleGain * mRadioState[rxIter].Gain, state)) {
-                mRadioState[rxIter].Crackle.reset();
-            }
-            if (!mix_effect(mRadioState[rxIter].HfWhiteNoise, hfGain * mRadioState[rxIter].Gain, state)) {
-                mRadioState[rxIter].HfWhiteNoise.reset();
-            }
-            if (!mix_effect(mRadioState[rxIter].VhfWhiteNoise, vhfGain * mRadioState[rxIter].Gain, state)) {
-                mRadioState[rxIter].VhfWhiteNoise.reset();
-            }
-            if (!mix_effect(mRadioState[rxIter].AcBus, acBusGain * mRadioState[rxIter].Gain, state)) {
-                mRadioState[rxIter].AcBus.reset();
-            }
-        } // bypass effects
-        if (concurrentStreams > 1) {
-            if (!mRadioState[rxIter].BlockTone) {
-                mRadioState[rxIter].BlockTone = std::make_shared<audio::SineToneSource>(fxBlockToneFreq);
-            }
-            if (!mix_effect(mRadioState[rxIter].BlockTone, fxBlockToneGain * mRadioState[rxIter].Gain, state)) {
-                mRadioState[rxIter].BlockTone.reset();
-            }
-        } else {
-            if (mRadioState[rxIter].BlockTone) {
-                mRadioState[rxIter].BlockTone.reset();
-            }
-        }
-    } else {
-        resetRadioFx(rxIter, true);
-        if (mRadioState[rxIter].mLastRxCount > 0) {
-            mRadioState[rxIter].Click = std::make_shared<audio::RecordedSampleSource>(mResources->mClick, false);
-        }
-    }
-    mRadioState[rxIter].mLastRxCount = concurrentStreams;
-
-    // if we have a pending click, play it.
-    if (!mix_effect(mRadioState[rxIter].Click, fxClickGain * mRadioState[rxIter].Gain, state)) {
-        mRadioState[rxIter].Click.reset();
-    }
-
-    // now, finally, mix the channel buffer into the mixing buffer.
-    if (mSplitChannels) {
-        if (rxIter == 0) {
-            mix_buffers(state->mLeftMixingBuffer, state->mChannelBuffer);
-        } else if (rxIter == 1) {
-            mix_buffers(state->mRightMixingBuffer, state->mChannelBuffer);
-        }
-    } else {
-        mix_buffers(state->mMixingBuffer, state->mChannelBuffer);
+    if (radio >= mRadioState.size()) {
+        return false;
     }
 
-    return false;
+    return (mRadioState[radio].dsp->mLastRxCount.load() > 0);
 }
 
 audio::SourceStatus RadioSimulation::getAudioFrame(audio::SampleType *bufferOut, bool onHeadset) {
-    std::shared_ptr<OutputDeviceState> state = onHeadset ? mHeadsetState : mSpeakerState;
+    return getAudioSamples(bufferOut, audio::frameSizeSamples, onHeadset);
+}
 
-    std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-    std::lock_guard<std::mutex> streamGuard(mStreamMapLock);
-
-    std::map<void *, audio::SampleType[audio::frameSizeSamples]> sampleCache;
-    for (auto &src: (onHeadset ? mHeadsetIncomingStreams : mSpeakerIncomingStreams)) {
-        if (src.second.source && src.second.source->isActive() &&
-            (sampleCache.find(src.second.source.get()) == sampleCache.end())) {
-            const auto rv = src.second.source->getAudioFrame(sampleCache[src.second.source.get()]);
-            if (rv != audio::SourceStatus::OK) {
-                sampleCache.erase(src.second.source.get());
-            }
-        }
+audio::SourceStatus RadioSimulation::getAudioSamples(audio::SampleType *bufferOut, size_t numSamples, bool onHeadset) {
+    const OutputBus bus = onHeadset ? BusHeadset : BusSpeaker;
+    if (mSplitChannels.load()) {
+        return render_bus(bus, bufferOut, numSamples);
     }
-
-    ::memset(state->mLeftMixingBuffer, 0, sizeof(audio::SampleType) * audio::frameSizeSamples);
-    ::memset(state->mRightMixingBuffer, 0, sizeof(audio::SampleType) * audio::frameSizeSamples);
-    ::memset(state->mMixingBuffer, 0, sizeof(audio::SampleType) * audio::frameSizeSamples);
-
-    size_t rxIter = 0;
-    for (rxIter = 0; rxIter < mRadioState.size(); rxIter++) {
-        if (mRadioState[rxIter].onHeadset == onHeadset) {
-            _process_radio(sampleCache, rxIter, onHeadset);
+    // without split channels every radio is mixed on the left, so that's the mono mix.
+    audio::SampleType stereo[audio::frameSizeSamples * 2];
+    for (size_t done = 0; done < numSamples;) {
+        const size_t count = std::min<size_t>(numSamples - done, audio::frameSizeSamples);
+        render_bus(bus, stereo, count);
+        for (size_t i = 0; i < count; i++) {
+            bufferOut[done + i] = stereo[i * 2];
         }
+        done += count;
     }
-
-    if (mSplitChannels) {
-        audio::SampleType interleavedSamples[audio::frameSizeSamples * 2];
-        interleave(state->mLeftMixingBuffer, state->mRightMixingBuffer, interleavedSamples, audio::frameSizeSamples);
-        ::memcpy(bufferOut, interleavedSamples, sizeof(audio::SampleType) * audio::frameSizeSamples * 2);
-    } else {
-        ::memcpy(bufferOut, state->mMixingBuffer, sizeof(audio::SampleType) * audio::frameSizeSamples);
-    }
-
     return audio::SourceStatus::OK;
 }
 
-void RadioSimulation::set_radio_effects(size_t rxIter) {
-    if (!mRadioState[rxIter].VhfWhiteNoise) {
-        mRadioState[rxIter].VhfWhiteNoise = std::make_shared<audio::RecordedSampleSource>(mResources->mVhfWhiteNoise, true);
-    }
-    if (!mRadioState[rxIter].HfWhiteNoise) {
-        mRadioState[rxIter].HfWhiteNoise = std::make_shared<audio::RecordedSampleSource>(mResources->mHfWhiteNoise, true);
-    }
-    if (!mRadioState[rxIter].Crackle) {
-        mRadioState[rxIter].Crackle = std::make_shared<audio::RecordedSampleSource>(mResources->mCrackle, true);
-    }
-    if (!mRadioState[rxIter].AcBus) {
-        mRadioState[rxIter].AcBus = std::make_shared<audio::RecordedSampleSource>(mResources->mAcBus, true);
-    }
-}
-
-bool RadioSimulation::mix_effect(std::shared_ptr<audio::ISampleSource> effect, float gain, std::shared_ptr<OutputDeviceState> state) {
-    if (effect && gain > 0.0f) {
-        auto rv = effect->getAudioFrame(state->mFetchBuffer);
-        if (rv == audio::SourceStatus::OK) {
-            RadioSimulation::mix_buffers(state->mChannelBuffer, state->mFetchBuffer, gain);
-        } else {
-            return false;
+void RadioSimulation::publish_radio_config() {
+    auto snapshot = std::make_unique<RenderConfigSnapshot>();
+    snapshot->radios.reserve(mRadioState.size());
+    snapshot->dspOwners.reserve(mRadioState.size());
+    const bool split = mSplitChannels.load();
+    for (size_t i = 0; i < mRadioState.size(); i++) {
+        const RadioState &radio     = mRadioState[i];
+        float             leftGain  = 1.0f;
+        float             rightGain = 0.0f;
+        if (split) {
+            leftGain  = i == 0 ? 1.0f : 0.0f;
+            rightGain = i == 1 ? 1.0f : 0.0f;
         }
+        snapshot->radios.push_back({radio.dsp.get(), radio.Frequency, radio.Gain, leftGain, rightGain,
+                                    radio.onHeadset ? BusHeadset : BusSpeaker, radio.mBypassEffects,
+                                    radio.mHfSquelch, i == mTxRadio});
+        snapshot->dspOwners.push_back(radio.dsp);
+        snapshot->rxFrequencies.push_back(radio.Frequency);
     }
-    return true;
+    std::sort(snapshot->rxFrequencies.begin(), snapshot->rxFrequencies.end());
+    mRadioConfig.publish(std::move(snapshot));
 }
 
 void RadioSimulation::rxVoicePacket(const afv::dto::AudioRxOnTransceivers &pkt) {
-    std::lock_guard<std::mutex> streamMapLock(mStreamMapLock);
     // FIXME:  Deal with the case of a single-callsign transmitting multiple different voicestreams simultaneously.
-    mHeadsetIncomingStreams[pkt.Callsign].source->appendAudioDTO(pkt);
-    mHeadsetIncomingStreams[pkt.Callsign].transceivers = pkt.Transceivers;
-
-    mSpeakerIncomingStreams[pkt.Callsign].source->appendAudioDTO(pkt);
-    mSpeakerIncomingStreams[pkt.Callsign].transceivers = pkt.Transceivers;
+    ingest_packet(pkt);
 }
 
 void RadioSimulation::setFrequency(unsigned int radio, unsigned int frequency) {
@@ -383,31 +216,23 @@ void RadioSimulation::setFrequency(unsigned int radio, unsigned int frequency) {
     if (mRadioState[radio].Frequency == frequency) {
         return;
     }
+    // the render resets the radio's effects when it sees the new frequency.
     mRadioState[radio].Frequency = frequency;
-    // reset all of the effects, except the click which should be audiable due to the Squelch-gate kicking in on the new frequency
-    resetRadioFx(radio, true);
+    publish_radio_config();
     LOG("RadioSimulation", "setFrequency: %i: %i", radio, frequency);
 }
 
-void RadioSimulation::resetRadioFx(unsigned int radio, bool except_click) {
-    if (!except_click) {
-        mRadioState[radio].Click.reset();
-        mRadioState[radio].mLastRxCount = 0;
-    }
-    mRadioState[radio].BlockTone.reset();
-    mRadioState[radio].Crackle.reset();
-    mRadioState[radio].VhfWhiteNoise.reset();
-    mRadioState[radio].HfWhiteNoise.reset();
-    mRadioState[radio].AcBus.reset();
-}
-
 void RadioSimulation::setPtt(bool pressed) {
     mPtt.store(pressed);
 }
 
 void RadioSimulation::setGain(unsigned int radio, float gain) {
     std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
+    if (radio >= mRadioState.size()) {
+        return;
+    }
     mRadioState[radio].Gain = gain;
+    publish_radio_config();
     LOG("RadioSimulation", "setGain: %i: %f", radio, gain);
 }
 
@@ -417,6 +242,7 @@ void RadioSimulation::setTxRadio(unsigned int radio) {
         return;
     }
     mTxRadio = radio;
+    publish_radio_config();
     LOG("RadioSimulation", "setTxRadio: %i", radio);
 }
 
@@ -464,27 +290,11 @@ void RadioSimulation::setUDPChannel(cryptodto::UDPChannel *newChannel) {
 }
 
 void RadioSimulation::maintainIncomingStreams() {
-    std::lock_guard<std::mutex> ml(mStreamMapLock);
-    std::vector<std::string>    callsignsToPurge;
-    std::vector<std::string>    speakerCallsignsToPurge;
-    util::monotime_t            now = util::monotime_get();
-    for (const auto &streamPair: mHeadsetIncomingStreams) {
-        if ((now - streamPair.second.source->getLastActivityTime()) > audio::compressedSourceCacheTimeoutMs) {
-            callsignsToPurge.emplace_back(streamPair.first);
-        }
+    expire_streams();
+    if (mFecPacketLoss.load() < 0) {
+        mVoiceSink->setPacketLoss(static_cast<int>(getMeasuredPacketLoss()));
     }
-    for (const auto &streamPair: mSpeakerIncomingStreams) {
-        if ((now - streamPair.second.source->getLastActivityTime()) > audio::compressedSourceCacheTimeoutMs) {
-            speakerCallsignsToPurge.emplace_back(streamPair.first);
-        }
-    }
-    for (const auto &callsign: callsignsToPurge) {
-        mHeadsetIncomingStreams.erase(callsign);
-    }
-    for (const auto &callsign: speakerCallsignsToPurge) {
-        mSpeakerIncomingStreams.erase(callsign);
-    }
-    mMaintenanceTimer.enable(maintenanceTimerIntervalMs);
+    mMaintenanceTimer.enable(expiryTickMs);
 }
 
 void RadioSimulation::setCallsign(const std::string &newCallsign) {
@@ -492,11 +302,7 @@ void RadioSimulation::setCallsign(const std::string &newCallsign) {
 }
 
 void RadioSimulation::reset() {
-    {
-        std::lock_guard<std::mutex> ml(mStreamMapLock);
-        mHeadsetIncomingStreams.clear();
-        mSpeakerIncomingStreams.clear();
-    }
+    reset_streams();
     mTxSequence.store(0);
     mPtt.store(false);
     mLastFramePtt = false;
@@ -531,6 +337,7 @@ void RadioSimulation::setEnableOutputEffects(bool enableEffects) {
     for (auto &thisRadio: mRadioState) {
         thisRadio.mBypassEffects = !enableEffects;
     }
+    publish_radio_config();
 }
 
 void RadioSimulation::setEnableHfSquelch(bool enableSquelch) {
@@ -538,24 +345,65 @@ void RadioSimulation::setEnableHfSquelch(bool enableSquelch) {
     for (auto &thisRadio: mRadioState) {
         thisRadio.mHfSquelch = enableSquelch;
     }
+    publish_radio_config();
 }
 
 void RadioSimulation::setupDevices(util::ChainedCallback<void(ClientEventType, void *, void *)> *eventCallback) {
     mHeadsetDevice = std::make_shared<OutputAudioDevice>(shared_from_this(), true);
     mSpeakerDevice = std::make_shared<OutputAudioDevice>(shared_from_this(), false);
 
-    mHeadsetState = std::make_shared<OutputDeviceState>();
-    mSpeakerState = std::make_shared<OutputDeviceState>();
-
     ClientEventCallback = eventCallback;
 }
 
 void RadioSimulation::setOnHeadset(unsigned int radio, bool onHeadset) {
     std::lock_guard<std::mutex> mRadioStateGuard(mRadioStateLock);
+    if (radio >= mRadioState.size()) {
+        return;
+    }
     mRadioState[radio].onHeadset = onHeadset;
+    publish_radio_config();
+}
+
+void RadioSimulation::setReducedRateDsp(bool reduced) {
+    if (!set_reduced_rate(reduced)) {
+        return;
+    }
+    std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
+    for (auto &radio: mRadioState) {
+        radio.dsp = make_radio_dsp(HardwareType::Schmid_ED_137B);
+    }
+    publish_radio_config();
+    LOG("RadioSimulation", "setReducedRateDsp: %i", reduced);
+}
+
+void RadioSimulation::setFecPacketLoss(int percent) {
+    mFecPacketLoss.store(percent);
+    setMeasurePacketLoss(percent < 0);
+    mVoiceSink->setPacketLoss(percent < 0 ? static_cast<int>(getMeasuredPacketLoss()) : percent);
+    LOG("RadioSimulation", "setFecPacketLoss: %i", percent);
+}
+
+void RadioSimulation::setEncoderProfile(const EncoderProfile &profile) {
+    mVoiceSink->setProfile(profile);
+    LOG("RadioSimulation", "setEncoderProfile: %d bps, complexity %d, %s, dtx %i, signal %d, max bandwidth %d",
+        profile.bitrate, profile.complexity, profile.vbr ? "vbr" : "cbr", profile.dtx, profile.signal, profile.maxBandwidth);
+}
+
+bool RadioSimulation::setRenderQuantum(size_t quantum) {
+    if (!set_render_quantum(quantum)) {
+        return getRenderQuantum() == quantum;
+    }
+    std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
+    for (auto &radio: mRadioState) {
+        radio.dsp = make_radio_dsp(HardwareType::Schmid_ED_137B);
+    }
+    publish_radio_config();
+    LOG("RadioSimulation", "setRenderQuantum: %zu", quantum);
+    return true;
 }
 
 void RadioSimulation::setSplitAudioChannels(bool splitChannels) {
     std::lock_guard<std::mutex> mRadioStateGuard(mRadioStateLock);
-    mSplitChannels = splitChannels;
+    mSplitChannels.store(splitChannels);
+    publish_radio_config();
 }
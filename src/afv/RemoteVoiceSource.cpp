@@ -43,16 +43,10 @@ using namespace afv_native::audio;
 using namespace afv_native;
 using namespace std;
 
-RemoteVoiceSource::RemoteVoiceSource():
-    mJitterBufferMutex(), mIsActive(false), mSilentFrames(0), mEnding(false), mEndingSequence(0), mCurrentFrame(0) {
-    mJitterBuffer = jitter_buffer_init(1);
-    jitter_buffer_ctl(mJitterBuffer, JITTER_BUFFER_SET_DESTROY_CALLBACK, reinterpret_cast<void *>(::free));
-
-    // spx_uint32_t jitterMargin = 0;
-    // jitter_buffer_ctl(mJitterBuffer, JITTER_BUFFER_SET_MARGIN, &jitterMargin);
-
+RemoteVoiceSource::RemoteVoiceSource(int sampleRate):
+    mJitterBuffer(frameTimeOut), mActivity(0), mIdleActivity(0), mLastActive(0), mFlushPending(false), mDecoded(frameSizeSamples, 1), mIdle(true), mSampleRate(sampleRate), mFrameSamples(sampleRate * frameLengthMs / 1000) {
     int opus_status;
-    mDecoder = opus_decoder_create(sampleRateHz, 1, &opus_status);
+    mDecoder = opus_decoder_create(mSampleRate, 1, &opus_status);
     if (opus_status != OPUS_OK) {
         LOG("instreambuffer", "Got error initialising Opus Codec: %s", opus_strerror(opus_status));
         mDecoder = nullptr;
@@ -64,78 +58,57 @@ RemoteVoiceSource::~RemoteVoiceSource() {
         opus_decoder_destroy(mDecoder);
         mDecoder = nullptr;
     }
-    jitter_buffer_destroy(mJitterBuffer);
-    mJitterBuffer = nullptr;
 }
 
 void RemoteVoiceSource::appendAudioDTO(const dto::IAudio &audio) {
-    JitterBufferPacket newPacket;
-    ::memset(&newPacket, 0, sizeof(newPacket));
-
-    if (audio.LastPacket) {
-        mEnding         = true;
-        mEndingSequence = audio.SequenceCounter;
-    } else {
-        mEnding = false;
-    }
-
-    auto currentTime = util::monotime_get();
-    if((currentTime - mLastActive) > 500) {
-        flush();
-    }
+    appendAudioDTO(audio, util::monotime_get());
+}
 
-    newPacket.data = static_cast<char *>(::malloc(audio.Audio.size()));
-    memcpy(newPacket.data, audio.Audio.data(), audio.Audio.size());
-    newPacket.len       = audio.Audio.size();
-    newPacket.timestamp = audio.SequenceCounter;
-    newPacket.span      = 1;
-    {
-        std::lock_guard<std::mutex> lock(mJitterBufferMutex);
-
-        jitter_buffer_put(mJitterBuffer, &newPacket);
-        mSilentFrames = 0;
-        mLastActive = currentTime;
-    }
-    mIsActive = true;
+void RemoteVoiceSource::appendAudioDTO(const dto::IAudio &audio, util::monotime_t arrivalMs) {
+    mJitterBuffer.put(audio.SequenceCounter, audio.Audio.data(), audio.Audio.size(), audio.LastPacket, arrivalMs);
+    mLastActive = arrivalMs;
+    mActivity.fetch_add(1, std::memory_order_release);
 }
 
 SourceStatus RemoteVoiceSource::getAudioFrame(SampleType *bufferOut) {
-    SourceStatus       rv = SourceStatus::OK;
-    JitterBufferPacket pktOut;
-    ::memset(&pktOut, 0, sizeof(pktOut));
-
-    spx_int32_t tsOut;
-    int         jitter_status;
-    int         opus_res = OPUS_OK;
-    {
-        std::lock_guard<std::mutex> lock(mJitterBufferMutex);
-        jitter_status = jitter_buffer_get(mJitterBuffer, &pktOut, 1, &tsOut);
+    if (mFlushPending.exchange(false)) {
+        mJitterBuffer.reset();
+        mIdle = true;
     }
+
+    // taken before the jitter buffer is looked at, so anything appended after it isn't
+    // mistaken for having been seen.
+    const uint64_t activity = mActivity.load(std::memory_order_acquire);
+    SourceStatus   rv       = SourceStatus::OK;
+    size_t         len      = 0;
+    const auto     result   = mJitterBuffer.get(mPacket, len);
+    int          opus_res = OPUS_OK;
+    if (mIdle && result != JitterBuffer::Result::Idle && mDecoder != nullptr) {
+        // a new transmission - don't let it pick up from the end of the last one.
+        opus_decoder_ctl(mDecoder, OPUS_RESET_STATE);
+    }
+    mIdle = result == JitterBuffer::Result::Idle;
     if (mDecoder != nullptr) {
-        switch (jitter_status) {
-            case JITTER_BUFFER_MISSING:
-                mCurrentFrame++;
-                if (mEnding && (mCurrentFrame >= mEndingSequence)) {
-                    ::memset(bufferOut, 0, frameSizeSamples * sizeof(SampleType));
-                    rv = SourceStatus::Closed;
-                } else {
-                    // prod opus to perform gap compensation.
-                    opus_res = opus_decode_float(mDecoder, nullptr, 0, bufferOut, frameSizeSamples, false);
-                }
+        switch (result) {
+            case JitterBuffer::Result::Packet:
+                opus_res = opus_decode_float(mDecoder, mPacket, static_cast<opus_int32>(len), bufferOut, mFrameSamples, false);
                 break;
-            case JITTER_BUFFER_INSERTION:
-                // insert silence.
-                ::memset(bufferOut, 0, frameSizeSamples * sizeof(SampleType));
+            case JitterBuffer::Result::Recover:
+                // rebuild the lost frame from the redundant copy carried by the next packet.
+                // If the sender didn't turn FEC on, opus conceals it instead.
+                opus_res = opus_decode_float(mDecoder, mPacket, static_cast<opus_int32>(len), bufferOut, mFrameSamples, true);
+                break;
+            case JitterBuffer::Result::Conceal:
+                // prod opus to perform gap compensation.
+                opus_res = opus_decode_float(mDecoder, nullptr, 0, bufferOut, mFrameSamples, false);
                 break;
-            case JITTER_BUFFER_OK:
-                mCurrentFrame = tsOut;
-                opus_res = opus_decode_float(mDecoder, reinterpret_cast<unsigned char *>(pktOut.data),
-                                             pktOut.len, bufferOut, frameSizeSamples, false);
-                ::free(pktOut.data);
+            case JitterBuffer::Result::Waiting:
+                // insert silence.
+                ::memset(bufferOut, 0, mFrameSamples * sizeof(SampleType));
                 break;
-            default:
-                LOG("instreambuffer", "Got Error return from the jitter buffer: %d", jitter_status);
-                rv = SourceStatus::Error;
+            case JitterBuffer::Result::Idle:
+                ::memset(bufferOut, 0, mFrameSamples * sizeof(SampleType));
+                rv = SourceStatus::Closed;
                 break;
         }
         if (opus_res < 0) {
@@ -143,43 +116,73 @@ SourceStatus RemoteVoiceSource::getAudioFrame(SampleType *bufferOut) {
         }
     } else {
         // codec is broken - insert silence.
-        memset(bufferOut, 0, frameSizeSamples * sizeof(SampleType));
+        memset(bufferOut, 0, mFrameSamples * sizeof(SampleType));
         rv = SourceStatus::Error;
     }
-    {
-        std::lock_guard<std::mutex> lock(mJitterBufferMutex);
-        jitter_buffer_tick(mJitterBuffer);
-        // if we don't have a terminally flagged marker, check for timeouts.
-        spx_int32_t bufCount = 0;
-        jitter_buffer_ctl(mJitterBuffer, JITTER_BUFFER_GET_AVAILABLE_COUNT, &bufCount);
-        if (bufCount == 0) {
-            mSilentFrames += 1;
-            if (mSilentFrames > frameTimeOut) {
-                if (rv != SourceStatus::Error) {
-                    rv = SourceStatus::Closed;
-                }
-            }
-        }
-    }
     if (rv != SourceStatus::OK) {
-        mIsActive = false;
+        mIdleActivity.store(activity, std::memory_order_release);
     }
     return rv;
 }
 
-void RemoteVoiceSource::flush() {
-    {
-        std::lock_guard<std::mutex> lock(mJitterBufferMutex);
-        // this nukes the jitter buffer contents, without resetting the latency timers.
-        jitter_buffer_reset(mJitterBuffer);
+bool RemoteVoiceSource::decodeAhead() {
+    // the ring only holds one frame: any further ahead and the jitter buffer would be asked
+    // for packets before they're due.
+    if (!mDecoded.empty() || !isActive()) {
+        return false;
     }
-    opus_decoder_ctl(mDecoder, OPUS_RESET_STATE);
+    SampleType *frame = mDecoded.writeFrame();
+    if (frame == nullptr || getAudioFrame(frame) != SourceStatus::OK) {
+        return false;
+    }
+    mDecoded.commitFrame(mFrameSamples);
+    return true;
+}
+
+bool RemoteVoiceSource::readDecodedFrame(SampleType *bufferOut) {
+    return mDecoded.readFrame(bufferOut) != 0;
+}
+
+void RemoteVoiceSource::dropDecodedFrames() {
+    mDecoded.clear();
+}
+
+void RemoteVoiceSource::reset(int sampleRate) {
+    if (mDecoder != nullptr) {
+        int opus_status = sampleRate == mSampleRate ? opus_decoder_ctl(mDecoder, OPUS_RESET_STATE) : opus_decoder_init(mDecoder, sampleRate, 1);
+        if (opus_status != OPUS_OK) {
+            LOG("instreambuffer", "Got error resetting Opus Codec: %s", opus_strerror(opus_status));
+            opus_decoder_destroy(mDecoder);
+            mDecoder = nullptr;
+        }
+    }
+    mSampleRate   = sampleRate;
+    mFrameSamples = sampleRate * frameLengthMs / 1000;
+    mJitterBuffer.clear();
+    mDecoded.clear();
+    mActivity     = 0;
+    mIdleActivity = 0;
+    mLastActive   = 0;
+    mFlushPending = false;
+    mIdle         = true;
+}
+
+void RemoteVoiceSource::flush() {
+    mFlushPending = true;
 }
 
 bool RemoteVoiceSource::isActive() const {
-    return mIsActive;
+    return mActivity.load(std::memory_order_acquire) != mIdleActivity.load(std::memory_order_acquire);
 }
 
 util::monotime_t RemoteVoiceSource::getLastActivityTime() const {
     return mLastActive;
 }
+
+int RemoteVoiceSource::getSampleRate() const {
+    return mSampleRate;
+}
+
+const JitterBuffer &RemoteVoiceSource::getJitterBuffer() const {
+    return mJitterBuffer;
+}
@@ -0,0 +1,109 @@
+#include "afv-native/afv/RenderGovernor.h"
+
+using namespace afv_native::afv;
+
+namespace {
+    /** weight of the newest tick in the moving average */
+    const double averageWeight = 1.0 / 16.0;
+    /** the average has to reach this fraction of the budget to step down, and stay under
+     * recoverFraction of it to step back up */
+    const double pressureFraction = 0.8;
+    const double recoverFraction  = 0.4;
+} // namespace
+
+RenderGovernor::RenderGovernor():
+    Overruns(0), TierChanges(0), mEnabled(false), mDecoderCapping(false), mBudgetNs(defaultBudgetNs), mTier(TierFull), mAverageNs(0.0), mHoldTicks(0), mHeadroomTicks(0), mWindowTicks(0), mWindowOverruns(0) {
+}
+
+RenderTier RenderGovernor::update(uint64_t renderNs) {
+    const uint64_t budgetNs = mBudgetNs.load(std::memory_order_relaxed);
+    const bool     overrun  = renderNs > budgetNs;
+    if (overrun) {
+        Overruns.fetch_add(1, std::memory_order_relaxed);
+    }
+    mAverageNs += (static_cast<double>(renderNs) - mAverageNs) * averageWeight;
+
+    auto tier = static_cast<RenderTier>(mTier.load(std::memory_order_relaxed));
+    if (!mEnabled.load(std::memory_order_relaxed)) {
+        return tier;
+    }
+    if (mHoldTicks > 0) {
+        mHoldTicks--;
+    }
+    if (overrun) {
+        mWindowOverruns++;
+    }
+    const bool overrunning = mWindowOverruns >= overrunLimit;
+    if (++mWindowTicks >= overrunWindowTicks) {
+        mWindowTicks    = 0;
+        mWindowOverruns = 0;
+    }
+
+    const double budget = static_cast<double>(budgetNs);
+    if (overrunning || mAverageNs > budget * pressureFraction) {
+        mHeadroomTicks = 0;
+        if (mHoldTicks == 0 && tier < lowest_tier()) {
+            tier = static_cast<RenderTier>(tier + 1);
+            set_tier(tier);
+        }
+    } else if (mAverageNs < budget * recoverFraction && tier > TierFull) {
+        if (++mHeadroomTicks >= recoverTicks) {
+            mHeadroomTicks = 0;
+            tier           = static_cast<RenderTier>(tier - 1);
+            set_tier(tier);
+        }
+    } else {
+        mHeadroomTicks = 0;
+    }
+    return tier;
+}
+
+void RenderGovernor::set_tier(RenderTier tier) {
+    mTier.store(tier, std::memory_order_relaxed);
+    mHoldTicks = holdTicks;
+    // the overruns that caused the change don't count towards the next one.
+    mWindowTicks    = 0;
+    mWindowOverruns = 0;
+    TierChanges.fetch_add(1, std::memory_order_relaxed);
+}
+
+RenderTier RenderGovernor::lowest_tier() const {
+    return mDecoderCapping.load(std::memory_order_relaxed) ? TierCappedDecoders : TierNoCompressor;
+}
+
+RenderTier RenderGovernor::getTier() const {
+    return static_cast<RenderTier>(mTier.load(std::memory_order_relaxed));
+}
+
+void RenderGovernor::setEnabled(bool enabled) {
+    mEnabled.store(enabled);
+    if (!enabled && mTier.exchange(TierFull) != TierFull) {
+        TierChanges.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool RenderGovernor::getEnabled() const {
+    return mEnabled.load();
+}
+
+void RenderGovernor::setDecoderCapping(bool capping) {
+    mDecoderCapping.store(capping);
+    if (!capping) {
+        uint8_t capped = TierCappedDecoders;
+        if (mTier.compare_exchange_strong(capped, TierNoCompressor)) {
+            TierChanges.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool RenderGovernor::getDecoderCapping() const {
+    return mDecoderCapping.load();
+}
+
+void RenderGovernor::setBudgetNs(uint64_t budgetNs) {
+    mBudgetNs.store(budgetNs);
+}
+
+uint64_t RenderGovernor::getBudgetNs() const {
+    return mBudgetNs.load();
+}
@@ -33,17 +33,61 @@
 
 #include "afv-native/afv/VoiceCompressionSink.h"
 #include "afv-native/Log.h"
+#include "afv-native/afv/RemoteVoiceSource.h"
+#include <algorithm>
 #include <vector>
 
 using namespace ::afv_native;
 using namespace ::afv_native::afv;
 using namespace ::std;
 
+namespace {
+    /** the most DTX frames skipped in a row - receivers give up on a transmission after
+     * frameTimeOut frames of nothing, and this leaves a couple spare for jitter */
+    const unsigned int dtxMaxSkippedFrames = frameTimeOut - 2;
+} // namespace
+
 VoiceCompressionSink::VoiceCompressionSink(ICompressedFrameSink &sink):
-    mEncoder(nullptr), mCompressedFrameSink(sink) {
+    mEncoder(nullptr), mCompressedFrameSink(sink), mPacketLoss(0), mEncoderPacketLoss(0), mProfile(), mProfileLock(), mPendingProfile(), mProfileChanged(false), mDtxSent(false), mDtxSkipped(0), mDefaultComplexity(0), mEncoded() {
+    mEncoded.reserve(maxFrameBytes);
     open();
 }
 
+EncoderProfile EncoderProfile::standard() {
+    return EncoderProfile();
+}
+
+EncoderProfile EncoderProfile::lowCpu() {
+    EncoderProfile profile;
+    profile.complexity = 2;
+    return profile;
+}
+
+EncoderProfile EncoderProfile::radio() {
+    EncoderProfile profile;
+    profile.bitrate      = 12000;
+    profile.complexity   = 5;
+    profile.signal       = OPUS_SIGNAL_VOICE;
+    profile.maxBandwidth = OPUS_BANDWIDTH_NARROWBAND;
+    return profile;
+}
+
+int EncoderProfile::bandwidthForCutoff(unsigned int cutoffHz) {
+    if (cutoffHz <= 4000) {
+        return OPUS_BANDWIDTH_NARROWBAND;
+    }
+    if (cutoffHz <= 6000) {
+        return OPUS_BANDWIDTH_MEDIUMBAND;
+    }
+    if (cutoffHz <= 8000) {
+        return OPUS_BANDWIDTH_WIDEBAND;
+    }
+    if (cutoffHz <= 12000) {
+        return OPUS_BANDWIDTH_SUPERWIDEBAND;
+    }
+    return OPUS_BANDWIDTH_FULLBAND;
+}
+
 VoiceCompressionSink::~VoiceCompressionSink() {
     close();
 }
@@ -53,19 +97,86 @@ int VoiceCompressionSink::open() {
     if (mEncoder != nullptr) {
         return 0;
     }
-    mEncoder = opus_encoder_create(audio::sampleRateHz, 1, OPUS_APPLICATION_VOIP, &opus_status);
+    mEncoder = opus_encoder_create(audio::sampleRateHz, 1, mProfile.application, &opus_status);
     if (opus_status != OPUS_OK) {
         LOG("VoiceCompressionSink", "Got error initialising Opus Codec: %s", opus_strerror(opus_status));
         mEncoder = nullptr;
     } else {
-        opus_status = opus_encoder_ctl(mEncoder, OPUS_SET_BITRATE(audio::encoderBitrate));
-        if (opus_status != OPUS_OK) {
-            LOG("VoiceCompressionSink", "error setting bitrate on codec: %s", opus_strerror(opus_status));
-        }
+        opus_encoder_ctl(mEncoder, OPUS_GET_COMPLEXITY(&mDefaultComplexity));
+        mDtxSent    = false;
+        mDtxSkipped = 0;
+        apply_profile();
+        // a new encoder starts out without FEC.
+        mEncoderPacketLoss = 0;
+        apply_packet_loss(mPacketLoss.load());
     }
     return opus_status;
 }
 
+void VoiceCompressionSink::setPacketLoss(int percent) {
+    mPacketLoss.store(std::min(std::max(percent, 0), 100));
+}
+
+int VoiceCompressionSink::getPacketLoss() const {
+    return mPacketLoss.load();
+}
+
+void VoiceCompressionSink::setProfile(const EncoderProfile &profile) {
+    std::lock_guard<std::mutex> profileGuard(mProfileLock);
+    mPendingProfile = profile;
+    mProfileChanged.store(true);
+}
+
+EncoderProfile VoiceCompressionSink::getProfile() {
+    std::lock_guard<std::mutex> profileGuard(mProfileLock);
+    return mPendingProfile;
+}
+
+void VoiceCompressionSink::apply_profile() {
+    const int complexity = mProfile.complexity < 0 ? mDefaultComplexity : std::min(mProfile.complexity, 10);
+
+    // each setting is applied on its own, so one the codec rejects doesn't take the rest
+    // with it.
+    int opus_status = opus_encoder_ctl(mEncoder, OPUS_SET_BITRATE(mProfile.bitrate));
+    if (opus_status != OPUS_OK) {
+        LOG("VoiceCompressionSink", "error setting bitrate %d on codec: %s", mProfile.bitrate, opus_strerror(opus_status));
+    }
+    opus_status = opus_encoder_ctl(mEncoder, OPUS_SET_COMPLEXITY(complexity));
+    if (opus_status != OPUS_OK) {
+        LOG("VoiceCompressionSink", "error setting complexity %d on codec: %s", complexity, opus_strerror(opus_status));
+    }
+    opus_status = opus_encoder_ctl(mEncoder, OPUS_SET_VBR(mProfile.vbr ? 1 : 0));
+    if (opus_status != OPUS_OK) {
+        LOG("VoiceCompressionSink", "error setting vbr on codec: %s", opus_strerror(opus_status));
+    }
+    opus_status = opus_encoder_ctl(mEncoder, OPUS_SET_DTX(mProfile.dtx ? 1 : 0));
+    if (opus_status != OPUS_OK) {
+        LOG("VoiceCompressionSink", "error setting dtx on codec: %s", opus_strerror(opus_status));
+    }
+    opus_status = opus_encoder_ctl(mEncoder, OPUS_SET_SIGNAL(mProfile.signal));
+    if (opus_status != OPUS_OK) {
+        LOG("VoiceCompressionSink", "error setting signal type %d on codec: %s", mProfile.signal, opus_strerror(opus_status));
+    }
+    opus_status = opus_encoder_ctl(mEncoder, OPUS_SET_MAX_BANDWIDTH(mProfile.maxBandwidth));
+    if (opus_status != OPUS_OK) {
+        LOG("VoiceCompressionSink", "error setting max bandwidth %d on codec: %s", mProfile.maxBandwidth, opus_strerror(opus_status));
+    }
+}
+
+void VoiceCompressionSink::apply_packet_loss(int percent) {
+    if (mEncoder == nullptr || percent == mEncoderPacketLoss) {
+        return;
+    }
+    int opus_status = opus_encoder_ctl(mEncoder, OPUS_SET_INBAND_FEC(percent > 0 ? 1 : 0));
+    if (opus_status == OPUS_OK) {
+        opus_status = opus_encoder_ctl(mEncoder, OPUS_SET_PACKET_LOSS_PERC(percent));
+    }
+    if (opus_status != OPUS_OK) {
+        LOG("VoiceCompressionSink", "error setting packet loss on codec: %s", opus_strerror(opus_status));
+    }
+    mEncoderPacketLoss = percent;
+}
+
 void VoiceCompressionSink::close() {
     if (nullptr != mEncoder) {
         opus_encoder_destroy(mEncoder);
@@ -79,13 +190,44 @@ void VoiceCompressionSink::reset() {
 }
 
 void VoiceCompressionSink::putAudioFrame(const audio::SampleType *bufferIn) {
-    vector<unsigned char> outBuffer(audio::targetOutputFrameSizeBytes);
-    auto                  enc_len =
-        opus_encode_float(mEncoder, bufferIn, audio::frameSizeSamples, outBuffer.data(), outBuffer.size());
+    if (mProfileChanged.exchange(false)) {
+        EncoderProfile profile;
+        {
+            std::lock_guard<std::mutex> profileGuard(mProfileLock);
+            profile = mPendingProfile;
+        }
+        const bool newApplication = profile.application != mProfile.application;
+        mProfile                  = profile;
+        if (newApplication) {
+            reset();
+        } else if (mEncoder != nullptr) {
+            apply_profile();
+        }
+    }
+    apply_packet_loss(mPacketLoss.load());
+    if (mEncoder == nullptr) {
+        return;
+    }
+
+    // mEncoded never shrinks below maxFrameBytes of capacity, so this doesn't allocate.
+    mEncoded.resize(maxFrameBytes);
+    auto enc_len = opus_encode_float(mEncoder, bufferIn, audio::frameSizeSamples, mEncoded.data(), static_cast<opus_int32>(mEncoded.size()));
     if (enc_len < 0) {
         LOG("VoiceCompressionSink", "error encoding frame: %s", opus_strerror(enc_len));
         return;
     }
-    outBuffer.resize(enc_len);
-    mCompressedFrameSink.processCompressedFrame(outBuffer);
+    mEncoded.resize(enc_len);
+    if (mProfile.dtx && mEncoded.size() <= dtxFrameBytes) {
+        // the first DTX frame goes, to mark the gap after it as silence, and then one every
+        // dtxMaxSkippedFrames + 1 to keep the transmission alive.
+        if (mDtxSent && mDtxSkipped < dtxMaxSkippedFrames && mCompressedFrameSink.skipCompressedFrame()) {
+            mDtxSkipped++;
+            return;
+        }
+        mDtxSent = true;
+    } else {
+        mDtxSent = false;
+    }
+    mDtxSkipped = 0;
+    mCompressedFrameSink.processCompressedFrame(mEncoded);
 }
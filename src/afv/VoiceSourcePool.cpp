@@ -0,0 +1,86 @@
+#include "afv-native/afv/VoiceSourcePool.h"
+#include <algorithm>
+
+using namespace afv_native;
+using namespace afv_native::afv;
+
+VoiceSourcePool::VoiceSourcePool(size_t maxIdle):
+    Acquires(0), Hits(0), mLock(), mIdle(), mMaxIdle(maxIdle), mInUse(0), mPeakInUse(0) {
+    mIdle.reserve(mMaxIdle);
+}
+
+std::shared_ptr<RemoteVoiceSource> VoiceSourcePool::acquire(int sampleRate) {
+    std::shared_ptr<RemoteVoiceSource> source;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        Acquires.fetch_add(1, std::memory_order_relaxed);
+        mInUse++;
+        mPeakInUse = std::max(mPeakInUse, mInUse);
+        if (!mIdle.empty()) {
+            source = std::move(mIdle.back());
+            mIdle.pop_back();
+            Hits.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (!source) {
+        return std::make_shared<RemoteVoiceSource>(sampleRate);
+    }
+    if (source->getSampleRate() != sampleRate) {
+        source->reset(sampleRate);
+    }
+    return source;
+}
+
+void VoiceSourcePool::release(std::shared_ptr<RemoteVoiceSource> source) {
+    if (!source) {
+        return;
+    }
+    const bool reusable = source.use_count() == 1;
+    if (reusable) {
+        // reset it here, so that acquire() only has to change the rate (if that).
+        source->reset(source->getSampleRate());
+    }
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mInUse > 0) {
+        mInUse--;
+    }
+    if (reusable && mIdle.size() < mMaxIdle) {
+        mIdle.push_back(std::move(source));
+    }
+}
+
+void VoiceSourcePool::reserve(size_t count) {
+    count = std::min(count, mMaxIdle);
+    size_t missing;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        missing = count > mIdle.size() ? count - mIdle.size() : 0;
+    }
+    std::vector<std::shared_ptr<RemoteVoiceSource>> created;
+    created.reserve(missing);
+    for (size_t i = 0; i < missing; i++) {
+        created.push_back(std::make_shared<RemoteVoiceSource>(audio::sampleRateHz));
+    }
+    std::lock_guard<std::mutex> lock(mLock);
+    for (auto &source: created) {
+        if (mIdle.size() >= mMaxIdle) {
+            break;
+        }
+        mIdle.push_back(std::move(source));
+    }
+}
+
+size_t VoiceSourcePool::getInUse() const {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mInUse;
+}
+
+size_t VoiceSourcePool::getPeakInUse() const {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mPeakInUse;
+}
+
+size_t VoiceSourcePool::getIdle() const {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mIdle.size();
+}
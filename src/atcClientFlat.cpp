@@ -132,6 +132,50 @@ AFV_NATIVE_API void ATCClient_SetEnableOutputEffects(ATCClientHandle handle, boo
     handle->impl->SetEnableOutputEffects(enableEffects);
 }
 
+AFV_NATIVE_API void ATCClient_SetDspThreads(ATCClientHandle handle, unsigned int threads, bool deterministic) {
+    handle->impl->SetDspThreads(threads, deterministic);
+}
+
+AFV_NATIVE_API void ATCClient_SetDecodeThreads(ATCClientHandle handle, unsigned int threads) {
+    handle->impl->SetDecodeThreads(threads);
+}
+
+AFV_NATIVE_API void ATCClient_SetSharedNoiseBed(ATCClientHandle handle, bool shared) {
+    handle->impl->SetSharedNoiseBed(shared);
+}
+
+AFV_NATIVE_API void ATCClient_SetMaxDecoders(ATCClientHandle handle, unsigned int maxDecoders) {
+    handle->impl->SetMaxDecoders(maxDecoders);
+}
+
+AFV_NATIVE_API void ATCClient_SetReducedRateDsp(ATCClientHandle handle, bool reduced) {
+    handle->impl->SetReducedRateDsp(reduced);
+}
+
+AFV_NATIVE_API void ATCClient_SetFecPacketLoss(ATCClientHandle handle, int percent) {
+    handle->impl->SetFecPacketLoss(percent);
+}
+
+AFV_NATIVE_API void ATCClient_SetEncoderProfile(ATCClientHandle handle, unsigned int bitrate, int complexity, bool vbr, bool dtx, bool voiceSignal, unsigned int maxBandwidthHz) {
+    handle->impl->SetEncoderProfile(bitrate, complexity, vbr, dtx, voiceSignal, maxBandwidthHz);
+}
+
+AFV_NATIVE_API bool ATCClient_SetRenderQuantum(ATCClientHandle handle, unsigned int samples) {
+    return handle->impl->SetRenderQuantum(samples);
+}
+
+AFV_NATIVE_API void ATCClient_SetRenderGovernor(ATCClientHandle handle, bool enabled, unsigned int budgetUs, bool capDecoders) {
+    handle->impl->SetRenderGovernor(enabled, budgetUs, capDecoders);
+}
+
+AFV_NATIVE_API unsigned int ATCClient_GetRenderTier(ATCClientHandle handle) {
+    return handle->impl->GetRenderTier();
+}
+
+AFV_NATIVE_API unsigned long long ATCClient_GetRenderOverruns(ATCClientHandle handle) {
+    return handle->impl->GetRenderOverruns();
+}
+
 AFV_NATIVE_API bool ATCClient_GetEnableInputFilters(ATCClientHandle handle) {
     return handle->impl->GetEnableInputFilters();
 }
@@ -311,6 +311,70 @@ void afv_native::api::atcClient::SetEnableOutputEffects(bool enableEffects) {
     client->setEnableOutputEffects(enableEffects);
 }
 
+void afv_native::api::atcClient::SetDspThreads(unsigned int threads, bool deterministic) {
+    std::lock_guard<std::mutex> lock(afvMutex);
+    client->setDspThreads(threads, deterministic);
+}
+
+void afv_native::api::atcClient::SetDecodeThreads(unsigned int threads) {
+    std::lock_guard<std::mutex> lock(afvMutex);
+    client->setDecodeThreads(threads);
+}
+
+void afv_native::api::atcClient::SetSharedNoiseBed(bool shared) {
+    std::lock_guard<std::mutex> lock(afvMutex);
+    client->setSharedNoiseBed(shared);
+}
+
+void afv_native::api::atcClient::SetMaxDecoders(unsigned int maxDecoders) {
+    std::lock_guard<std::mutex> lock(afvMutex);
+    client->setMaxDecoders(maxDecoders);
+}
+
+void afv_native::api::atcClient::SetReducedRateDsp(bool reduced) {
+    std::lock_guard<std::mutex> lock(afvMutex);
+    client->setReducedRateDsp(reduced);
+}
+
+void afv_native::api::atcClient::SetFecPacketLoss(int percent) {
+    std::lock_guard<std::mutex> lock(afvMutex);
+    client->setFecPacketLoss(percent);
+}
+
+void afv_native::api::atcClient::SetEncoderProfile(unsigned int bitrate, int complexity, bool vbr, bool dtx, bool voiceSignal, unsigned int maxBandwidthHz) {
+    afv::EncoderProfile profile;
+    if (bitrate > 0) {
+        profile.bitrate = static_cast<int32_t>(std::min<unsigned int>(std::max<unsigned int>(bitrate, afv::EncoderProfile::minBitrate), afv::EncoderProfile::maxBitrate));
+    }
+    profile.complexity   = complexity;
+    profile.vbr          = vbr;
+    profile.dtx          = dtx;
+    profile.signal       = voiceSignal ? OPUS_SIGNAL_VOICE : OPUS_AUTO;
+    if (maxBandwidthHz > 0) {
+        profile.maxBandwidth = afv::EncoderProfile::bandwidthForCutoff(maxBandwidthHz);
+    }
+    std::lock_guard<std::mutex> lock(afvMutex);
+    client->setEncoderProfile(profile);
+}
+
+bool afv_native::api::atcClient::SetRenderQuantum(unsigned int samples) {
+    std::lock_guard<std::mutex> lock(afvMutex);
+    return client->setRenderQuantum(samples);
+}
+
+void afv_native::api::atcClient::SetRenderGovernor(bool enabled, unsigned int budgetUs, bool capDecoders) {
+    std::lock_guard<std::mutex> lock(afvMutex);
+    client->setRenderGovernor(enabled, budgetUs, capDecoders);
+}
+
+unsigned int afv_native::api::atcClient::GetRenderTier() const {
+    return client->getRenderTier();
+}
+
+unsigned long long afv_native::api::atcClient::GetRenderOverruns() const {
+    return client->getRenderOverruns();
+}
+
 bool afv_native::api::atcClient::GetEnableInputFilters() const {
     return client->getEnableInputFilters();
 }
@@ -41,7 +41,7 @@ using namespace afv_native::audio;
 using namespace std;
 
 AudioDevice::AudioDevice():
-    mSink(), mSinkPtrLock(), mSource(), mSourcePtrLock(), OutputUnderflows(0), InputOverflows(0) {
+    mSink(), mSinkPtrLock(), mSource(), mSourcePtrLock(), mOutputPeriod(frameSizeSamples), OutputUnderflows(0), InputOverflows(0) {
 }
 
 AudioDevice::~AudioDevice() {
@@ -53,6 +53,14 @@ void AudioDevice::setSource(std::shared_ptr<ISampleSource> newSrc) {
     mSource = std::move(newSrc);
 }
 
+void AudioDevice::setOutputPeriod(unsigned int samples) {
+    mOutputPeriod = std::max(samples, 1u);
+}
+
+unsigned int AudioDevice::getOutputPeriod() const {
+    return mOutputPeriod;
+}
+
 void AudioDevice::setSink(std::shared_ptr<ISampleSink> newSink) {
     std::lock_guard<std::mutex> sinkGuard(mSinkPtrLock);
 
@@ -2,6 +2,13 @@
 #include <cmath>
 
 namespace afv_native { namespace audio {
+    void BiQuadFilter::reset() {
+        m_x1 = 0.0;
+        m_x2 = 0.0;
+        m_y1 = 0.0;
+        m_y2 = 0.0;
+    }
+
     SampleType BiQuadFilter::TransformOne(SampleType sampleIn) {
         // compute result
         double result = m_a0 * sampleIn + m_a1 * m_x1 + m_a2 * m_x2 - m_a3 * m_y1 - m_a4 * m_y2;
@@ -113,6 +120,27 @@ namespace afv_native { namespace audio {
         return filter;
     }
 
+    BiQuadFilter BiQuadFilter::customBuildAtRate(float designRate, float sampleRate, float matchFrequency, double aa0, double aa1, double aa2, double b0, double b1, double b2) {
+        if (designRate == sampleRate) {
+            return customBuild(aa0, aa1, aa2, b0, b1, b2);
+        }
+        // going through the analog prototype, z^-1 at the design rate becomes p(v)/q(v) in
+        // v = z^-1 at the new rate.  Scaling both polynomials by q(v)^2 keeps them quadratic.
+        // k is the ratio of the two prewarped frequency scales at matchFrequency.
+        const double k  = tan(M_PI * matchFrequency / designRate) / tan(M_PI * matchFrequency / sampleRate);
+        const double p0 = 1 - k, p1 = 1 + k;
+        const double q0 = 1 + k, q1 = 1 - k;
+        auto         map = [&](double c0, double c1, double c2, double &o0, double &o1, double &o2) {
+            o0 = c0 * q0 * q0 + c1 * p0 * q0 + c2 * p0 * p0;
+            o1 = c0 * 2 * q0 * q1 + c1 * (p0 * q1 + p1 * q0) + c2 * 2 * p0 * p1;
+            o2 = c0 * q1 * q1 + c1 * p1 * q1 + c2 * p1 * p1;
+        };
+        double na0, na1, na2, nb0, nb1, nb2;
+        map(aa0, aa1, aa2, na0, na1, na2);
+        map(b0, b1, b2, nb0, nb1, nb2);
+        return customBuild(na0, na1, na2, nb0, nb1, nb2);
+    }
+
     BiQuadFilter BiQuadFilter::lowShelfFilter(float sampleRate, float cutoffFrequency, float q, float dbGain) {
         BiQuadFilter filter;
         filter.setLowShelfFilter(sampleRate, cutoffFrequency, q, dbGain);
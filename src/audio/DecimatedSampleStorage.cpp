@@ -0,0 +1,45 @@
+#include "afv-native/audio/DecimatedSampleStorage.h"
+#include "afv-native/audio/PolyphaseUpsampler.h"
+#include <algorithm>
+
+using namespace afv_native::audio;
+
+namespace {
+    const size_t tapsPerFactor = 16;
+}
+
+DecimatedSampleStorage::DecimatedSampleStorage(const ISampleStorage &source, unsigned int factor, bool loop):
+    mSamples(), mLength(0) {
+    factor                   = std::max(factor, 1u);
+    const SampleType *in     = source.data();
+    const size_t      inLen  = source.lengthInSamples();
+    const auto        taps   = PolyphaseUpsampler::designLowPass(tapsPerFactor * factor + 1, 0.9 * 0.5 / factor, 1.0);
+    const long        centre = static_cast<long>(taps.size() / 2);
+
+    mLength  = (inLen + factor - 1) / factor;
+    mSamples = std::make_unique<SampleType[]>(std::max<size_t>(mLength, 1));
+    for (size_t n = 0; n < mLength; n++) {
+        // the filter's symmetric, so centring it on the kept sample keeps it in time.
+        const long at  = static_cast<long>(n * factor);
+        double     acc = 0.0;
+        for (size_t tap = 0; tap < taps.size(); tap++) {
+            long src = at + centre - static_cast<long>(tap);
+            if (src < 0 || src >= static_cast<long>(inLen)) {
+                if (!loop || inLen == 0) {
+                    continue;
+                }
+                src = ((src % static_cast<long>(inLen)) + static_cast<long>(inLen)) % static_cast<long>(inLen);
+            }
+            acc += taps[tap] * in[src];
+        }
+        mSamples[n] = static_cast<SampleType>(acc);
+    }
+}
+
+SampleType *DecimatedSampleStorage::data() const {
+    return mSamples.get();
+}
+
+size_t DecimatedSampleStorage::lengthInSamples() const {
+    return mLength;
+}
@@ -0,0 +1,39 @@
+#include "afv-native/audio/FrameRing.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace afv_native::audio;
+
+FrameRing::FrameRing(size_t frameSamples, size_t capacity):
+    mFrameSamples(frameSamples), mCapacity(capacity), mFrames(frameSamples * capacity, 0.0f), mLengths(capacity, frameSamples), mWritePos(0), mReadPos(0) {
+}
+
+SampleType *FrameRing::writeFrame() {
+    const size_t writePos = mWritePos.load(std::memory_order_relaxed);
+    if (writePos - mReadPos.load(std::memory_order_acquire) >= mCapacity) {
+        return nullptr;
+    }
+    return mFrames.data() + (writePos % mCapacity) * mFrameSamples;
+}
+
+void FrameRing::commitFrame(size_t samples) {
+    const size_t writePos          = mWritePos.load(std::memory_order_relaxed);
+    mLengths[writePos % mCapacity] = std::min(samples, mFrameSamples);
+    mWritePos.store(writePos + 1, std::memory_order_release);
+}
+
+size_t FrameRing::readFrame(SampleType *bufferOut) {
+    const size_t readPos = mReadPos.load(std::memory_order_relaxed);
+    if (readPos == mWritePos.load(std::memory_order_acquire)) {
+        return 0;
+    }
+    const size_t length = mLengths[readPos % mCapacity];
+    ::memcpy(bufferOut, mFrames.data() + (readPos % mCapacity) * mFrameSamples, sizeof(SampleType) * length);
+    mReadPos.store(readPos + 1, std::memory_order_release);
+    return length;
+}
+
+void FrameRing::clear() {
+    mWritePos.store(0);
+    mReadPos.store(0);
+}
@@ -0,0 +1,43 @@
+#include "afv-native/audio/FrameSlab.h"
+#include <algorithm>
+
+using namespace afv_native::audio;
+
+FrameSlab::FrameSlab(size_t initialSlots): mFrames(), mFreeSlots(), mCapacity(0) {
+    grow(std::max<size_t>(initialSlots, 1));
+}
+
+size_t FrameSlab::acquire() {
+    if (mFreeSlots.empty()) {
+        grow(mCapacity * 2);
+    }
+    size_t slot = mFreeSlots.back();
+    mFreeSlots.pop_back();
+    return slot;
+}
+
+void FrameSlab::release(size_t slot) {
+    if (slot >= mCapacity) {
+        return;
+    }
+    mFreeSlots.push_back(slot);
+}
+
+void FrameSlab::releaseAll() {
+    mFreeSlots.clear();
+    // hand the low slots out first so the live frames stay packed at the front of the slab.
+    for (size_t slot = mCapacity; slot > 0; slot--) {
+        mFreeSlots.push_back(slot - 1);
+    }
+}
+
+void FrameSlab::grow(size_t newCapacity) {
+    mFrames.resize(newCapacity * frameSizeSamples, 0.0f);
+    mFreeSlots.reserve(newCapacity);
+    // only called once the free list has run dry - push in reverse so the lowest new slot is
+    // handed out first.
+    for (size_t slot = newCapacity; slot > mCapacity; slot--) {
+        mFreeSlots.push_back(slot - 1);
+    }
+    mCapacity = newCapacity;
+}
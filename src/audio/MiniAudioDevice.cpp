@@ -17,7 +17,7 @@ void logger(void *pUserData, ma_uint32 logLevel, const char *message) {
 }
 
 MiniAudioAudioDevice::MiniAudioAudioDevice(const std::string &userStreamName, const std::string &outputDeviceId, const std::string &inputDeviceId, AudioDevice::Api audioApi, bool makeStereo):
-    AudioDevice(), mUserStreamName(userStreamName), mOutputDeviceId(outputDeviceId), mInputDeviceId(inputDeviceId), mInputInitialized(false), mOutputInitialized(false), mAudioApi(audioApi), mStereo(makeStereo) {
+    AudioDevice(), mUserStreamName(userStreamName), mOutputDeviceId(outputDeviceId), mInputDeviceId(inputDeviceId), mInputInitialized(false), mOutputInitialized(false), mAudioApi(audioApi), mStereo(makeStereo), mResidual(frameSizeSamples * 2, 0.0f) {
     ma_context_config contextConfig      = ma_context_config_init();
     contextConfig.threadPriority         = ma_thread_priority_normal;
     contextConfig.jack.pClientName       = mUserStreamName.c_str();
@@ -230,7 +230,7 @@ bool MiniAudioAudioDevice::initOutput() {
     cfg.playback.shareMode = ma_share_mode_shared;
 
     cfg.sampleRate         = sampleRateHz;
-    cfg.periodSizeInFrames = frameSizeSamples;
+    cfg.periodSizeInFrames = mOutputPeriod;
     cfg.pUserData          = this;
     cfg.dataCallback       = maOutputCallback;
 
@@ -331,25 +331,48 @@ bool MiniAudioAudioDevice::getDeviceForId(const std::string &inDeviceId, bool fo
 int MiniAudioAudioDevice::outputCallback(void *outputBuffer, unsigned int nFrames) {
     if (outputBuffer) {
         std::lock_guard<std::mutex> sourceGuard(mSourcePtrLock);
-        for (size_t i = 0; i < nFrames; i += frameSizeSamples) {
-            if (mSource) {
-                SourceStatus rv;
-                rv = mSource->getAudioFrame(reinterpret_cast<float *>(outputBuffer) + i);
-                if (rv != SourceStatus::OK) {
-                    ::memset(reinterpret_cast<float *>(outputBuffer) + i, 0, frameSizeBytes);
-                    mSource.reset();
-                }
-            } else {
-                // if there's no source, but there is an output buffer, zero it
-                // to avoid making horrible buzzing sounds.
-                ::memset(reinterpret_cast<float *>(outputBuffer) + i, 0, frameSizeBytes);
-            }
+        auto        *out      = reinterpret_cast<float *>(outputBuffer);
+        const size_t channels = mStereo ? 2 : 1;
+        size_t       done     = 0;
+        if (mSource && mSource->partialFrames()) {
+            done = mSource->getAudioSamples(out, nFrames) == SourceStatus::OK ? nFrames : 0;
+        } else if (mSource) {
+            done = fillFromFrames(out, nFrames, channels);
+        }
+        if (done < nFrames) {
+            // if there's no source, but there is an output buffer, zero what
+            // it didn't fill to avoid making horrible buzzing sounds.
+            ::memset(out + done * channels, 0, sizeof(float) * (nFrames - done) * channels);
+            mSource.reset();
         }
     }
 
     return 0;
 }
 
+size_t MiniAudioAudioDevice::fillFromFrames(float *out, unsigned int nFrames, size_t channels) {
+    if (mResidualSource != mSource.get()) {
+        // whatever's left over belongs to the previous source.
+        mResidualSource = mSource.get();
+        mResidualOffset = frameSizeSamples;
+    }
+    size_t done = 0;
+    while (done < nFrames) {
+        if (mResidualOffset == frameSizeSamples) {
+            if (mSource->getAudioFrame(mResidual.data()) != SourceStatus::OK) {
+                mResidualSource = nullptr;
+                return done;
+            }
+            mResidualOffset = 0;
+        }
+        const size_t count = std::min<size_t>(nFrames - done, frameSizeSamples - mResidualOffset);
+        ::memcpy(out + done * channels, mResidual.data() + mResidualOffset * channels, sizeof(float) * count * channels);
+        mResidualOffset += count;
+        done += count;
+    }
+    return done;
+}
+
 int MiniAudioAudioDevice::inputCallback(const void *inputBuffer, unsigned int nFrames) {
     std::lock_guard<std::mutex> sinkGuard(mSinkPtrLock);
     if (mSink && inputBuffer) {
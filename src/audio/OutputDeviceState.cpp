@@ -3,17 +3,15 @@
 using namespace afv_native;
 
 OutputDeviceState::OutputDeviceState() {
-    mChannelBuffer     = new audio::SampleType[audio::frameSizeSamples];
-    mMixingBuffer      = new audio::SampleType[audio::frameSizeSamples];
-    mFetchBuffer       = new audio::SampleType[audio::frameSizeSamples];
-    mLeftMixingBuffer  = new audio::SampleType[audio::frameSizeSamples];
-    mRightMixingBuffer = new audio::SampleType[audio::frameSizeSamples];
+    mChannelBuffer      = new audio::SampleType[audio::frameSizeSamples];
+    mMixingBuffer       = new audio::SampleType[audio::frameSizeSamples];
+    mFetchBuffer        = new audio::SampleType[audio::frameSizeSamples];
+    mStereoMixingBuffer = new audio::SampleType[audio::frameSizeSamples * 2];
 }
 
 OutputDeviceState::~OutputDeviceState() {
     delete[] mFetchBuffer;
     delete[] mMixingBuffer;
-    delete[] mLeftMixingBuffer;
-    delete[] mRightMixingBuffer;
+    delete[] mStereoMixingBuffer;
     delete[] mChannelBuffer;
 }
\ No newline at end of file
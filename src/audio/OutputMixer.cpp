@@ -34,6 +34,7 @@
 #include "afv-native/audio/OutputMixer.h"
 #include "afv-native/Log.h"
 #include "afv-native/audio/SourceStatus.h"
+#include "afv-native/audio/kernels.h"
 #include <cstring>
 
 using namespace afv_native::audio;
@@ -47,20 +48,14 @@ OutputMixer::~OutputMixer() {
 SourceStatus OutputMixer::getAudioFrame(SampleType *RESTRICT bufferOut) {
     SourceStatus src_rv;
     bool         didMix = false;
-    int          i      = 0;
-
-    std::vector<SampleType> ibuf(frameSizeSamples, 0.0); // we must not touch ibuf directly. (due RESTICT in next line).
-    auto *intermediate_buffer = ibuf.data();
 
     ::memset(bufferOut, 0, sizeof(SampleType) * frameSizeSamples);
 
     for (auto &src_iter: mSources) {
-        src_rv = src_iter.src->getAudioFrame(intermediate_buffer);
+        src_rv = src_iter.src->getAudioFrame(mIntermediateBuffer);
         if (src_rv == SourceStatus::OK) {
             didMix = true;
-            for (i = 0; i < frameSizeSamples; i++) {
-                bufferOut[i] += (src_iter.gain * intermediate_buffer[i]);
-            }
+            kernels::mix(bufferOut, mIntermediateBuffer, src_iter.gain);
         } else {
             if (src_rv == SourceStatus::Error) {
                 LOG("outputmixer", "Error reading from stream.  Removing from mixer.");
@@ -74,9 +69,7 @@ SourceStatus OutputMixer::getAudioFrame(SampleType *RESTRICT bufferOut) {
     });
     // apply final volume adjustment.
     if (didMix) {
-        for (i = 0; i < frameSizeSamples; i++) {
-            bufferOut[i] *= mGain;
-        }
+        kernels::scale(bufferOut, mGain);
     }
     return SourceStatus::OK;
 }
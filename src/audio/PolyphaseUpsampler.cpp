@@ -0,0 +1,65 @@
+#include "afv-native/audio/PolyphaseUpsampler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace afv_native::audio;
+
+PolyphaseUpsampler::PolyphaseUpsampler(unsigned int factor, size_t maxInputSamples):
+    mFactor(std::max(factor, 1u)), mMaxInputSamples(maxInputSamples), mPhaseTaps(mFactor * tapsPerPhase), mHistory(tapsPerPhase - 1 + maxInputSamples, 0.0f) {
+    // the prototype runs at the output rate, and gains up by the factor to make up for the
+    // zeros it's (notionally) filtering.
+    const auto prototype = designLowPass(mFactor * tapsPerPhase, 0.9 * 0.5 / mFactor, mFactor);
+    for (unsigned int phase = 0; phase < mFactor; phase++) {
+        for (size_t tap = 0; tap < tapsPerPhase; tap++) {
+            mPhaseTaps[phase * tapsPerPhase + tap] = prototype[(tapsPerPhase - 1 - tap) * mFactor + phase];
+        }
+    }
+}
+
+std::vector<float> PolyphaseUpsampler::designLowPass(size_t taps, double cutoff, double gain) {
+    std::vector<double> h(taps);
+    const double        centre = (static_cast<double>(taps) - 1.0) / 2.0;
+    double              sum    = 0.0;
+    for (size_t n = 0; n < taps; n++) {
+        const double x    = static_cast<double>(n) - centre;
+        const double sinc = x == 0.0 ? 2.0 * cutoff : std::sin(2.0 * M_PI * cutoff * x) / (M_PI * x);
+        const double w    = 0.42 - 0.5 * std::cos(2.0 * M_PI * n / (taps - 1)) + 0.08 * std::cos(4.0 * M_PI * n / (taps - 1));
+        h[n]              = sinc * w;
+        sum += h[n];
+    }
+    std::vector<float> out(taps);
+    for (size_t n = 0; n < taps; n++) {
+        out[n] = static_cast<float>(h[n] * gain / sum);
+    }
+    return out;
+}
+
+void PolyphaseUpsampler::process(SampleType *RESTRICT out, const SampleType *RESTRICT in, size_t inSamples) {
+    inSamples = std::min(inSamples, mMaxInputSamples);
+    SampleType *history = mHistory.data();
+    ::memcpy(history + tapsPerPhase - 1, in, inSamples * sizeof(SampleType));
+
+    for (size_t n = 0; n < inSamples; n++) {
+        const SampleType *window = history + n;
+        for (unsigned int phase = 0; phase < mFactor; phase++) {
+            const float *taps = mPhaseTaps.data() + phase * tapsPerPhase;
+            float        acc  = 0.0f;
+            for (size_t tap = 0; tap < tapsPerPhase; tap++) {
+                acc += taps[tap] * window[tap];
+            }
+            *out++ = acc;
+        }
+    }
+
+    // keep the tail for the next call.
+    ::memmove(history, history + inSamples, (tapsPerPhase - 1) * sizeof(SampleType));
+    mSettled = std::all_of(history, history + tapsPerPhase - 1, [](SampleType s) {
+        return s == 0.0f;
+    });
+}
+
+void PolyphaseUpsampler::reset() {
+    std::fill(mHistory.begin(), mHistory.end(), 0.0f);
+    mSettled = true;
+}
@@ -50,13 +50,13 @@ SourceStatus RecordedSampleSource::getAudioFrame(SampleType *bufferOut) {
             mCurPosition = 0;
             mFirstFrame  = true;
         }
-        auto maxCopy = min<size_t>(frameSizeSamples - bufOffset, sourceLength - mCurPosition);
+        auto maxCopy = min<size_t>(mFrameSamples - bufOffset, sourceLength - mCurPosition);
         ::memcpy(bufferOut + bufOffset, mSampleSource->data() + mCurPosition, maxCopy * sizeof(SampleType));
         mCurPosition += maxCopy;
         bufOffset += maxCopy;
-    } while (mLoop && bufOffset < frameSizeSamples);
-    if (bufOffset < frameSizeSamples) {
-        const size_t fillSize = frameSizeSamples - bufOffset;
+    } while (mLoop && bufOffset < mFrameSamples);
+    if (bufOffset < mFrameSamples) {
+        const size_t fillSize = mFrameSamples - bufOffset;
         ::memset(bufferOut + bufOffset, 0, sizeof(SampleType) * fillSize);
     }
     if (!mLoop && mCurPosition >= mSampleSource->lengthInSamples()) {
@@ -65,19 +65,25 @@ SourceStatus RecordedSampleSource::getAudioFrame(SampleType *bufferOut) {
     return SourceStatus::OK;
 }
 
-RecordedSampleSource::RecordedSampleSource(const std::shared_ptr<ISampleStorage> src, bool loop):
-    mSampleSource(src), mLoop(loop), mPlay(true), mCurPosition(0), mFirstFrame(false) {
+RecordedSampleSource::RecordedSampleSource(const std::shared_ptr<ISampleStorage> src, bool loop, size_t frameSamples):
+    mSampleSource(src), mLoop(loop), mPlay(true), mCurPosition(0), mFrameSamples(std::min<size_t>(frameSamples, frameSizeSamples)), mFirstFrame(false) {
 }
 
 RecordedSampleSource::~RecordedSampleSource() {
 }
 
+void RecordedSampleSource::setFrameSamples(size_t frameSamples) {
+    mFrameSamples = std::min<size_t>(frameSamples, frameSizeSamples);
+}
+
 bool RecordedSampleSource::isPlaying() const {
     return mPlay;
 }
 
 void RecordedSampleSource::reset() {
     mCurPosition = 0;
+    mPlay        = true;
+    mFirstFrame  = false;
 }
 
 bool RecordedSampleSource::firstFrame() {
@@ -1,10 +1,12 @@
 #include "afv-native/audio/SimpleCompressorEffect.h"
+#include <algorithm>
 
 using namespace afv_native::audio;
 
-SimpleCompressorEffect::SimpleCompressorEffect()
+SimpleCompressorEffect::SimpleCompressorEffect(int sampleRate, size_t frameSamples) :
+    m_frameSamples(static_cast<int>(std::min<size_t>(frameSamples > 0 ? frameSamples : sampleRate * frameLengthMs / 1000, frameSizeSamples)))
 {
-    sf_defaultcomp(&m_simpleCompressor, sampleRateHz);
+    sf_defaultcomp(&m_simpleCompressor, sampleRate);
 }
 
 SimpleCompressorEffect::~SimpleCompressorEffect()
@@ -14,21 +16,17 @@ SimpleCompressorEffect::~SimpleCompressorEffect()
 
 void SimpleCompressorEffect::transformFrame(SampleType *bufferOut, const SampleType bufferIn[])
 {
-    sf_snd output_snd = sf_snd_new(frameSizeSamples, sampleRateHz, true);
-    sf_snd input_snd = sf_snd_new(frameSizeSamples, sampleRateHz, true);
-
-    for(int i = 0; i < frameSizeSamples; i++)
+    // the work buffers are members so this doesn't hit the allocator twice a frame.
+    for(int i = 0; i < m_frameSamples; i++)
     {
-        input_snd->samples[i].L = bufferIn[i];
+        m_inputSamples[i].L = bufferIn[i];
+        m_inputSamples[i].R = 0.0f;
     }
 
-    sf_compressor_process(&m_simpleCompressor, frameSizeSamples, input_snd->samples, output_snd->samples);
+    sf_compressor_process(&m_simpleCompressor, m_frameSamples, m_inputSamples, m_outputSamples);
 
-    for(int i = 0; i < frameSizeSamples; i++)
+    for(int i = 0; i < m_frameSamples; i++)
     {
-        bufferOut[i] = static_cast<SampleType>(output_snd->samples[i].L);
+        bufferOut[i] = static_cast<SampleType>(m_outputSamples[i].L);
     }
-
-    sf_snd_free(input_snd);
-    sf_snd_free(output_snd);
 }
@@ -37,14 +37,18 @@
 using namespace ::afv_native::audio;
 using namespace ::std;
 
-SineToneSource::SineToneSource(double freqHz, float gain):
-    mFrequency(freqHz), mGain(gain), mFillCount(0) {
+SineToneSource::SineToneSource(double freqHz, float gain, int sampleRate, size_t frameSamples):
+    mFrequency(freqHz), mGain(gain), mFillCount(0), mSampleRate(sampleRate), mFrameSamples(frameSamples > 0 ? frameSamples : mSampleRate * frameLengthMs / 1000) {
+}
+
+void SineToneSource::reset() {
+    mFillCount = 0;
 }
 
 SourceStatus SineToneSource::getAudioFrame(SampleType *bufferOut) {
-    const double sinMultiplier = M_PI * 2.0 * static_cast<double>(mFrequency) / static_cast<double>(sampleRateHz);
-    for (int i = 0; i < frameSizeSamples; i++) {
-        bufferOut[i] = static_cast<SampleType>(mGain * sin(sinMultiplier * static_cast<double>(i + (frameSizeSamples * mFillCount))));
+    const double sinMultiplier = M_PI * 2.0 * static_cast<double>(mFrequency) / static_cast<double>(mSampleRate);
+    for (size_t i = 0; i < mFrameSamples; i++) {
+        bufferOut[i] = static_cast<SampleType>(mGain * sin(sinMultiplier * static_cast<double>(i + (mFrameSamples * mFillCount))));
     }
     mFillCount++;
     return SourceStatus::OK;
@@ -34,12 +34,24 @@
 #include "afv-native/audio/VHFFilterSource.h"
 #include <simpleSource/SimpleComp.h>
 #include <simpleSource/SimpleLimit.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <random>
+#include <utility>
 
 using namespace afv_native::audio;
 
-VHFFilterSource::VHFFilterSource(HardwareType hd):
-    compressor(new chunkware_simple::SimpleComp()), limiter(new chunkware_simple::SimpleLimit()) {
-    compressor->setSampleRate(sampleRateHz);
+namespace {
+    /** the economy gains measured so far, by hardware and sample rate */
+    std::mutex                                                economyGainsLock;
+    std::map<std::pair<afv_native::HardwareType, int>, float> economyGains;
+} // namespace
+
+VHFFilterSource::VHFFilterSource(HardwareType hd, int sampleRate, size_t frameSamples):
+    compressor(new chunkware_simple::SimpleComp()), limiter(new chunkware_simple::SimpleLimit()), mSampleRate(sampleRate), mFrameSamples(std::min<size_t>(frameSamples > 0 ? frameSamples : sampleRate * frameLengthMs / 1000, frameSizeSamples)) {
+    compressor->setSampleRate(mSampleRate);
     compressor->setAttack(0.1);
     compressor->setRelease(80.0);
     compressor->setThresh(-8.0);
@@ -49,7 +61,7 @@ VHFFilterSource::VHFFilterSource(HardwareType hd):
     compressorPostGain = pow(10.0f, (-5.5 / 20.0));
 
     limiter->setAttack(0.1);
-    limiter->setSampleRate(sampleRateHz);
+    limiter->setSampleRate(mSampleRate);
     limiter->setRelease(80.0);
     limiter->setThresh(8.0);
     limiter->initRuntime();
@@ -57,39 +69,115 @@ VHFFilterSource::VHFFilterSource(HardwareType hd):
     this->hardware = hd;
 
     setupPresets();
+    matchEconomyGain();
 }
 
 VHFFilterSource::~VHFFilterSource() {
     delete compressor;
+    delete limiter;
 };
 
+void VHFFilterSource::reset() {
+    compressor->initRuntime();
+    limiter->initRuntime();
+    for (auto &filter: mFilters) {
+        filter.reset();
+    }
+    for (auto &filter: mEconomyFilters) {
+        filter.reset();
+    }
+    mEconomyActive = false;
+}
+
+void VHFFilterSource::matchEconomyGain() {
+    std::lock_guard<std::mutex> economyGainsGuard(economyGainsLock);
+    const auto                  key = std::make_pair(hardware, mSampleRate);
+    auto                        it  = economyGains.find(key);
+    if (it == economyGains.end()) {
+        it = economyGains.emplace(key, measureEconomyGain()).first;
+        reset();
+    }
+    mEconomyGain = it->second;
+}
+
+float VHFFilterSource::measureEconomyGain() {
+    // half a second of pink noise - roughly the long term spectrum of speech - at about the
+    // level of received speech, with the first 50ms left out while the filters and the
+    // compressor settle.  The pinking filter is Paul Kellet's economy one.
+    const size_t                          samples = static_cast<size_t>(mSampleRate / 2);
+    const size_t                          settle  = static_cast<size_t>(mSampleRate / 20);
+    std::minstd_rand                       rng(1);
+    std::uniform_real_distribution<double> white(-1.0, 1.0);
+    double                                 pink[3]       = {};
+    double                                 fullEnergy    = 0.0;
+    double                                 economyEnergy = 0.0;
+    for (size_t i = 0; i < samples; i++) {
+        const double w  = white(rng);
+        pink[0]         = 0.99765 * pink[0] + w * 0.0990460;
+        pink[1]         = 0.96300 * pink[1] + w * 0.2965164;
+        pink[2]         = 0.57000 * pink[2] + w * 1.0526913;
+        const double in = (pink[0] + pink[1] + pink[2] + w * 0.1848) * 0.05;
+        double       sl = in;
+        double       sr = in;
+        compressor->process(sl, sr);
+        for (auto &filter: mFilters) {
+            sl = filter.TransformOne(sl);
+        }
+        limiter->process(sl, sr);
+        sl *= compressorPostGain;
+
+        double economy = in;
+        for (auto &filter: mEconomyFilters) {
+            economy = filter.TransformOne(economy);
+        }
+        if (i >= settle) {
+            fullEnergy += sl * sl;
+            economyEnergy += economy * economy;
+        }
+    }
+    return economyEnergy > 0.0 ? static_cast<float>(std::sqrt(fullEnergy / economyEnergy)) : compressorPostGain;
+}
+
 void VHFFilterSource::setupPresets() {
     if (hardware == HardwareType::Schmid_ED_137B) {
-        mFilters.push_back(BiQuadFilter::highPassFilter(sampleRateHz, 310, 0.25));
-        mFilters.push_back(BiQuadFilter::peakingEQ(sampleRateHz, 450, 0.75, 12.0));
-        mFilters.push_back(BiQuadFilter::peakingEQ(sampleRateHz, 1450, 1.0, 20.0));
-        mFilters.push_back(BiQuadFilter::peakingEQ(sampleRateHz, 2000, 1.0, 20.0));
-        mFilters.push_back(BiQuadFilter::lowPassFilter(sampleRateHz, 2500, 0.25));
+        mFilters.push_back(BiQuadFilter::highPassFilter(mSampleRate, 310, 0.25));
+        mFilters.push_back(BiQuadFilter::peakingEQ(mSampleRate, 450, 0.75, 12.0));
+        mFilters.push_back(BiQuadFilter::peakingEQ(mSampleRate, 1450, 1.0, 20.0));
+        mFilters.push_back(BiQuadFilter::peakingEQ(mSampleRate, 2000, 1.0, 20.0));
+        mFilters.push_back(BiQuadFilter::lowPassFilter(mSampleRate, 2500, 0.25));
+
+        mEconomyFilters.push_back(BiQuadFilter::highPassFilter(mSampleRate, 310, 0.25));
+        mEconomyFilters.push_back(BiQuadFilter::lowPassFilter(mSampleRate, 2500, 0.25));
     }
 
     if (hardware == HardwareType::Garex_220) {
-        mFilters.push_back(BiQuadFilter::highPassFilter(sampleRateHz, 300, 0.25));
-        mFilters.push_back(BiQuadFilter::highShelfFilter(sampleRateHz, 400, 1.0, 8.0));
-        mFilters.push_back(BiQuadFilter::highShelfFilter(sampleRateHz, 600, 1.0, 4.0));
-        mFilters.push_back(BiQuadFilter::lowShelfFilter(sampleRateHz, 2000, 1.0, 1.0));
-        mFilters.push_back(BiQuadFilter::lowShelfFilter(sampleRateHz, 2400, 1.0, 3.0));
-        mFilters.push_back(BiQuadFilter::lowShelfFilter(sampleRateHz, 3000, 1.0, 10.0));
-        mFilters.push_back(BiQuadFilter::lowPassFilter(sampleRateHz, 3400, 0.25));
+        mFilters.push_back(BiQuadFilter::highPassFilter(mSampleRate, 300, 0.25));
+        mFilters.push_back(BiQuadFilter::highShelfFilter(mSampleRate, 400, 1.0, 8.0));
+        mFilters.push_back(BiQuadFilter::highShelfFilter(mSampleRate, 600, 1.0, 4.0));
+        mFilters.push_back(BiQuadFilter::lowShelfFilter(mSampleRate, 2000, 1.0, 1.0));
+        mFilters.push_back(BiQuadFilter::lowShelfFilter(mSampleRate, 2400, 1.0, 3.0));
+        mFilters.push_back(BiQuadFilter::lowShelfFilter(mSampleRate, 3000, 1.0, 10.0));
+        mFilters.push_back(BiQuadFilter::lowPassFilter(mSampleRate, 3400, 0.25));
+
+        mEconomyFilters.push_back(BiQuadFilter::highPassFilter(mSampleRate, 300, 0.25));
+        mEconomyFilters.push_back(BiQuadFilter::lowPassFilter(mSampleRate, 3400, 0.25));
     }
 
     if (hardware == HardwareType::Rockwell_Collins_2100) {
-        mFilters.push_back(BiQuadFilter::customBuild(1.0, 0.0, 0.0, -0.01, 0.0, 0.0));
-        mFilters.push_back(BiQuadFilter::customBuild(1.0, -1.7152995098277, 0.761385315196423, 0.0, 1.0, 0.753162969638192));
-        mFilters.push_back(BiQuadFilter::customBuild(1.0, -1.71626681678914, 0.762433947105989, 1.0, -2.29278115712509, 1.000336632935775));
-        mFilters.push_back(BiQuadFilter::customBuild(1.0, -1.79384214686345, 0.909678364879526, 1.0, -2.05042803669041, 1.05048374237779));
-        mFilters.push_back(BiQuadFilter::customBuild(1.0, -1.79409285259567, 0.909822671281377, 1.0, -1.95188929743297, 0.951942325888074));
-        mFilters.push_back(BiQuadFilter::customBuild(1.0, -1.9390093095185, 0.9411847259142, 1.0, -1.82547932903698, 1.09157529229851));
-        mFilters.push_back(BiQuadFilter::customBuild(1.0, -1.94022767750807, 0.942630574503006, 1.0, -1.67241244173042, 0.916184578658119));
+        // this response was designed at the normal sample rate - keep it true up to the top
+        // of its passband at any other.
+        const float rockwellMatchHz = 2500.0f;
+        mFilters.push_back(BiQuadFilter::customBuildAtRate(sampleRateHz, mSampleRate, rockwellMatchHz, 1.0, 0.0, 0.0, -0.01, 0.0, 0.0));
+        mFilters.push_back(BiQuadFilter::customBuildAtRate(sampleRateHz, mSampleRate, rockwellMatchHz, 1.0, -1.7152995098277, 0.761385315196423, 0.0, 1.0, 0.753162969638192));
+        mFilters.push_back(BiQuadFilter::customBuildAtRate(sampleRateHz, mSampleRate, rockwellMatchHz, 1.0, -1.71626681678914, 0.762433947105989, 1.0, -2.29278115712509, 1.000336632935775));
+        mFilters.push_back(BiQuadFilter::customBuildAtRate(sampleRateHz, mSampleRate, rockwellMatchHz, 1.0, -1.79384214686345, 0.909678364879526, 1.0, -2.05042803669041, 1.05048374237779));
+        mFilters.push_back(BiQuadFilter::customBuildAtRate(sampleRateHz, mSampleRate, rockwellMatchHz, 1.0, -1.79409285259567, 0.909822671281377, 1.0, -1.95188929743297, 0.951942325888074));
+        mFilters.push_back(BiQuadFilter::customBuildAtRate(sampleRateHz, mSampleRate, rockwellMatchHz, 1.0, -1.9390093095185, 0.9411847259142, 1.0, -1.82547932903698, 1.09157529229851));
+        mFilters.push_back(BiQuadFilter::customBuildAtRate(sampleRateHz, mSampleRate, rockwellMatchHz, 1.0, -1.94022767750807, 0.942630574503006, 1.0, -1.67241244173042, 0.916184578658119));
+
+        // roughly the passband of the full response above.
+        mEconomyFilters.push_back(BiQuadFilter::highPassFilter(mSampleRate, 300, 0.25));
+        mEconomyFilters.push_back(BiQuadFilter::lowPassFilter(mSampleRate, 3000, 0.25));
     }
 }
 
@@ -100,8 +188,18 @@ void VHFFilterSource::setupPresets() {
  *
  */
 void VHFFilterSource::transformFrame(SampleType *bufferOut, SampleType const bufferIn[]) {
+    if (mEconomyActive) {
+        // coming back from the economy chain - don't carry on from what this one was doing
+        // when it was left.
+        compressor->initRuntime();
+        limiter->initRuntime();
+        for (auto &filter: mFilters) {
+            filter.reset();
+        }
+        mEconomyActive = false;
+    }
     double sl, sr;
-    for (unsigned i = 0; i < frameSizeSamples; i++) {
+    for (unsigned i = 0; i < mFrameSamples; i++) {
         sl = bufferIn[i];
         sr = sl;
 
@@ -115,4 +213,22 @@ void VHFFilterSource::transformFrame(SampleType *bufferOut, SampleType const buf
 
         bufferOut[i] = sl;
     }
-}
\ No newline at end of file
+}
+
+void VHFFilterSource::transformFrameEconomy(SampleType *bufferOut, SampleType const bufferIn[]) {
+    if (!mEconomyActive) {
+        for (auto &filter: mEconomyFilters) {
+            filter.reset();
+        }
+        mEconomyActive = true;
+    }
+    double sl;
+    for (unsigned i = 0; i < mFrameSamples; i++) {
+        sl = bufferIn[i];
+        for (auto &filter: mEconomyFilters) {
+            sl = filter.TransformOne(sl);
+        }
+        // there's no limiter, so clip rather than let the peaks through.
+        bufferOut[i] = std::max(-1.0f, std::min(1.0f, static_cast<float>(sl) * mEconomyGain));
+    }
+}
@@ -0,0 +1,215 @@
+#include "afv-native/audio/kernels.h"
+#include "kernels_impl.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+using namespace afv_native::audio;
+using namespace afv_native::audio::kernels;
+
+namespace {
+    /* The scalar versions are the reference the SIMD ones are checked against, so keep them
+     * as plain as possible. */
+    void scalar_mix(SampleType *RESTRICT dst, const SampleType *RESTRICT src, float gain, size_t numSamples) {
+        for (size_t i = 0; i < numSamples; i++) {
+            dst[i] += gain * src[i];
+        }
+    }
+
+    void scalar_scale(SampleType *buf, float gain, size_t numSamples) {
+        for (size_t i = 0; i < numSamples; i++) {
+            buf[i] *= gain;
+        }
+    }
+
+    void scalar_clamp(SampleType *buf, size_t numSamples) {
+        for (size_t i = 0; i < numSamples; i++) {
+            buf[i] = clamp_sample(buf[i]);
+        }
+    }
+
+    void scalar_mixClamp(SampleType *RESTRICT dst, const SampleType *RESTRICT src, float gain, size_t numSamples) {
+        for (size_t i = 0; i < numSamples; i++) {
+            dst[i] = clamp_sample(dst[i] + gain * src[i]);
+        }
+    }
+
+    void scalar_scaleClamp(SampleType *dst, const SampleType *src, float gain, size_t numSamples) {
+        for (size_t i = 0; i < numSamples; i++) {
+            dst[i] = clamp_sample(src[i] * gain);
+        }
+    }
+
+    void scalar_levels(const SampleType *buf, size_t numSamples, float &peak, float &sumSquares) {
+        peak       = 0.0f;
+        sumSquares = 0.0f;
+        for (size_t i = 0; i < numSamples; i++) {
+            peak = std::max(peak, std::fabs(buf[i]));
+            sumSquares += buf[i] * buf[i];
+        }
+    }
+
+    void scalar_interleave(const SampleType *RESTRICT left, const SampleType *RESTRICT right, SampleType *RESTRICT out, size_t numSamples) {
+        for (size_t i = 0; i < numSamples; i++) {
+            out[2 * i]     = left[i];
+            out[2 * i + 1] = right[i];
+        }
+    }
+
+    void scalar_mixMonoToStereo(SampleType *RESTRICT stereo, const SampleType *RESTRICT mono, float gainLeft, float gainRight, size_t numSamples) {
+        for (size_t i = 0; i < numSamples; i++) {
+            stereo[2 * i] += gainLeft * mono[i];
+            stereo[2 * i + 1] += gainRight * mono[i];
+        }
+    }
+
+    const KernelTable gScalarTable = {
+        Isa::Scalar,
+        scalar_mix,
+        scalar_scale,
+        scalar_clamp,
+        scalar_mixClamp,
+        scalar_scaleClamp,
+        scalar_levels,
+        scalar_interleave,
+        scalar_mixMonoToStereo,
+    };
+
+    bool cpu_has_avx2() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        int regs[4];
+        __cpuid(regs, 0);
+        if (regs[0] < 7) {
+            return false;
+        }
+        __cpuid(regs, 1);
+        const bool osxsave = (regs[2] & (1 << 27)) != 0;
+        const bool avx     = (regs[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+            // the OS isn't saving the YMM registers for us.
+            return false;
+        }
+        __cpuidex(regs, 7, 0);
+        return (regs[1] & (1 << 5)) != 0;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+
+    const KernelTable *table_for(Isa isa) {
+        switch (isa) {
+            case Isa::Scalar:
+                return &gScalarTable;
+            case Isa::SSE2:
+                return sse2Table();
+            case Isa::AVX2:
+                return cpu_has_avx2() ? avx2Table() : nullptr;
+            case Isa::NEON:
+                return neonTable();
+        }
+        return nullptr;
+    }
+
+    const KernelTable *best_table() {
+        for (Isa isa: {Isa::AVX2, Isa::SSE2, Isa::NEON}) {
+            const KernelTable *table = table_for(isa);
+            if (table != nullptr) {
+                return table;
+            }
+        }
+        return &gScalarTable;
+    }
+
+    /* Picked on first use.  That's cheap (a few cpuid calls, no allocation) so it's fine for it to
+     * happen on an audio thread. */
+    std::atomic<const KernelTable *> &active_table() {
+        static std::atomic<const KernelTable *> active(best_table());
+        return active;
+    }
+
+    inline const KernelTable &kt() {
+        return *active_table().load(std::memory_order_relaxed);
+    }
+} // namespace
+
+const KernelTable *afv_native::audio::kernels::scalarTable() {
+    return &gScalarTable;
+}
+
+const char *afv_native::audio::kernels::isaName(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar:
+            return "Scalar";
+        case Isa::SSE2:
+            return "SSE2";
+        case Isa::AVX2:
+            return "AVX2";
+        case Isa::NEON:
+            return "NEON";
+    }
+    return "unknown";
+}
+
+bool afv_native::audio::kernels::isaSupported(Isa isa) {
+    return table_for(isa) != nullptr;
+}
+
+Isa afv_native::audio::kernels::activeIsa() {
+    return kt().isa;
+}
+
+bool afv_native::audio::kernels::selectIsa(Isa isa) {
+    const KernelTable *table = table_for(isa);
+    if (table == nullptr) {
+        return false;
+    }
+    active_table().store(table, std::memory_order_relaxed);
+    return true;
+}
+
+void afv_native::audio::kernels::mix(SampleType *RESTRICT dst, const SampleType *RESTRICT src, float gain, size_t numSamples) {
+    kt().mix(dst, src, gain, numSamples);
+}
+
+void afv_native::audio::kernels::scale(SampleType *buf, float gain, size_t numSamples) {
+    kt().scale(buf, gain, numSamples);
+}
+
+void afv_native::audio::kernels::clamp(SampleType *buf, size_t numSamples) {
+    kt().clamp(buf, numSamples);
+}
+
+void afv_native::audio::kernels::mixClamp(SampleType *RESTRICT dst, const SampleType *RESTRICT src, float gain, size_t numSamples) {
+    kt().mixClamp(dst, src, gain, numSamples);
+}
+
+void afv_native::audio::kernels::scaleClamp(SampleType *dst, const SampleType *src, float gain, size_t numSamples) {
+    kt().scaleClamp(dst, src, gain, numSamples);
+}
+
+Levels afv_native::audio::kernels::levels(const SampleType *buf, size_t numSamples) {
+    Levels rv {0.0f, 0.0f};
+    if (numSamples == 0) {
+        return rv;
+    }
+    float sumSquares = 0.0f;
+    kt().levels(buf, numSamples, rv.peak, sumSquares);
+    rv.rms = std::sqrt(sumSquares / static_cast<float>(numSamples));
+    return rv;
+}
+
+void afv_native::audio::kernels::interleave(const SampleType *RESTRICT left, const SampleType *RESTRICT right, SampleType *RESTRICT out, size_t numSamples) {
+    kt().interleave(left, right, out, numSamples);
+}
+
+void afv_native::audio::kernels::mixMonoToStereo(SampleType *RESTRICT stereo, const SampleType *RESTRICT mono, float gainLeft, float gainRight, size_t numSamples) {
+    kt().mixMonoToStereo(stereo, mono, gainLeft, gainRight, numSamples);
+}
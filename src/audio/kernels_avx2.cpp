@@ -0,0 +1,71 @@
+#include "kernels_impl.h"
+
+/* Only built with AVX2 code generation when the build enables it for this file (see
+ * CMakeLists.txt) - the dispatcher checks the CPU before using any of it. */
+#if defined(__AVX2__)
+#define AFV_NATIVE_KERNELS_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace afv_native { namespace audio { namespace kernels {
+#ifdef AFV_NATIVE_KERNELS_AVX2
+    namespace {
+        struct Avx2 {
+            using Vec                       = __m256;
+            static constexpr size_t width = 8;
+
+            static Vec load(const float *p) {
+                return _mm256_loadu_ps(p);
+            }
+            static void store(float *p, Vec v) {
+                _mm256_storeu_ps(p, v);
+            }
+            static Vec set1(float x) {
+                return _mm256_set1_ps(x);
+            }
+            static Vec add(Vec a, Vec b) {
+                return _mm256_add_ps(a, b);
+            }
+            static Vec mul(Vec a, Vec b) {
+                return _mm256_mul_ps(a, b);
+            }
+            static Vec min(Vec a, Vec b) {
+                return _mm256_min_ps(a, b);
+            }
+            static Vec max(Vec a, Vec b) {
+                return _mm256_max_ps(a, b);
+            }
+            static Vec abs(Vec v) {
+                return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v);
+            }
+            static float reduceAdd(Vec v) {
+                __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+                sum        = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+                sum        = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+                return _mm_cvtss_f32(sum);
+            }
+            static float reduceMax(Vec v) {
+                __m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+                m        = _mm_max_ps(m, _mm_movehl_ps(m, m));
+                m        = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+                return _mm_cvtss_f32(m);
+            }
+            static void zip(Vec a, Vec b, Vec &lo, Vec &hi) {
+                // the unpacks work within each 128-bit lane, so put the lanes back in order after.
+                const Vec l = _mm256_unpacklo_ps(a, b);
+                const Vec h = _mm256_unpackhi_ps(a, b);
+                lo          = _mm256_permute2f128_ps(l, h, 0x20);
+                hi          = _mm256_permute2f128_ps(l, h, 0x31);
+            }
+        };
+    } // namespace
+
+    const KernelTable *avx2Table() {
+        return VectorKernels<Avx2>::table(Isa::AVX2);
+    }
+#else
+    const KernelTable *avx2Table() {
+        return nullptr;
+    }
+#endif
+}}} // namespace afv_native::audio::kernels
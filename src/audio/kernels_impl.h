@@ -0,0 +1,184 @@
+#pragma once
+#include "afv-native/audio/kernels.h"
+
+/* Internal to the kernel sources.
+ *
+ * Each instruction set gets its own translation unit so that it can be compiled with the flags
+ * it needs (-mavx2 and friends) without letting the compiler use those instructions anywhere
+ * else.  The loops are written once, in VectorKernels, against a small traits type per ISA.
+ *
+ * Everything instantiated from here must have internal linkage: if an inline function compiled
+ * with -mavx2 were emitted with external linkage, the linker would be free to use that copy
+ * from the SSE2 or scalar code too.  That's why the templates live in an anonymous namespace
+ * and why they stay clear of std::min/std::max/std::fabs and friends.
+ */
+namespace afv_native { namespace audio { namespace kernels {
+    struct KernelTable {
+        Isa isa;
+        void (*mix)(SampleType *RESTRICT dst, const SampleType *RESTRICT src, float gain, size_t numSamples);
+        void (*scale)(SampleType *buf, float gain, size_t numSamples);
+        void (*clamp)(SampleType *buf, size_t numSamples);
+        void (*mixClamp)(SampleType *RESTRICT dst, const SampleType *RESTRICT src, float gain, size_t numSamples);
+        void (*scaleClamp)(SampleType *dst, const SampleType *src, float gain, size_t numSamples);
+        void (*levels)(const SampleType *buf, size_t numSamples, float &peak, float &sumSquares);
+        void (*interleave)(const SampleType *RESTRICT left, const SampleType *RESTRICT right, SampleType *RESTRICT out, size_t numSamples);
+        void (*mixMonoToStereo)(SampleType *RESTRICT stereo, const SampleType *RESTRICT mono, float gainLeft, float gainRight, size_t numSamples);
+    };
+
+    /* The xxxTable() functions return nullptr if that ISA wasn't built for this target.  They
+     * don't check the CPU - that's up to the dispatcher. */
+    const KernelTable *scalarTable();
+    const KernelTable *sse2Table();
+    const KernelTable *avx2Table();
+    const KernelTable *neonTable();
+
+    namespace {
+        inline float clamp_sample(float value) {
+            if (value > 1.0f) {
+                value = 1.0f;
+            }
+            if (value < -1.0f) {
+                value = -1.0f;
+            }
+            return value;
+        }
+
+        /** VectorKernels implements the kernel set on top of V, which provides:
+         *
+         *  - Vec, width
+         *  - load(), store() (unaligned), set1(), add(), mul(), min(), max(), abs()
+         *  - reduceAdd(), reduceMax()
+         *  - zip(a, b, lo, hi) - interleave a and b into two vectors
+         *
+         * Tails shorter than one vector are handled with plain scalar code.
+         */
+        template <typename V>
+        struct VectorKernels {
+            using Vec = typename V::Vec;
+            static constexpr size_t W = V::width;
+
+            static void mix(SampleType *RESTRICT dst, const SampleType *RESTRICT src, float gain, size_t numSamples) {
+                const Vec g = V::set1(gain);
+                size_t    i = 0;
+                for (; i + W <= numSamples; i += W) {
+                    V::store(dst + i, V::add(V::load(dst + i), V::mul(g, V::load(src + i))));
+                }
+                for (; i < numSamples; i++) {
+                    dst[i] += gain * src[i];
+                }
+            }
+
+            static void scale(SampleType *buf, float gain, size_t numSamples) {
+                const Vec g = V::set1(gain);
+                size_t    i = 0;
+                for (; i + W <= numSamples; i += W) {
+                    V::store(buf + i, V::mul(V::load(buf + i), g));
+                }
+                for (; i < numSamples; i++) {
+                    buf[i] *= gain;
+                }
+            }
+
+            static Vec clampVec(Vec value, Vec lo, Vec hi) {
+                return V::max(V::min(value, hi), lo);
+            }
+
+            static void clamp(SampleType *buf, size_t numSamples) {
+                const Vec hi = V::set1(1.0f);
+                const Vec lo = V::set1(-1.0f);
+                size_t    i  = 0;
+                for (; i + W <= numSamples; i += W) {
+                    V::store(buf + i, clampVec(V::load(buf + i), lo, hi));
+                }
+                for (; i < numSamples; i++) {
+                    buf[i] = clamp_sample(buf[i]);
+                }
+            }
+
+            static void mixClamp(SampleType *RESTRICT dst, const SampleType *RESTRICT src, float gain, size_t numSamples) {
+                const Vec g  = V::set1(gain);
+                const Vec hi = V::set1(1.0f);
+                const Vec lo = V::set1(-1.0f);
+                size_t    i  = 0;
+                for (; i + W <= numSamples; i += W) {
+                    const Vec mixed = V::add(V::load(dst + i), V::mul(g, V::load(src + i)));
+                    V::store(dst + i, clampVec(mixed, lo, hi));
+                }
+                for (; i < numSamples; i++) {
+                    dst[i] = clamp_sample(dst[i] + gain * src[i]);
+                }
+            }
+
+            static void scaleClamp(SampleType *dst, const SampleType *src, float gain, size_t numSamples) {
+                const Vec g  = V::set1(gain);
+                const Vec hi = V::set1(1.0f);
+                const Vec lo = V::set1(-1.0f);
+                size_t    i  = 0;
+                for (; i + W <= numSamples; i += W) {
+                    V::store(dst + i, clampVec(V::mul(V::load(src + i), g), lo, hi));
+                }
+                for (; i < numSamples; i++) {
+                    dst[i] = clamp_sample(src[i] * gain);
+                }
+            }
+
+            static void levels(const SampleType *buf, size_t numSamples, float &peak, float &sumSquares) {
+                Vec    peakVec = V::set1(0.0f);
+                Vec    sumVec  = V::set1(0.0f);
+                size_t i       = 0;
+                for (; i + W <= numSamples; i += W) {
+                    const Vec value = V::load(buf + i);
+                    peakVec         = V::max(peakVec, V::abs(value));
+                    sumVec          = V::add(sumVec, V::mul(value, value));
+                }
+                float p = V::reduceMax(peakVec);
+                float s = V::reduceAdd(sumVec);
+                for (; i < numSamples; i++) {
+                    const float magnitude = buf[i] < 0.0f ? -buf[i] : buf[i];
+                    if (magnitude > p) {
+                        p = magnitude;
+                    }
+                    s += buf[i] * buf[i];
+                }
+                peak       = p;
+                sumSquares = s;
+            }
+
+            static void interleave(const SampleType *RESTRICT left, const SampleType *RESTRICT right, SampleType *RESTRICT out, size_t numSamples) {
+                size_t i = 0;
+                for (; i + W <= numSamples; i += W) {
+                    Vec lo, hi;
+                    V::zip(V::load(left + i), V::load(right + i), lo, hi);
+                    V::store(out + 2 * i, lo);
+                    V::store(out + 2 * i + W, hi);
+                }
+                for (; i < numSamples; i++) {
+                    out[2 * i]     = left[i];
+                    out[2 * i + 1] = right[i];
+                }
+            }
+
+            static void mixMonoToStereo(SampleType *RESTRICT stereo, const SampleType *RESTRICT mono, float gainLeft, float gainRight, size_t numSamples) {
+                const Vec gl = V::set1(gainLeft);
+                const Vec gr = V::set1(gainRight);
+                size_t    i  = 0;
+                for (; i + W <= numSamples; i += W) {
+                    const Vec m = V::load(mono + i);
+                    Vec       lo, hi;
+                    V::zip(V::mul(gl, m), V::mul(gr, m), lo, hi);
+                    V::store(stereo + 2 * i, V::add(V::load(stereo + 2 * i), lo));
+                    V::store(stereo + 2 * i + W, V::add(V::load(stereo + 2 * i + W), hi));
+                }
+                for (; i < numSamples; i++) {
+                    stereo[2 * i] += gainLeft * mono[i];
+                    stereo[2 * i + 1] += gainRight * mono[i];
+                }
+            }
+
+            static const KernelTable *table(Isa isa) {
+                static const KernelTable t = {isa, mix, scale, clamp, mixClamp, scaleClamp, levels, interleave, mixMonoToStereo};
+                return &t;
+            }
+        };
+    } // namespace
+}}} // namespace afv_native::audio::kernels
@@ -0,0 +1,61 @@
+#include "kernels_impl.h"
+
+// AArch64 only - every AArch64 CPU has NEON, so there's nothing to detect at runtime.
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define AFV_NATIVE_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace afv_native { namespace audio { namespace kernels {
+#ifdef AFV_NATIVE_KERNELS_NEON
+    namespace {
+        struct Neon {
+            using Vec                       = float32x4_t;
+            static constexpr size_t width = 4;
+
+            static Vec load(const float *p) {
+                return vld1q_f32(p);
+            }
+            static void store(float *p, Vec v) {
+                vst1q_f32(p, v);
+            }
+            static Vec set1(float x) {
+                return vdupq_n_f32(x);
+            }
+            static Vec add(Vec a, Vec b) {
+                return vaddq_f32(a, b);
+            }
+            static Vec mul(Vec a, Vec b) {
+                return vmulq_f32(a, b);
+            }
+            static Vec min(Vec a, Vec b) {
+                return vminq_f32(a, b);
+            }
+            static Vec max(Vec a, Vec b) {
+                return vmaxq_f32(a, b);
+            }
+            static Vec abs(Vec v) {
+                return vabsq_f32(v);
+            }
+            static float reduceAdd(Vec v) {
+                return vaddvq_f32(v);
+            }
+            static float reduceMax(Vec v) {
+                return vmaxvq_f32(v);
+            }
+            static void zip(Vec a, Vec b, Vec &lo, Vec &hi) {
+                lo = vzip1q_f32(a, b);
+                hi = vzip2q_f32(a, b);
+            }
+        };
+    } // namespace
+
+    const KernelTable *neonTable() {
+        return VectorKernels<Neon>::table(Isa::NEON);
+    }
+#else
+    const KernelTable *neonTable() {
+        return nullptr;
+    }
+#endif
+}}} // namespace afv_native::audio::kernels
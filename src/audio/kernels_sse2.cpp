@@ -0,0 +1,64 @@
+#include "kernels_impl.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AFV_NATIVE_KERNELS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace afv_native { namespace audio { namespace kernels {
+#ifdef AFV_NATIVE_KERNELS_SSE2
+    namespace {
+        struct Sse2 {
+            using Vec                       = __m128;
+            static constexpr size_t width = 4;
+
+            static Vec load(const float *p) {
+                return _mm_loadu_ps(p);
+            }
+            static void store(float *p, Vec v) {
+                _mm_storeu_ps(p, v);
+            }
+            static Vec set1(float x) {
+                return _mm_set1_ps(x);
+            }
+            static Vec add(Vec a, Vec b) {
+                return _mm_add_ps(a, b);
+            }
+            static Vec mul(Vec a, Vec b) {
+                return _mm_mul_ps(a, b);
+            }
+            static Vec min(Vec a, Vec b) {
+                return _mm_min_ps(a, b);
+            }
+            static Vec max(Vec a, Vec b) {
+                return _mm_max_ps(a, b);
+            }
+            static Vec abs(Vec v) {
+                return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+            }
+            static float reduceAdd(Vec v) {
+                Vec sum = _mm_add_ps(v, _mm_movehl_ps(v, v));
+                sum     = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+                return _mm_cvtss_f32(sum);
+            }
+            static float reduceMax(Vec v) {
+                Vec m = _mm_max_ps(v, _mm_movehl_ps(v, v));
+                m     = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+                return _mm_cvtss_f32(m);
+            }
+            static void zip(Vec a, Vec b, Vec &lo, Vec &hi) {
+                lo = _mm_unpacklo_ps(a, b);
+                hi = _mm_unpackhi_ps(a, b);
+            }
+        };
+    } // namespace
+
+    const KernelTable *sse2Table() {
+        return VectorKernels<Sse2>::table(Isa::SSE2);
+    }
+#else
+    const KernelTable *sse2Table() {
+        return nullptr;
+    }
+#endif
+}}} // namespace afv_native::audio::kernels
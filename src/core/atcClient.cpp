@@ -211,6 +211,7 @@ void ATCClient::startAudio() {
     }
     mSpeakerDevice->setSink(nullptr);
     mSpeakerDevice->setSource(mATCRadioStack->speakerDevice());
+    mSpeakerDevice->setOutputPeriod(static_cast<unsigned int>(mATCRadioStack->getRenderQuantum()));
     LOG("afv::ATCClient", "Speaker Device %s fully setup", mAudioSpeakerDeviceId.c_str());
 
     if (!mSpeakerDevice->openOutput()) {
@@ -240,6 +241,7 @@ void ATCClient::startAudio() {
     }
     mAudioDevice->setSink(mATCRadioStack);
     mAudioDevice->setSource(mATCRadioStack->headsetDevice());
+    mAudioDevice->setOutputPeriod(static_cast<unsigned int>(mATCRadioStack->getRenderQuantum()));
     LOG("afv::ATCClient", "Headset Device %s fully setup", mAudioOutputDeviceId.c_str());
 
     if (mAudioDevice->openOutput()) {
@@ -461,6 +463,54 @@ void ATCClient::setEnableOutputEffects(bool enableEffects) {
     mATCRadioStack->setEnableOutputEffects(enableEffects);
 }
 
+void ATCClient::setDspThreads(unsigned int threads, bool deterministic) {
+    mATCRadioStack->setDspThreads(threads, deterministic);
+}
+
+void ATCClient::setDecodeThreads(unsigned int threads) {
+    mATCRadioStack->setDecodeThreads(threads);
+}
+
+void ATCClient::setSharedNoiseBed(bool shared) {
+    mATCRadioStack->setSharedNoiseBed(shared);
+}
+
+void ATCClient::setMaxDecoders(unsigned int maxDecoders) {
+    mATCRadioStack->setMaxDecoders(maxDecoders);
+}
+
+void ATCClient::setReducedRateDsp(bool reduced) {
+    mATCRadioStack->setReducedRateDsp(reduced);
+}
+
+void ATCClient::setFecPacketLoss(int percent) {
+    mATCRadioStack->setFecPacketLoss(percent);
+}
+
+void ATCClient::setEncoderProfile(const afv::EncoderProfile &profile) {
+    mATCRadioStack->setEncoderProfile(profile);
+}
+
+bool ATCClient::setRenderQuantum(unsigned int samples) {
+    return mATCRadioStack->setRenderQuantum(samples);
+}
+
+void ATCClient::setRenderGovernor(bool enabled, unsigned int budgetUs, bool capDecoders) {
+    if (budgetUs > 0) {
+        mATCRadioStack->setRenderBudget(budgetUs);
+    }
+    mATCRadioStack->setRenderGovernorDecoderCap(capDecoders);
+    mATCRadioStack->setRenderGovernor(enabled);
+}
+
+unsigned int ATCClient::getRenderTier() const {
+    return static_cast<unsigned int>(mATCRadioStack->getRenderTier());
+}
+
+unsigned long long ATCClient::getRenderOverruns() const {
+    return static_cast<unsigned long long>(mATCRadioStack->getRenderOverruns());
+}
+
 void ATCClient::aliasUpdateCallback() {
     ClientEventCallback.invokeAll(ClientEventType::StationAliasesUpdated, nullptr, nullptr);
 }
@@ -517,6 +567,52 @@ void ATCClient::logAudioStatistics() {
         LOG("ATCClient", "Input Buffer Overflows: %d",
             mAudioDevice->InputOverflows.load());
     }
+    LOG("ATCClient", "Render Ticks: %llu (%zu samples each)",
+        static_cast<unsigned long long>(mATCRadioStack->RenderTicks.load()), mATCRadioStack->getRenderQuantum());
+    LOG("ATCClient", "Dropped Bus Frames: %llu",
+        static_cast<unsigned long long>(mATCRadioStack->BusFramesDropped.load()));
+    LOG("ATCClient", "Render Lock Wait: %llu us",
+        static_cast<unsigned long long>(mATCRadioStack->RenderLockWaitNs.load() / 1000));
+    LOG("ATCClient", "Idle Render Ticks: %llu (%llu us idle, %llu us active)",
+        static_cast<unsigned long long>(mATCRadioStack->IdleRenderTicks.load()),
+        static_cast<unsigned long long>(mATCRadioStack->IdleRenderNs.load() / 1000),
+        static_cast<unsigned long long>(mATCRadioStack->ActiveRenderNs.load() / 1000));
+    LOG("ATCClient", "Idle Radios Skipped: %llu",
+        static_cast<unsigned long long>(mATCRadioStack->IdleRadioRenders.load()));
+    LOG("ATCClient", "Decoder Evictions: %llu",
+        static_cast<unsigned long long>(mATCRadioStack->DecoderEvictions.load()));
+    LOG("ATCClient", "Decoder Rejections: %llu",
+        static_cast<unsigned long long>(mATCRadioStack->DecoderRejections.load()));
+    LOG("ATCClient", "Dropped Render Events: %llu",
+        static_cast<unsigned long long>(mATCRadioStack->getDroppedRenderEvents()));
+    LOG("ATCClient", "Render Overruns: %llu (tier %u, %llu tier changes)",
+        static_cast<unsigned long long>(mATCRadioStack->getRenderOverruns()),
+        static_cast<unsigned int>(mATCRadioStack->getRenderTier()),
+        static_cast<unsigned long long>(mATCRadioStack->getRenderTierChanges()));
+    const auto &sourcePool = mATCRadioStack->getSourcePool();
+    const auto  acquires   = sourcePool.Acquires.load();
+    const auto  hits       = sourcePool.Hits.load();
+    LOG("ATCClient", "Decoder Pool: %llu of %llu reused (%.1f%%), peak %zu in use, %zu idle",
+        static_cast<unsigned long long>(hits), static_cast<unsigned long long>(acquires),
+        acquires > 0 ? 100.0 * hits / acquires : 0.0, sourcePool.getPeakInUse(), sourcePool.getIdle());
+    const auto workerFrames = mATCRadioStack->DecodeWorkerFrames.load();
+    LOG("ATCClient", "Decode Workers: %u threads, %llu frames (%.1f us each)",
+        mATCRadioStack->getDecodeThreads(), static_cast<unsigned long long>(workerFrames),
+        workerFrames > 0 ? mATCRadioStack->DecodeWorkerNs.load() / 1000.0 / workerFrames : 0.0);
+    LOG("ATCClient", "Packet Loss: %u%% measured",
+        mATCRadioStack->getMeasuredPacketLoss());
+    std::vector<afv::StreamJitterStats> jitterStats;
+    mATCRadioStack->getStreamJitterStats(jitterStats);
+    for (const auto &stream: jitterStats) {
+        LOG("ATCClient", "Stream %s: %llu late, %llu lost, %llu recovered, %llu concealed, %llu discarded (target delay %u ms)",
+            stream.callsign.c_str(),
+            static_cast<unsigned long long>(stream.late),
+            static_cast<unsigned long long>(stream.lost),
+            static_cast<unsigned long long>(stream.recovered),
+            static_cast<unsigned long long>(stream.concealed),
+            static_cast<unsigned long long>(stream.discarded),
+            stream.targetDelayMs);
+    }
 }
 
 std::shared_ptr<const audio::AudioDevice> ATCClient::getAudioDevice() const {
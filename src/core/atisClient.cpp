@@ -313,7 +313,7 @@ void ATISClient::sendCachedFrame() {
  *
  *
  */
-void ATISClient::processCompressedFrame(std::vector<unsigned char> compressedData) {
+void ATISClient::processCompressedFrame(const std::vector<unsigned char> &compressedData) {
     if (mRecordedSampleSource->firstFrame()) {
         if (looped) {
             printf("\nATIS LOOPED");
@@ -339,7 +339,7 @@ void ATISClient::processCompressedFrame(std::vector<unsigned char> compressedDat
         { audioOutDto.Transceivers.emplace_back(0); }
         audioOutDto.SequenceCounter = std::atomic_fetch_add<uint32_t>(&mTxSequence, 1);
         audioOutDto.Callsign        = mCallsign;
-        audioOutDto.Audio           = std::move(compressedData);
+        audioOutDto.Audio           = compressedData;
 
         mChannel->sendDto(audioOutDto);
     }
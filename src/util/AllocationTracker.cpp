@@ -0,0 +1,118 @@
+#include "afv-native/util/AllocationTracker.h"
+#include "afv-native/Log.h"
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+using namespace afv_native::util;
+
+namespace {
+    std::atomic<uint64_t> gAllocationViolations(0);
+
+#ifdef AFV_NATIVE_TRACK_ALLOCATIONS
+    thread_local uint64_t tAllocationCount = 0;
+
+    void *counted_alloc(std::size_t size) {
+        tAllocationCount++;
+        if (size == 0) {
+            size = 1;
+        }
+        return std::malloc(size);
+    }
+#endif
+} // namespace
+
+#ifdef AFV_NATIVE_TRACK_ALLOCATIONS
+/* Replacement global allocation functions.  Only the plain and nothrow forms are replaced; the
+ * aligned forms fall through to the runtime, which is fine as nothing in the render path uses
+ * over-aligned types. */
+void *operator new(std::size_t size) {
+    void *ptr = counted_alloc(size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new[](std::size_t size) {
+    void *ptr = counted_alloc(size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return counted_alloc(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return counted_alloc(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+    std::free(ptr);
+}
+#endif
+
+bool afv_native::util::allocationTrackingEnabled() {
+#ifdef AFV_NATIVE_TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint64_t afv_native::util::threadAllocationCount() {
+#ifdef AFV_NATIVE_TRACK_ALLOCATIONS
+    return tAllocationCount;
+#else
+    return 0;
+#endif
+}
+
+uint64_t afv_native::util::allocationViolations() {
+    return gAllocationViolations.load(std::memory_order_relaxed);
+}
+
+NoAllocationScope::NoAllocationScope(const char *where):
+    mWhere(where), mStartCount(threadAllocationCount()) {
+}
+
+NoAllocationScope::~NoAllocationScope() {
+#ifdef AFV_NATIVE_TRACK_ALLOCATIONS
+    const uint64_t count = allocations();
+    if (count > 0) {
+        gAllocationViolations.fetch_add(1, std::memory_order_relaxed);
+        LOG("AllocationTracker", "%s made %llu heap allocation(s) in a no-allocation scope",
+            mWhere, static_cast<unsigned long long>(count));
+        assert(count == 0 && "heap allocation in a no-allocation scope");
+    }
+#else
+    (void) mWhere;
+#endif
+}
+
+uint64_t NoAllocationScope::allocations() const {
+    return threadAllocationCount() - mStartCount;
+}
@@ -0,0 +1,149 @@
+#include "afv-native/util/WorkStealingPool.h"
+#include <cassert>
+
+using namespace afv_native::util;
+
+namespace {
+    const unsigned tagBits   = 24;
+    const unsigned indexBits = 20;
+    const uint64_t tagMask   = (uint64_t(1) << tagBits) - 1;
+    const uint64_t indexMask = (uint64_t(1) << indexBits) - 1;
+
+    inline uint64_t pack_range(uint32_t tag, size_t begin, size_t end) {
+        return (uint64_t(tag) << (2 * indexBits)) | (uint64_t(begin) << indexBits) | uint64_t(end);
+    }
+
+    inline uint32_t range_tag(uint64_t bounds) {
+        return static_cast<uint32_t>((bounds >> (2 * indexBits)) & tagMask);
+    }
+
+    inline size_t range_begin(uint64_t bounds) {
+        return static_cast<size_t>((bounds >> indexBits) & indexMask);
+    }
+
+    inline size_t range_end(uint64_t bounds) {
+        return static_cast<size_t>(bounds & indexMask);
+    }
+} // namespace
+
+WorkStealingPool::WorkStealingPool(unsigned threads, bool deterministic):
+    mDeterministic(deterministic), mThreads(), mRanges(new Range[threads + 1]), mJobLock(), mJobReady(), mJobGeneration(0), mJobFn(nullptr), mJobContext(nullptr), mStopping(false), mRemaining(0), mStolen(0) {
+    for (unsigned i = 0; i <= threads; i++) {
+        mRanges[i].bounds.store(0);
+    }
+    mThreads.reserve(threads);
+    for (unsigned i = 0; i < threads; i++) {
+        mThreads.emplace_back(&WorkStealingPool::worker_main, this, i + 1);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> jobGuard(mJobLock);
+        mStopping = true;
+    }
+    mJobReady.notify_all();
+    for (auto &thread: mThreads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::run(size_t count, TaskFn fn, void *context) {
+    if (count == 0) {
+        return;
+    }
+    if (mThreads.empty() || count == 1) {
+        for (size_t i = 0; i < count; i++) {
+            fn(context, i);
+        }
+        return;
+    }
+    assert(count <= indexMask && "too many iterations for one parallelFor");
+
+    const size_t participants = mThreads.size() + 1;
+    uint32_t     tag;
+    {
+        std::lock_guard<std::mutex> jobGuard(mJobLock);
+        mJobGeneration++;
+        tag         = static_cast<uint32_t>(mJobGeneration & tagMask);
+        mJobFn      = fn;
+        mJobContext = context;
+        mRemaining.store(count, std::memory_order_relaxed);
+        for (size_t p = 0; p < participants; p++) {
+            mRanges[p].bounds.store(pack_range(tag, p * count / participants, (p + 1) * count / participants),
+                                    std::memory_order_release);
+        }
+    }
+    mJobReady.notify_all();
+
+    execute(0, tag, fn, context);
+
+    // whatever's left is already running on a worker - it won't be long.
+    while (mRemaining.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+}
+
+void WorkStealingPool::worker_main(unsigned participant) {
+    uint64_t seenGeneration = 0;
+    for (;;) {
+        TaskFn   fn;
+        void    *context;
+        uint32_t tag;
+        {
+            std::unique_lock<std::mutex> jobGuard(mJobLock);
+            mJobReady.wait(jobGuard, [&] {
+                return mStopping || mJobGeneration != seenGeneration;
+            });
+            if (mStopping) {
+                return;
+            }
+            seenGeneration = mJobGeneration;
+            tag            = static_cast<uint32_t>(mJobGeneration & tagMask);
+            fn             = mJobFn;
+            context        = mJobContext;
+        }
+        execute(participant, tag, fn, context);
+    }
+}
+
+void WorkStealingPool::execute(unsigned participant, uint32_t tag, TaskFn fn, void *context) {
+    size_t index;
+    while (claim(participant, tag, false, index)) {
+        fn(context, index);
+        mRemaining.fetch_sub(1, std::memory_order_acq_rel);
+    }
+    if (mDeterministic) {
+        return;
+    }
+    const unsigned participants = static_cast<unsigned>(mThreads.size()) + 1;
+    for (unsigned offset = 1; offset < participants; offset++) {
+        const unsigned victim = (participant + offset) % participants;
+        while (claim(victim, tag, true, index)) {
+            fn(context, index);
+            mStolen.fetch_add(1, std::memory_order_relaxed);
+            mRemaining.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+}
+
+bool WorkStealingPool::claim(unsigned participant, uint32_t tag, bool fromBack, size_t &indexOut) {
+    auto    &bounds  = mRanges[participant].bounds;
+    uint64_t current = bounds.load(std::memory_order_acquire);
+    for (;;) {
+        if (range_tag(current) != tag) {
+            // a newer job has replaced this one.
+            return false;
+        }
+        const size_t begin = range_begin(current);
+        const size_t end   = range_end(current);
+        if (begin >= end) {
+            return false;
+        }
+        const uint64_t next = fromBack ? pack_range(tag, begin, end - 1) : pack_range(tag, begin + 1, end);
+        if (bounds.compare_exchange_weak(current, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            indexOut = fromBack ? end - 1 : begin;
+            return true;
+        }
+    }
+}